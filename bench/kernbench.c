@@ -0,0 +1,377 @@
+/*** kernbench.c -- time the set operation and sort kernels
+ *
+ * Copyright (C) 2013 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of rotz.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#if defined __x86_64__ || defined __i386__
+# include <x86intrin.h>
+#endif	/* x86 */
+
+#include "rotz.h"
+#include "rkern.h"
+#include "nifty.h"
+
+/* lookups are capped at this many needles per run */
+#define MAX_NEEDLES	(256U)
+
+#if defined __x86_64__ || defined __i386__
+# define TICK_UNIT	"cycles"
+
+static inline uint64_t
+tick(void)
+{
+	return __rdtsc();
+}
+#else  /* !x86 */
+# define TICK_UNIT	"ns"
+
+static inline uint64_t
+tick(void)
+{
+	struct timespec tsp;
+
+	clock_gettime(CLOCK_MONOTONIC, &tsp);
+	return tsp.tv_sec * 1000000000ULL + tsp.tv_nsec;
+}
+#endif	/* x86 */
+
+/* inputs for one point of the sweep */
+struct in_s {
+	size_t n;
+	rtz_vtx_t *a;
+	unsigned int *w;
+	size_t m;
+	rtz_vtx_t *b;
+	/* A and B as \nul-separated names */
+	rtz_buf_t an;
+	char **bn;
+	rtz_arena_t ar;
+};
+
+
+/* splitmix64, same as zipfgen */
+static uint64_t rstate;
+
+static uint64_t
+rnd(void)
+{
+	uint64_t z = (rstate += 0x9e3779b97f4a7c15ULL);
+
+	z = (z ^ (z >> 30U)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27U)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31U);
+}
+
+static void
+draw_ids(rtz_vtx_t *restrict tgt, size_t n, rtz_vtx_t *restrict pool, size_t np)
+{
+/* draw N distinct ids out of 1..NP, using POOL as scratch space */
+	for (size_t i = 0U; i < np; i++) {
+		pool[i] = i + 1U;
+	}
+	for (size_t i = 0U; i < n; i++) {
+		size_t j = i + rnd() % (np - i);
+		rtz_vtx_t x = pool[j];
+
+		pool[j] = pool[i];
+		tgt[i] = pool[i] = x;
+	}
+	return;
+}
+
+static void
+make_in(struct in_s *in, size_t n, size_t s)
+{
+/* A has N ids, B has N/S ids, both drawn from 1..2N,
+ * so about half of B is in A */
+	const size_t np = 2U * n;
+	rtz_vtx_t *pool = malloc(np * sizeof(*pool));
+	char *bp;
+
+	in->n = n;
+	in->m = n / s ?: 1U;
+	in->a = malloc(in->n * sizeof(*in->a));
+	in->b = malloc(in->m * sizeof(*in->b));
+	in->w = malloc(in->n * sizeof(*in->w));
+	draw_ids(in->a, in->n, pool, np);
+	draw_ids(in->b, in->m, pool, np);
+	for (size_t i = 0U; i < in->n; i++) {
+		in->w[i] = rnd() % (in->n / s + 1U);
+	}
+	free(pool);
+
+	/* names, tag:<id>\0 each */
+	in->an.d = bp = malloc(in->n * 24U);
+	for (size_t i = 0U; i < in->n; i++) {
+		bp += sprintf(bp, "tag:%ju", (uintmax_t)in->a[i]) + 1U;
+	}
+	in->an.z = bp - in->an.d;
+	in->bn = malloc(in->m * sizeof(*in->bn));
+	for (size_t i = 0U; i < in->m; i++) {
+		char *nm = malloc(24U);
+
+		sprintf(nm, "tag:%ju", (uintmax_t)in->b[i]);
+		in->bn[i] = nm;
+	}
+	return;
+}
+
+static void
+free_in(struct in_s *in)
+{
+	for (size_t i = 0U; i < in->m; i++) {
+		free(in->bn[i]);
+	}
+	free(in->bn);
+	free(in->an.d);
+	free(in->a);
+	free(in->b);
+	free(in->w);
+	return;
+}
+
+static size_t
+lst_cap(size_t z)
+{
+/* capacity implied by a list of size Z, see the set opers in rotz.c */
+	size_t c = 64U;
+
+	while (c < z) {
+		c *= 2U;
+	}
+	return c;
+}
+
+static rtz_vtx_t*
+copy_ids(rtz_arena_t ar, const rtz_vtx_t *d, size_t z)
+{
+	rtz_vtx_t *res = rotz_arena_alloc(ar, lst_cap(z) * sizeof(*res));
+
+	memcpy(res, d, z * sizeof(*res));
+	return res;
+}
+
+
+/* the kernels, each returns the ticks spent and the number of elements */
+static uint64_t
+k_find_in_vtxlst(const struct in_s *in, size_t *nel)
+{
+	const rtz_const_vtxlst_t el = {in->n, in->a};
+	const size_t nq = in->m < MAX_NEEDLES ? in->m : MAX_NEEDLES;
+	volatile size_t sink = 0U;
+	uint64_t t;
+
+	t = tick();
+	for (size_t i = 0U; i < nq; i++) {
+		sink += rtz_find_in_vtxlst(el, in->b[i]);
+	}
+	t = tick() - t;
+	*nel = nq * in->n;
+	return t;
+}
+
+static uint64_t
+k_find_in_buf(const struct in_s *in, size_t *nel)
+{
+	const rtz_const_buf_t b = {in->an.z, in->an.d};
+	const size_t nq = in->m < MAX_NEEDLES ? in->m : MAX_NEEDLES;
+	volatile const char *sink = NULL;
+	size_t lens[MAX_NEEDLES];
+	uint64_t t;
+
+	for (size_t i = 0U; i < nq; i++) {
+		lens[i] = strlen(in->bn[i]);
+	}
+	t = tick();
+	for (size_t i = 0U; i < nq; i++) {
+		sink = rtz_find_in_buf(b, in->bn[i], lens[i]);
+	}
+	t = tick() - t;
+	(void)sink;
+	*nel = nq * in->n;
+	return t;
+}
+
+static uint64_t
+k_vtxlst_union(const struct in_s *in, size_t *nel)
+{
+	rtz_vtxlst_t tgt = {in->n, copy_ids(in->ar, in->a, in->n)};
+	uint64_t t;
+
+	t = tick();
+	tgt = rtz_vtxlst_union(in->ar, tgt, (rtz_const_vtxlst_t){in->m, in->b});
+	t = tick() - t;
+	rotz_clear_arena(in->ar);
+	*nel = in->n + in->m;
+	return t;
+}
+
+static uint64_t
+k_wtxlst_union(const struct in_s *in, size_t *nel)
+{
+	rtz_wtxlst_t tgt = {
+		.z = in->n,
+		.d = copy_ids(in->ar, in->a, in->n),
+		.w = rotz_arena_alloc(in->ar, lst_cap(in->n) * sizeof(*tgt.w)),
+	};
+	uint64_t t;
+
+	memset(tgt.w, 0, in->n * sizeof(*tgt.w));
+	t = tick();
+	tgt = rtz_wtxlst_union(in->ar, tgt, (rtz_const_vtxlst_t){in->m, in->b});
+	t = tick() - t;
+	rotz_clear_arena(in->ar);
+	*nel = in->n + in->m;
+	return t;
+}
+
+static uint64_t
+k_vtxlst_intersection(const struct in_s *in, size_t *nel)
+{
+	rtz_vtxlst_t tgt = {in->n, copy_ids(in->ar, in->a, in->n)};
+	uint64_t t;
+
+	t = tick();
+	tgt = rtz_vtxlst_intersection(tgt, (rtz_const_vtxlst_t){in->m, in->b});
+	t = tick() - t;
+	rotz_clear_arena(in->ar);
+	*nel = in->n + in->m;
+	return t;
+}
+
+static uint64_t
+k_sort_wtxlst(const struct in_s *in, size_t *nel)
+{
+	rtz_wtxlst_t wl = {
+		.z = in->n,
+		.d = copy_ids(in->ar, in->a, in->n),
+		.w = rotz_arena_alloc(in->ar, in->n * sizeof(*wl.w)),
+	};
+	uint64_t t;
+
+	memcpy(wl.w, in->w, in->n * sizeof(*wl.w));
+	t = tick();
+	sort_wtxlst(wl);
+	t = tick() - t;
+	rotz_clear_arena(in->ar);
+	*nel = in->n;
+	return t;
+}
+
+static const struct {
+	const char *name;
+	uint64_t(*f)(const struct in_s*, size_t*);
+} kern[] = {
+	{"find_in_vtxlst", k_find_in_vtxlst},
+	{"find_in_buf", k_find_in_buf},
+	{"vtxlst_union", k_vtxlst_union},
+	{"wtxlst_union", k_wtxlst_union},
+	{"vtxlst_intersection", k_vtxlst_intersection},
+	{"sort_wtxlst", k_sort_wtxlst},
+};
+
+static int
+u64cmp(const void *x, const void *y)
+{
+	const uint64_t a = *(const uint64_t*)x;
+	const uint64_t b = *(const uint64_t*)y;
+	return (a > b) - (a < b);
+}
+
+
+#include "kernbench.yucc"
+
+int
+main(int argc, char *argv[])
+{
+	yuck_t argi[1U];
+	size_t maxn = 16384U;
+	size_t maxs = 64U;
+	size_t nrep = 5U;
+	uint64_t *ticks;
+	struct in_s in[1U];
+	int rc = 0;
+
+	if (yuck_parse(argi, argc, argv)) {
+		rc = 1;
+		goto out;
+	}
+	if (argi->max_size_arg) {
+		maxn = strtoul(argi->max_size_arg, NULL, 0);
+	}
+	if (argi->max_skew_arg) {
+		maxs = strtoul(argi->max_skew_arg, NULL, 0);
+	}
+	if (argi->repeat_arg) {
+		nrep = strtoul(argi->repeat_arg, NULL, 0) ?: 1U;
+	}
+	rstate = argi->seed_arg ? strtoull(argi->seed_arg, NULL, 0) : 1U;
+
+	ticks = malloc(nrep * sizeof(*ticks));
+	in->ar = rotz_make_arena();
+	printf("#kernel\tsize\tskew\t%s/elem\n", TICK_UNIT);
+	for (size_t n = 16U; n <= maxn; n *= 4U) {
+		for (size_t s = 1U; s <= maxs && s <= n; s *= 4U) {
+			make_in(in, n, s);
+			for (size_t k = 0U; k < countof(kern); k++) {
+				size_t nel = 0U;
+
+				for (size_t r = 0U; r < nrep; r++) {
+					ticks[r] = kern[k].f(in, &nel);
+				}
+				qsort(ticks, nrep, sizeof(*ticks), u64cmp);
+				printf("%s\t%zu\t%zu\t%.3f\n",
+				       kern[k].name, n, s,
+				       (double)ticks[nrep / 2U] / (double)(nel ?: 1U));
+			}
+			free_in(in);
+		}
+	}
+	rotz_free_arena(in->ar);
+	free(ticks);
+
+out:
+	yuck_free(argi);
+	return rc;
+}
+
+/* kernbench.c ends here */
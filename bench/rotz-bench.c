@@ -0,0 +1,506 @@
+/*** rotz-bench.c -- time rotz operations over a generated graph
+ *
+ * Copyright (C) 2013 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of rotz.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+
+#include "rotz.h"
+#include "rotz-cmd-api.h"
+#include "raux.h"
+#include "nifty.h"
+
+#if defined USE_LMDB
+# define BENCH_BACKEND	"lmdb"
+# define BENCH_DFLT_DB	"bench.mdb"
+#elif defined USE_TCBDB
+# define BENCH_BACKEND	"tcbdb"
+# define BENCH_DFLT_DB	"bench.tcb"
+#endif	/* USE_*DB */
+
+/* the input, tag and sym per association */
+static struct {
+	size_t n;
+	const char **tag;
+	const char **sym;
+	char *buf;
+} in;
+
+static const char *dbfile;
+static int nphases;
+
+static void
+rm_db(void)
+{
+	(void)unlink(dbfile);
+#if defined USE_LMDB
+	with (size_t z = strlen(dbfile)) {
+		char lck[z + sizeof("-lock")];
+
+		memcpy(lck, dbfile, z);
+		memcpy(lck + z, "-lock", sizeof("-lock"));
+		(void)unlink(lck);
+	}
+#endif	/* USE_LMDB */
+	return;
+}
+
+
+/* splitmix64, same as zipfgen */
+static uint64_t rstate;
+
+static uint64_t
+rnd(void)
+{
+	uint64_t z = (rstate += 0x9e3779b97f4a7c15ULL);
+
+	z = (z ^ (z >> 30U)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27U)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31U);
+}
+
+static inline size_t
+rnd_line(void)
+{
+/* random association, tags are therefore drawn by degree */
+	return rnd() % in.n;
+}
+
+static int
+read_input(const char *fn)
+{
+	FILE *fp;
+	size_t z = 0U;
+	size_t nl = 0U;
+	long fz;
+
+	if (UNLIKELY((fp = fopen(fn, "r")) == NULL)) {
+		return -1;
+	} else if (fseek(fp, 0L, SEEK_END) < 0 || (fz = ftell(fp)) < 0) {
+		goto err;
+	}
+	rewind(fp);
+	if (UNLIKELY((in.buf = malloc(fz + 1U)) == NULL)) {
+		goto err;
+	} else if (fread(in.buf, 1U, fz, fp) != (size_t)fz) {
+		goto err;
+	}
+	in.buf[fz] = '\0';
+	fclose(fp);
+
+	for (const char *p = in.buf; (p = strchr(p, '\n')) != NULL; p++) {
+		nl++;
+	}
+	in.tag = malloc((nl + 1U) * sizeof(*in.tag));
+	in.sym = malloc((nl + 1U) * sizeof(*in.sym));
+	for (char *p = in.buf, *eol; *p; p = eol) {
+		char *tab;
+
+		if ((eol = strchr(p, '\n')) != NULL) {
+			*eol++ = '\0';
+		} else {
+			eol = p + strlen(p);
+		}
+		if (UNLIKELY((tab = strchr(p, '\t')) == NULL)) {
+			continue;
+		}
+		*tab = '\0';
+		in.tag[z] = p;
+		in.sym[z] = tab + 1U;
+		z++;
+	}
+	in.n = z;
+	return 0;
+err:
+	fclose(fp);
+	return -1;
+}
+
+
+/* stop watch */
+struct phase_s {
+	const char *op;
+	size_t n;
+	uint64_t *lat;
+	uint64_t beg;
+	uint64_t last;
+};
+
+static uint64_t
+now_ns(void)
+{
+	struct timespec tsp;
+
+	clock_gettime(CLOCK_MONOTONIC, &tsp);
+	return tsp.tv_sec * 1000000000ULL + tsp.tv_nsec;
+}
+
+static void
+phase_beg(struct phase_s *p, const char *op, size_t n)
+{
+	p->op = op;
+	p->n = 0U;
+	p->lat = realloc(p->lat, (n ?: 1U) * sizeof(*p->lat));
+	p->beg = p->last = now_ns();
+	return;
+}
+
+static void
+phase_lap(struct phase_s *p)
+{
+	uint64_t now = now_ns();
+
+	p->lat[p->n++] = now - p->last;
+	p->last = now;
+	return;
+}
+
+static int
+u64cmp(const void *x, const void *y)
+{
+	const uint64_t a = *(const uint64_t*)x;
+	const uint64_t b = *(const uint64_t*)y;
+	return (a > b) - (a < b);
+}
+
+static void
+phase_end(struct phase_s *p)
+{
+/* print P as JSON object */
+	const double secs = (double)(p->last - p->beg) * 1e-9;
+	struct rusage ru;
+	struct stat st;
+	double p50 = 0.;
+	double p99 = 0.;
+
+	if (p->n) {
+		qsort(p->lat, p->n, sizeof(*p->lat), u64cmp);
+		p50 = (double)p->lat[p->n / 2U] * 1e-3;
+		p99 = (double)p->lat[p->n * 99U / 100U] * 1e-3;
+	}
+	getrusage(RUSAGE_SELF, &ru);
+	if (stat(dbfile, &st) < 0) {
+		st.st_size = 0;
+	}
+
+	printf("%s\t\t{\"op\": \"%s\", \"n\": %zu, \"secs\": %.6f, "
+	       "\"ops_per_sec\": %.1f, \"p50_us\": %.3f, \"p99_us\": %.3f, "
+	       "\"maxrss_kb\": %ld, \"db_bytes\": %lld}",
+	       nphases++ ? ",\n" : "",
+	       p->op, p->n, secs, secs > 0. ? (double)p->n / secs : 0.,
+	       p50, p99, ru.ru_maxrss, (long long)st.st_size);
+	return;
+}
+
+
+/* the phases */
+static void
+bench_add(rotz_t ctx, struct phase_s *p)
+{
+/* bulk add, committing every RTZ_BATCH_Z associations */
+	phase_beg(p, "add", in.n);
+	rotz_begin(ctx);
+	for (size_t i = 0U; i < in.n; i++) {
+		rtz_vtx_t t = rotz_add_vertex(ctx, rotz_tag(in.tag[i]));
+		rtz_vtx_t s = rotz_add_vertex(ctx, rotz_sym(in.sym[i]));
+
+		if (LIKELY(t && s)) {
+			rotz_add_edge(ctx, t, s);
+			rotz_add_edge(ctx, s, t);
+		}
+		if (UNLIKELY(!((i + 1U) % RTZ_BATCH_Z))) {
+			rotz_commit(ctx);
+			rotz_begin(ctx);
+		}
+		phase_lap(p);
+	}
+	rotz_commit(ctx);
+	p->last = now_ns();
+	phase_end(p);
+	return;
+}
+
+static void
+bench_show(rotz_t ctx, struct phase_s *p, rtz_arena_t ar, size_t nq)
+{
+/* resolve a tag, fetch its syms and their names */
+	static struct rtz_names_s nm[1U];
+
+	phase_beg(p, "show", nq);
+	for (size_t i = 0U; i < nq; i++) {
+		rtz_vtx_t t = rotz_get_vertex(ctx, rotz_tag(in.tag[rnd_line()]));
+		rtz_vtxlst_t el = rotz_get_edges_a(ctx, ar, t);
+
+		rotz_names(ctx, nm, el.d, el.z);
+		rotz_clear_arena(ar);
+		phase_lap(p);
+	}
+	phase_end(p);
+	rotz_names_free(nm);
+	return;
+}
+
+static void
+bench_isect(rotz_t ctx, struct phase_s *p, rtz_arena_t ar, size_t nq, size_t k)
+{
+	phase_beg(p, "intersection", nq);
+	for (size_t i = 0U; i < nq; i++) {
+		rtz_vtx_t t = rotz_get_vertex(ctx, rotz_tag(in.tag[rnd_line()]));
+		rtz_vtxlst_t r = rotz_get_edges_a(ctx, ar, t);
+
+		for (size_t j = 1U; j < k && r.z; j++) {
+			t = rotz_get_vertex(ctx, rotz_tag(in.tag[rnd_line()]));
+			r = rotz_intersection(ctx, r, t);
+		}
+		rotz_clear_arena(ar);
+		phase_lap(p);
+	}
+	phase_end(p);
+	return;
+}
+
+static void
+bench_munion(rotz_t ctx, struct phase_s *p, rtz_arena_t ar, size_t nq, size_t k)
+{
+	phase_beg(p, "munion", nq);
+	for (size_t i = 0U; i < nq; i++) {
+		rtz_wtxlst_t r = {0U};
+
+		for (size_t j = 0U; j < k; j++) {
+			rtz_vtx_t t =
+				rotz_get_vertex(ctx, rotz_tag(in.tag[rnd_line()]));
+			r = rotz_munion_a(ctx, ar, r, t);
+		}
+		sort_wtxlst(r);
+		rotz_clear_arena(ar);
+		phase_lap(p);
+	}
+	phase_end(p);
+	return;
+}
+
+struct cloud_clo_s {
+	rotz_t ctx;
+	size_t sum;
+};
+
+static int
+cloud_cb(rtz_vtx_t vid, const char *vtx, void *clo)
+{
+	struct cloud_clo_s *c = clo;
+
+	if (memcmp(vtx, RTZ_TAGSPC, sizeof(RTZ_TAGSPC) - 1U) == 0) {
+		c->sum += rotz_get_nedges(c->ctx, vid);
+	}
+	return 0;
+}
+
+static void
+bench_cloud(rotz_t ctx, struct phase_s *p, size_t nr)
+{
+/* degree of every tag, i.e. a full vertex scan */
+	phase_beg(p, "cloud", nr);
+	for (size_t i = 0U; i < nr; i++) {
+		struct cloud_clo_s c = {.ctx = ctx};
+
+		rotz_vtx_iter(ctx, cloud_cb, &c);
+		phase_lap(p);
+	}
+	phase_end(p);
+	return;
+}
+
+static int
+search_cb(rtz_const_buf_t key, rtz_const_buf_t val, void *clo)
+{
+	size_t *n = clo;
+
+	*n += key.z + val.z;
+	return 0;
+}
+
+static void
+bench_search(rotz_t ctx, struct phase_s *p, size_t nq)
+{
+/* prefix scans, tag names serving as prefixes */
+	phase_beg(p, "search", nq);
+	for (size_t i = 0U; i < nq; i++) {
+		const char *tag = rotz_tag(in.tag[rnd_line()]);
+		size_t n = 0U;
+
+		rotz_iter(ctx, (rtz_const_buf_t){strlen(tag), tag}, search_cb, &n);
+		phase_lap(p);
+	}
+	phase_end(p);
+	return;
+}
+
+static void
+bench_export(rotz_t ctx, struct phase_s *p, size_t nr)
+{
+	int fd;
+
+	if (UNLIKELY((fd = open("/dev/null", O_WRONLY)) < 0)) {
+		return;
+	}
+	phase_beg(p, "export", nr);
+	for (size_t i = 0U; i < nr; i++) {
+		rotz_export_binary(ctx, fd);
+		phase_lap(p);
+	}
+	phase_end(p);
+	close(fd);
+	return;
+}
+
+static void
+bench_del(rotz_t ctx, struct phase_s *p, size_t nq)
+{
+/* remove random associations, committing every RTZ_BATCH_Z */
+	phase_beg(p, "del", nq);
+	rotz_begin(ctx);
+	for (size_t i = 0U; i < nq; i++) {
+		const size_t l = rnd_line();
+		rtz_vtx_t t = rotz_get_vertex(ctx, rotz_tag(in.tag[l]));
+		rtz_vtx_t s = rotz_get_vertex(ctx, rotz_sym(in.sym[l]));
+
+		if (LIKELY(t && s)) {
+			rotz_rem_edge(ctx, t, s);
+			rotz_rem_edge(ctx, s, t);
+		}
+		if (UNLIKELY(!((i + 1U) % RTZ_BATCH_Z))) {
+			rotz_commit(ctx);
+			rotz_begin(ctx);
+		}
+		phase_lap(p);
+	}
+	rotz_commit(ctx);
+	p->last = now_ns();
+	phase_end(p);
+	return;
+}
+
+
+#include "rotz-bench.yucc"
+
+int
+main(int argc, char *argv[])
+{
+	yuck_t argi[1U];
+	struct phase_s p[1U] = {{NULL}};
+	size_t nq = 10000U;
+	size_t k = 3U;
+	size_t nr = 3U;
+	unsigned long long seed;
+	rtz_arena_t ar;
+	rotz_t ctx;
+	int rc = 0;
+
+	if (yuck_parse(argi, argc, argv)) {
+		rc = 1;
+		goto out;
+	} else if (argi->nargs != 1U) {
+		yuck_auto_help(argi);
+		rc = 1;
+		goto out;
+	}
+	if (argi->queries_arg) {
+		nq = strtoul(argi->queries_arg, NULL, 0);
+	}
+	if (argi->arity_arg) {
+		k = strtoul(argi->arity_arg, NULL, 0) ?: 1U;
+	}
+	if (argi->rounds_arg) {
+		nr = strtoul(argi->rounds_arg, NULL, 0);
+	}
+	seed = argi->seed_arg ? strtoull(argi->seed_arg, NULL, 0) : 1U;
+	rstate = seed;
+	dbfile = argi->database_arg ?: BENCH_DFLT_DB;
+
+	if (UNLIKELY(read_input(argi->args[0U]) < 0)) {
+		fprintf(stderr, "Error: cannot read `%s'\n", argi->args[0U]);
+		rc = 1;
+		goto out;
+	} else if (UNLIKELY(!in.n)) {
+		fputs("Error: no associations in input\n", stderr);
+		rc = 1;
+		goto out;
+	}
+	/* always start afresh */
+	rm_db();
+	if (UNLIKELY((ctx = make_rotz(dbfile, O_CREAT | O_RDWR)) == NULL)) {
+		fputs("Error opening rotz datastore\n", stderr);
+		rc = 1;
+		goto out;
+	}
+	ar = rotz_make_arena();
+
+	printf("{\n\t\"backend\": \"%s\",\n\t\"input\": \"%s\",\n"
+	       "\t\"associations\": %zu,\n\t\"seed\": %llu,\n\t\"phases\": [\n",
+	       BENCH_BACKEND, argi->args[0U], in.n, seed);
+	bench_add(ctx, p);
+	bench_show(ctx, p, ar, nq);
+	bench_isect(ctx, p, ar, nq, k);
+	bench_munion(ctx, p, ar, nq, k);
+	bench_cloud(ctx, p, nr);
+	bench_search(ctx, p, nq);
+	bench_export(ctx, p, nr);
+	bench_del(ctx, p, nq < in.n ? nq : in.n);
+	puts("\n\t]\n}");
+
+	rotz_free_arena(ar);
+	free_rotz(ctx);
+	rm_db();
+
+	free(p->lat);
+	free(in.tag);
+	free(in.sym);
+	free(in.buf);
+out:
+	yuck_free(argi);
+	return rc;
+}
+
+/* rotz-bench.c ends here */
@@ -0,0 +1,161 @@
+/*** zipfgen.c -- generate bipartite tag/sym graphs with skewed tag degrees
+ *
+ * Copyright (C) 2013 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of rotz.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <math.h>
+#include "nifty.h"
+
+
+/* splitmix64, so that runs are reproducible across libcs */
+static uint64_t rstate;
+
+static uint64_t
+rnd(void)
+{
+	uint64_t z = (rstate += 0x9e3779b97f4a7c15ULL);
+
+	z = (z ^ (z >> 30U)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27U)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31U);
+}
+
+static double
+rnd_unit(void)
+{
+/* uniform in [0, 1) */
+	return (double)(rnd() >> 11U) * 0x1p-53;
+}
+
+static double*
+make_cdf(size_t n, double alpha)
+{
+/* cumulative distribution of rank k ~ 1/k^ALPHA, k in [1, N] */
+	double *cdf;
+	double s = 0.;
+
+	if (UNLIKELY((cdf = malloc(n * sizeof(*cdf))) == NULL)) {
+		return NULL;
+	}
+	for (size_t k = 0U; k < n; k++) {
+		cdf[k] = s += pow((double)(k + 1U), -alpha);
+	}
+	for (size_t k = 0U; k < n; k++) {
+		cdf[k] /= s;
+	}
+	return cdf;
+}
+
+static size_t
+draw(const double *cdf, size_t n)
+{
+/* smallest k with CDF[k] > u */
+	const double u = rnd_unit();
+	size_t lo = 0U;
+	size_t hi = n - 1U;
+
+	while (lo < hi) {
+		size_t mid = (lo + hi) / 2U;
+
+		if (cdf[mid] > u) {
+			hi = mid;
+		} else {
+			lo = mid + 1U;
+		}
+	}
+	return lo;
+}
+
+
+#include "zipfgen.yucc"
+
+int
+main(int argc, char *argv[])
+{
+	yuck_t argi[1U];
+	size_t ntags = 1000U;
+	size_t nsyms = 100000U;
+	size_t nedges = 1000000U;
+	double alpha = 1.;
+	double *cdf;
+	int rc = 0;
+
+	if (yuck_parse(argi, argc, argv)) {
+		rc = 1;
+		goto out;
+	}
+	if (argi->tags_arg) {
+		ntags = strtoul(argi->tags_arg, NULL, 0);
+	}
+	if (argi->syms_arg) {
+		nsyms = strtoul(argi->syms_arg, NULL, 0);
+	}
+	if (argi->edges_arg) {
+		nedges = strtoul(argi->edges_arg, NULL, 0);
+	}
+	if (argi->alpha_arg) {
+		alpha = strtod(argi->alpha_arg, NULL);
+	}
+	rstate = argi->seed_arg ? strtoull(argi->seed_arg, NULL, 0) : 1U;
+
+	if (UNLIKELY(!ntags || !nsyms)) {
+		fputs("Error: need at least one tag and one sym\n", stderr);
+		rc = 1;
+		goto out;
+	} else if (UNLIKELY((cdf = make_cdf(ntags, alpha)) == NULL)) {
+		fputs("Error: cannot allocate tag distribution\n", stderr);
+		rc = 1;
+		goto out;
+	}
+
+	for (size_t i = 0U; i < nedges; i++) {
+		size_t t = draw(cdf, ntags);
+		size_t s = rnd() % nsyms;
+
+		printf("t%zu\ts%zu\n", t + 1U, s + 1U);
+	}
+	free(cdf);
+
+out:
+	yuck_free(argi);
+	return rc;
+}
+
+/* zipfgen.c ends here */
@@ -38,17 +38,28 @@
 # include "config.h"
 #endif	/* HAVE_CONFIG_H */
 
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
 #include "raux.h"
 #include "nifty.h"
 
-
+/* lists up to this size are Shell-sorted */
+#define TINY_Z		(256U)
+/* lists from this size on are worth splitting across threads */
+#define PAR_Z		(1U << 20U)
+/* weights up to this are counting-sorted in one pass no matter what */
+#define CNT_MAX		(65536U)
+
+
 static inline void
-shsort_gap(rtz_wtxlst_t wl, unsigned int gap)
+shsort_gap(rtz_wtxlst_t wl, size_t gap)
 {
 	for (size_t i = gap; i < wl.z; i++) {
 		unsigned int wi = wl.w[i];
-		unsigned int di = wl.d[i];
-		unsigned int j;
+		rtz_vtx_t di = wl.d[i];
+		size_t j;
 
 		for (j = i; j >= gap && wi > wl.w[j - gap]; j -= gap) {
 			wl.w[j] = wl.w[j - gap];
@@ -60,20 +71,19 @@ shsort_gap(rtz_wtxlst_t wl, unsigned int gap)
 	return;
 }
 
-void
-sort_wtxlst(rtz_wtxlst_t wl)
+static void
+shsort(rtz_wtxlst_t wl)
 {
 /* simple shell sort with Ciura's gap sequence */
 	static const unsigned int gaps[] = {
 		701U, 301U, 132U, 57U, 23U, 10U, 4U, 1U
 	};
-	unsigned int h = gaps[0];
+	size_t h = gaps[0];
 
 	/* extending the gap sequence by h_k <- 2.25h_{k-1} */
-	for (unsigned int nx;
-	     (nx = (unsigned int)(2.25 * (float)h)) < wl.z; h = nx);
+	for (size_t nx; (nx = (size_t)(2.25 * (double)h)) < wl.z; h = nx);
 	/* first go through the extended list */
-	for (; h > gaps[0]; h = (unsigned int)((float)h / 2.25)) {
+	for (; h > gaps[0]; h = (size_t)((double)h / 2.25)) {
 		shsort_gap(wl, h);
 	}
 	/* then resort to Ciura's list */
@@ -83,4 +93,236 @@ sort_wtxlst(rtz_wtxlst_t wl)
 	return;
 }
 
+
+/* counting sorts
+ * Entries are keyed by MAXW - W so that heavy ones come first.  Small key
+ * ranges are sorted in one counting pass, wide ones by radix passes over
+ * 8-bit digits of the key.  Every pass is stable, i.e. entries of equal
+ * weight stay in list order.  In the parallel variant every thread counts
+ * and scatters its own slice, the offsets are laid out thread by thread
+ * within every bucket, which keeps things stable. */
+struct pass_s {
+	/* source and destination */
+	const rtz_vtx_t *sd;
+	const unsigned int *sw;
+	rtz_vtx_t *dd;
+	unsigned int *dw;
+	/* our slice */
+	size_t from;
+	size_t till;
+	/* key is ((MAXW - w) >> SHIFT) & MASK */
+	unsigned int maxw;
+	unsigned int shift;
+	unsigned int mask;
+	/* per-bucket counts, then offsets */
+	size_t *cnt;
+	pthread_t th;
+	int joinp;
+};
+
+static inline unsigned int
+pass_key(const struct pass_s *p, unsigned int w)
+{
+	return ((p->maxw - w) >> p->shift) & p->mask;
+}
+
+static void*
+pass_count(void *clo)
+{
+	struct pass_s *p = clo;
+
+	for (size_t i = p->from; i < p->till; i++) {
+		p->cnt[pass_key(p, p->sw[i])]++;
+	}
+	return NULL;
+}
+
+static void*
+pass_scatter(void *clo)
+{
+	struct pass_s *p = clo;
+
+	for (size_t i = p->from; i < p->till; i++) {
+		const size_t o = p->cnt[pass_key(p, p->sw[i])]++;
+
+		p->dd[o] = p->sd[i];
+		p->dw[o] = p->sw[i];
+	}
+	return NULL;
+}
+
+static void
+pass_run(struct pass_s *p, unsigned int nt, void*(*fn)(void*))
+{
+	for (unsigned int t = 1U; t < nt; t++) {
+		p[t].joinp = !pthread_create(&p[t].th, NULL, fn, p + t);
+	}
+	/* do our share */
+	fn(p);
+	for (unsigned int t = 1U; t < nt; t++) {
+		if (LIKELY(p[t].joinp)) {
+			pthread_join(p[t].th, NULL);
+		} else {
+			/* thread creation failed, do it ourselves */
+			fn(p + t);
+		}
+	}
+	return;
+}
+
+static int
+csort(rtz_wtxlst_t wl, unsigned int nt)
+{
+	const size_t z = wl.z;
+	unsigned int maxw = 0U;
+	/* bits per pass and number of buckets */
+	unsigned int nb, b;
+	rtz_vtx_t *td;
+	unsigned int *tw;
+	size_t *cnt;
+	struct pass_s *p;
+	rtz_wtxlst_t src = wl, dst;
+
+	for (size_t i = 0U; i < z; i++) {
+		maxw = wl.w[i] > maxw ? wl.w[i] : maxw;
+	}
+	if (maxw < CNT_MAX || maxw < z) {
+		/* one pass over the whole key */
+		b = 32U;
+		nb = maxw + 1U;
+	} else {
+		b = 8U;
+		nb = 1U << b;
+	}
+	if (nt > z / PAR_Z) {
+		nt = z / PAR_Z ?: 1U;
+	}
+	td = malloc(z * sizeof(*td));
+	tw = malloc(z * sizeof(*tw));
+	cnt = malloc(nt * nb * sizeof(*cnt));
+	p = malloc(nt * sizeof(*p));
+	if (UNLIKELY(td == NULL || tw == NULL || cnt == NULL || p == NULL)) {
+		free(td);
+		free(tw);
+		free(cnt);
+		free(p);
+		return -1;
+	}
+	dst = (rtz_wtxlst_t){z, td, tw};
+
+	for (unsigned int s = 0U; s < 32U && maxw >> s; s += b) {
+		for (unsigned int t = 0U; t < nt; t++) {
+			p[t] = (struct pass_s){
+				.sd = src.d, .sw = src.w,
+				.dd = dst.d, .dw = dst.w,
+				.from = z * t / nt, .till = z * (t + 1U) / nt,
+				.maxw = maxw, .shift = s,
+				.mask = b < 32U ? nb - 1U : ~0U,
+				.cnt = cnt + t * nb,
+			};
+		}
+		memset(cnt, 0, nt * nb * sizeof(*cnt));
+		pass_run(p, nt, pass_count);
+		/* bucket-major, thread-minor offsets */
+		with (size_t o = 0U) {
+			for (unsigned int k = 0U; k < nb; k++) {
+				for (unsigned int t = 0U; t < nt; t++) {
+					const size_t c = p[t].cnt[k];
+
+					p[t].cnt[k] = o;
+					o += c;
+				}
+			}
+		}
+		pass_run(p, nt, pass_scatter);
+		/* swap roles */
+		with (rtz_wtxlst_t tmp = src) {
+			src = dst;
+			dst = tmp;
+		}
+	}
+	if (src.d != wl.d) {
+		memcpy(wl.d, src.d, z * sizeof(*wl.d));
+		memcpy(wl.w, src.w, z * sizeof(*wl.w));
+	}
+	free(td);
+	free(tw);
+	free(cnt);
+	free(p);
+	return 0;
+}
+
+
+void
+sort_wtxlst_mt(rtz_wtxlst_t wl, unsigned int nthreads)
+{
+	if (wl.z <= TINY_Z || UNLIKELY(csort(wl, nthreads ?: 1U) < 0)) {
+		shsort(wl);
+	}
+	return;
+}
+
+void
+sort_wtxlst(rtz_wtxlst_t wl)
+{
+	sort_wtxlst_mt(wl, 1U);
+	return;
+}
+
+size_t
+top_wtxlst(rtz_wtxlst_t wl, size_t n)
+{
+/* find the weight T of the Nth heaviest entry, move the N heaviest ones,
+ * in list order, to the front and sort only those */
+	unsigned int maxw = 0U;
+	size_t *cnt;
+	size_t nabove = 0U;
+	unsigned int t;
+
+	if (n >= wl.z || wl.z <= TINY_Z) {
+		sort_wtxlst(wl);
+		return n < wl.z ? n : wl.z;
+	} else if (UNLIKELY(!n)) {
+		return 0U;
+	}
+	for (size_t i = 0U; i < wl.z; i++) {
+		maxw = wl.w[i] > maxw ? wl.w[i] : maxw;
+	}
+	if ((maxw >= CNT_MAX && maxw >= wl.z) ||
+	    (cnt = calloc(maxw + 1U, sizeof(*cnt))) == NULL) {
+		/* weights too spread out to be counted */
+		sort_wtxlst(wl);
+		return n;
+	}
+	for (size_t i = 0U; i < wl.z; i++) {
+		cnt[wl.w[i]]++;
+	}
+	for (t = maxw; nabove + cnt[t] < n; nabove += cnt[t--]);
+	free(cnt);
+
+	/* stable partition, N - NABOVE entries of weight T make it */
+	with (size_t j = 0U, neq = n - nabove) {
+		for (size_t i = 0U; j < n; i++) {
+			const rtz_vtx_t d = wl.d[i];
+			const unsigned int w = wl.w[i];
+
+			if (w < t || (w == t && !neq)) {
+				continue;
+			} else if (w == t) {
+				neq--;
+			}
+			wl.d[i] = wl.d[j];
+			wl.w[i] = wl.w[j];
+			wl.d[j] = d;
+			wl.w[j] = w;
+			j++;
+		}
+	}
+	wl.z = n;
+	if (UNLIKELY(csort(wl, 1U) < 0)) {
+		shsort(wl);
+	}
+	return n;
+}
+
 /* raux.c ends here */
@@ -40,7 +40,20 @@
 #include "rotz.h"
 
 /**
- * Sort the entries by their weight (descending). */
+ * Sort the entries by their weight (descending).
+ * Small lists are Shell-sorted, anything larger is counting-sorted which
+ * keeps entries of equal weight in list order. */
 extern void sort_wtxlst(rtz_wtxlst_t);
 
+/**
+ * Like `sort_wtxlst()' but very large lists are sorted by NTHREADS
+ * threads. */
+extern void sort_wtxlst_mt(rtz_wtxlst_t, unsigned int nthreads);
+
+/**
+ * Move the N heaviest entries to the front, sorted by their weight
+ * (descending), the order of the rest is unspecified.
+ * Return the number of entries moved, N or the size of the list. */
+extern size_t top_wtxlst(rtz_wtxlst_t, size_t n);
+
 #endif	/* INCLUDED_raux_h_ */
@@ -0,0 +1,1161 @@
+/*** rgraph.c -- graph traversals over rotz databases
+ *
+ * Copyright (C) 2013 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of rotz.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "rgraph.h"
+#include "nifty.h"
+
+/* number of vertices in a chunk of the edge scan */
+#define CHUNK_Z		(65536U)
+
+/* two handles packed into one integer, the first one in the high half */
+#if defined WITH_WIDE_IDS
+typedef unsigned __int128 rtz_pair_t;
+# define RTZ_PAIR_SHIFT	(64U)
+#else  /* !WITH_WIDE_IDS */
+typedef uint64_t rtz_pair_t;
+# define RTZ_PAIR_SHIFT	(32U)
+#endif	/* WITH_WIDE_IDS */
+
+
+static inline int
+bm_tas(uint64_t *bm, rtz_vtx_t v)
+{
+/* set bit V in BM and return its previous state */
+	const uint64_t m = 1ULL << (v % 64U);
+
+	return (__atomic_fetch_or(bm + v / 64U, m, __ATOMIC_RELAXED) & m) != 0U;
+}
+
+static inline int
+bm_get(const uint64_t *bm, rtz_vtx_t v)
+{
+	return (bm[v / 64U] >> (v % 64U)) & 1U;
+}
+
+
+/* k-hop neighbourhoods */
+struct reach_s {
+	rotz_t ctx;
+	pthread_mutex_t *mtx;
+	uint64_t *vis;
+	rtz_vtx_t maxid;
+
+	/* our slice of the frontier */
+	const rtz_vtx_t *fr;
+	size_t nfr;
+
+	/* vertices discovered by us */
+	rtz_vtx_t *nx;
+	size_t nnx;
+	size_t znx;
+	/* set when NX couldn't be grown */
+	int oom;
+
+	pthread_t th;
+	int joinp;
+};
+
+static void*
+expand(void *clo)
+{
+	struct reach_s *r = clo;
+
+	for (size_t i = 0U; i < r->nfr; i++) {
+		rtz_vtxlst_t el;
+
+		/* the rotz handle isn't reentrant */
+		pthread_mutex_lock(r->mtx);
+		el = rotz_get_edges(r->ctx, r->fr[i]);
+		pthread_mutex_unlock(r->mtx);
+
+		for (size_t j = 0U; j < el.z; j++) {
+			const rtz_vtx_t w = el.d[j];
+
+			if (UNLIKELY(w > r->maxid) || bm_tas(r->vis, w)) {
+				/* seen already */
+				continue;
+			} else if (UNLIKELY(r->nnx >= r->znx)) {
+				const size_t nuz = (r->nnx / 64U + 1U) * 64U;
+				rtz_vtx_t *nu;
+
+				nu = realloc(r->nx, nuz * sizeof(*r->nx));
+				if (UNLIKELY(nu == NULL)) {
+					r->oom = -1;
+					rotz_free_vtxlst(el);
+					return NULL;
+				}
+				r->nx = nu;
+				r->znx = nuz;
+			}
+			r->nx[r->nnx++] = w;
+		}
+		rotz_free_vtxlst(el);
+	}
+	return NULL;
+}
+
+rtz_vtxlst_t
+rotz_reach(
+	rotz_t ctx, const rtz_vtx_t v[], size_t n,
+	unsigned int hops, unsigned int nthreads)
+{
+	pthread_mutex_t mtx = PTHREAD_MUTEX_INITIALIZER;
+	const rtz_vtx_t maxid = rotz_get_maxid(ctx);
+	rtz_vtxlst_t res = {0U};
+	struct reach_s *r;
+	uint64_t *vis;
+	rtz_vtx_t *fr;
+	size_t nfr = 0U;
+
+	if (UNLIKELY(!maxid)) {
+		return res;
+	} else if (UNLIKELY(!nthreads)) {
+		nthreads = 1U;
+	}
+	vis = calloc(maxid / 64U + 1U, sizeof(*vis));
+	r = calloc(nthreads, sizeof(*r));
+	fr = malloc((n + 1U) * sizeof(*fr));
+	if (UNLIKELY(vis == NULL || r == NULL || fr == NULL)) {
+		goto oom;
+	}
+
+	/* seed the frontier */
+	for (size_t i = 0U; i < n; i++) {
+		if (v[i] && v[i] <= maxid && !bm_tas(vis, v[i])) {
+			fr[nfr++] = v[i];
+		}
+	}
+	for (unsigned int h = 0U; h < hops && nfr > 0U; h++) {
+		const size_t per = (nfr - 1U) / nthreads + 1U;
+		unsigned int nt = 0U;
+		size_t nnu = 0U;
+
+		/* hand out slices of the frontier */
+		for (size_t o = 0U; o < nfr; o += per, nt++) {
+			r[nt].ctx = ctx;
+			r[nt].mtx = &mtx;
+			r[nt].vis = vis;
+			r[nt].maxid = maxid;
+			r[nt].fr = fr + o;
+			r[nt].nfr = nfr - o < per ? nfr - o : per;
+			r[nt].nnx = 0U;
+			r[nt].oom = 0;
+			r[nt].joinp = 0;
+		}
+		for (unsigned int t = 1U; t < nt; t++) {
+			r[t].joinp = !pthread_create(&r[t].th, NULL, expand, r + t);
+		}
+		/* do our share */
+		expand(r);
+		for (unsigned int t = 1U; t < nt; t++) {
+			if (LIKELY(r[t].joinp)) {
+				pthread_join(r[t].th, NULL);
+			} else {
+				/* thread creation failed, do it ourselves */
+				expand(r + t);
+			}
+			nnu += r[t].nnx;
+		}
+		nnu += r->nnx;
+		for (unsigned int t = 0U; t < nt; t++) {
+			if (UNLIKELY(r[t].oom)) {
+				goto oom;
+			}
+		}
+
+		/* the new frontier is also part of the result */
+		with (rtz_vtx_t *nu = realloc(fr, (nnu + 1U) * sizeof(*fr))) {
+			if (UNLIKELY(nu == NULL)) {
+				goto oom;
+			}
+			fr = nu;
+		}
+		nfr = 0U;
+		for (unsigned int t = 0U; t < nt; t++) {
+			memcpy(fr + nfr, r[t].nx, r[t].nnx * sizeof(*fr));
+			nfr += r[t].nnx;
+		}
+		with (rtz_vtx_t *nu) {
+			nu = realloc(res.d, (res.z + nfr + 1U) * sizeof(*res.d));
+			if (UNLIKELY(nu == NULL)) {
+				goto oom;
+			}
+			res.d = nu;
+		}
+		memcpy(res.d + res.z, fr, nfr * sizeof(*fr));
+		res.z += nfr;
+	}
+
+out:
+	if (r != NULL) {
+		for (unsigned int t = 0U; t < nthreads; t++) {
+			if (r[t].nx != NULL) {
+				free(r[t].nx);
+			}
+		}
+		free(r);
+	}
+	if (fr != NULL) {
+		free(fr);
+	}
+	if (vis != NULL) {
+		free(vis);
+	}
+	pthread_mutex_destroy(&mtx);
+	return res;
+
+oom:
+	/* partial results are no results */
+	if (res.d != NULL) {
+		free(res.d);
+	}
+	res = (rtz_vtxlst_t){0U};
+	goto out;
+}
+
+
+/* chunked edge scans
+ * The edge iterator is driven by a single producer, the adjacency lists
+ * are packed into chunks and handed to worker threads through a bounded
+ * queue.  Each worker has its own closure. */
+struct chunk_s {
+	size_t z;
+	size_t n;
+	/* sequence of SRC, NTGT, TGT...
+	 * adjacency lists are never split across chunks */
+	rtz_vtx_t d[];
+};
+
+typedef void(*chunk_f)(const struct chunk_s*, void*);
+
+struct scan_s {
+	pthread_mutex_t mtx;
+	pthread_cond_t nonempty;
+	pthread_cond_t nonfull;
+	struct chunk_s **q;
+	size_t qz;
+	size_t head;
+	size_t n;
+	int donep;
+
+	rtz_vtx_t maxid;
+	/* only consider sources in here, if non-NULL */
+	const uint64_t *srcs;
+	chunk_f work;
+	/* closure for the inline worker */
+	void *clo;
+	/* the chunk currently being filled by the producer */
+	struct chunk_s *cur;
+	/* set when a chunk couldn't be had */
+	int oom;
+};
+
+struct worker_s {
+	struct scan_s *q;
+	void *clo;
+	pthread_t th;
+};
+
+static void
+scan_push(struct scan_s *q, struct chunk_s *c)
+{
+	pthread_mutex_lock(&q->mtx);
+	while (q->n >= q->qz) {
+		pthread_cond_wait(&q->nonfull, &q->mtx);
+	}
+	q->q[(q->head + q->n++) % q->qz] = c;
+	pthread_cond_signal(&q->nonempty);
+	pthread_mutex_unlock(&q->mtx);
+	return;
+}
+
+static struct chunk_s*
+scan_pop(struct scan_s *q)
+{
+	struct chunk_s *c = NULL;
+
+	pthread_mutex_lock(&q->mtx);
+	while (!q->n && !q->donep) {
+		pthread_cond_wait(&q->nonempty, &q->mtx);
+	}
+	if (q->n) {
+		c = q->q[q->head];
+		q->head = (q->head + 1U) % q->qz;
+		q->n--;
+		pthread_cond_signal(&q->nonfull);
+	}
+	pthread_mutex_unlock(&q->mtx);
+	return c;
+}
+
+static struct chunk_s*
+make_chunk(size_t z)
+{
+	struct chunk_s *res = malloc(sizeof(*res) + z * sizeof(*res->d));
+
+	if (UNLIKELY(res == NULL)) {
+		return NULL;
+	}
+	res->z = z;
+	res->n = 0U;
+	return res;
+}
+
+static void*
+scan_worker(void *clo)
+{
+	struct worker_s *w = clo;
+
+	for (struct chunk_s *c; (c = scan_pop(w->q)) != NULL; free(c)) {
+		w->q->work(c, w->clo);
+	}
+	return NULL;
+}
+
+static void
+scan_flush(struct scan_s *q, struct chunk_s *c)
+{
+	if (UNLIKELY(!c->n)) {
+		/* nothing to do */
+		;
+	} else if (q->q != NULL) {
+		scan_push(q, c);
+		return;
+	} else {
+		/* no workers, do it ourselves */
+		q->work(c, q->clo);
+	}
+	free(c);
+	return;
+}
+
+static int
+scan_edg_cb(rtz_vtx_t vid, rtz_const_vtxlst_t vl, void *clo)
+{
+	struct scan_s *q = clo;
+	struct chunk_s *c;
+	size_t cnt;
+
+	if (UNLIKELY(vid > q->maxid)) {
+		return 0;
+	} else if (q->srcs != NULL && !bm_get(q->srcs, vid)) {
+		return 0;
+	} else if (UNLIKELY(!vl.z)) {
+		return 0;
+	} else if (UNLIKELY(vl.z + 2U > CHUNK_Z)) {
+		/* oversized list, gets a chunk of its own */
+		if (UNLIKELY((c = make_chunk(vl.z + 2U)) == NULL)) {
+			goto oom;
+		}
+	} else if (q->cur->n + vl.z + 2U > q->cur->z) {
+		/* no room at the inn, pass it on */
+		if (UNLIKELY((c = make_chunk(CHUNK_Z)) == NULL)) {
+			goto oom;
+		}
+		scan_flush(q, q->cur);
+		q->cur = c;
+	} else {
+		c = q->cur;
+	}
+	c->d[c->n++] = vid;
+	cnt = c->n++;
+	c->d[cnt] = 0U;
+	for (size_t i = 0U; i < vl.z; i++) {
+		if (LIKELY(vl.d[i] <= q->maxid)) {
+			c->d[c->n++] = vl.d[i];
+			c->d[cnt]++;
+		}
+	}
+	if (UNLIKELY(c != q->cur)) {
+		scan_flush(q, c);
+	}
+	return 0;
+oom:
+	/* stop the iteration */
+	q->oom = -1;
+	return -1;
+}
+
+static int
+scan_edges(
+	rotz_t ctx, rtz_vtx_t maxid, const uint64_t *srcs,
+	chunk_f work, void *clo[], unsigned int nthreads)
+{
+/* call WORK on chunks of the adjacency lists of vertices in SRCS,
+ * or of all vertices if SRCS is NULL, using NTHREADS workers,
+ * return -1 if not all chunks could be handed out */
+	struct scan_s q = {
+		.mtx = PTHREAD_MUTEX_INITIALIZER,
+		.nonempty = PTHREAD_COND_INITIALIZER,
+		.nonfull = PTHREAD_COND_INITIALIZER,
+		.maxid = maxid,
+		.srcs = srcs,
+		.work = work,
+		.clo = clo[0U],
+	};
+	struct worker_s *w = NULL;
+	unsigned int nw = 0U;
+
+	if (UNLIKELY((q.cur = make_chunk(CHUNK_Z)) == NULL)) {
+		return -1;
+	} else if (nthreads > 1U) {
+		q.qz = 2U * nthreads;
+		q.q = malloc(q.qz * sizeof(*q.q));
+		w = malloc(nthreads * sizeof(*w));
+	}
+	if (UNLIKELY(q.q == NULL || w == NULL)) {
+		/* no workers */
+		;
+	} else {
+		for (unsigned int t = 0U; t < nthreads; t++) {
+			w[nw].q = &q;
+			w[nw].clo = clo[nw];
+			if (LIKELY(!pthread_create(
+					   &w[nw].th, NULL, scan_worker, w + nw))) {
+				nw++;
+			}
+		}
+	}
+	if (UNLIKELY(!nw && q.q != NULL)) {
+		/* go single-threaded then */
+		free(q.q);
+		q.q = NULL;
+	}
+
+	/* scan edges, feeding the workers if any */
+	rotz_edg_iter(ctx, scan_edg_cb, &q);
+	/* pass on the last chunk */
+	scan_flush(&q, q.cur);
+
+	if (q.q != NULL) {
+		/* wait for the workers */
+		pthread_mutex_lock(&q.mtx);
+		q.donep = 1;
+		pthread_cond_broadcast(&q.nonempty);
+		pthread_mutex_unlock(&q.mtx);
+		for (unsigned int t = 0U; t < nw; t++) {
+			pthread_join(w[t].th, NULL);
+		}
+		free(q.q);
+	}
+	if (w != NULL) {
+		free(w);
+	}
+	pthread_cond_destroy(&q.nonfull);
+	pthread_cond_destroy(&q.nonempty);
+	pthread_mutex_destroy(&q.mtx);
+	return q.oom;
+}
+
+
+/* connected components */
+static rtz_vtx_t
+uf_find(rtz_vtx_t *p, rtz_vtx_t x)
+{
+	rtz_vtx_t q;
+
+	while ((q = __atomic_load_n(p + x, __ATOMIC_RELAXED)) != x) {
+		rtz_vtx_t g = __atomic_load_n(p + q, __ATOMIC_RELAXED);
+
+		/* path halving, parents only ever decrease so it doesn't
+		 * matter if someone else got there first */
+		if (g != q) {
+			__atomic_compare_exchange_n(
+				p + x, &q, g, 0,
+				__ATOMIC_RELAXED, __ATOMIC_RELAXED);
+		}
+		x = g;
+	}
+	return x;
+}
+
+static void
+uf_unite(rtz_vtx_t *p, rtz_vtx_t a, rtz_vtx_t b)
+{
+	for (;;) {
+		rtz_vtx_t x;
+
+		if ((a = uf_find(p, a)) == (b = uf_find(p, b))) {
+			return;
+		} else if (a < b) {
+			x = a, a = b, b = x;
+		}
+		/* link the larger root below the smaller one */
+		x = a;
+		if (__atomic_compare_exchange_n(
+			    p + a, &x, b, 0,
+			    __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+			return;
+		}
+	}
+}
+
+static void
+unite_chunk(const struct chunk_s *c, void *clo)
+{
+	rtz_vtx_t *p = clo;
+
+	for (size_t i = 0U; i < c->n;) {
+		const rtz_vtx_t src = c->d[i++];
+		const rtz_vtx_t ntgt = c->d[i++];
+
+		for (const rtz_vtx_t *tp = c->d + i, *const ep = tp + ntgt;
+		     tp < ep; tp++) {
+			uf_unite(p, src, *tp);
+		}
+		i += ntgt;
+	}
+	return;
+}
+
+static int
+bm_vtx_cb(rtz_vtx_t vid, const char *UNUSED(vtx), void *clo)
+{
+	uint64_t *ex = clo;
+
+	bm_tas(ex, vid);
+	return 0;
+}
+
+rtz_vtxlst_t
+rotz_components(rotz_t ctx, unsigned int nthreads)
+{
+	const rtz_vtx_t maxid = rotz_get_maxid(ctx);
+	uint64_t *ex;
+	void **clo;
+	rtz_vtxlst_t res;
+	int rc;
+
+	if (UNLIKELY(!maxid)) {
+		return (rtz_vtxlst_t){0U};
+	} else if (UNLIKELY(!nthreads)) {
+		nthreads = 1U;
+	}
+	/* everyone's their own component */
+	res.z = maxid + 1U;
+	if (UNLIKELY((res.d = malloc(res.z * sizeof(*res.d))) == NULL)) {
+		return (rtz_vtxlst_t){0U};
+	}
+	for (rtz_vtx_t v = 0U; v <= maxid; v++) {
+		res.d[v] = v;
+	}
+
+	/* all workers share the one forest */
+	if (UNLIKELY((clo = malloc(nthreads * sizeof(*clo))) == NULL)) {
+		goto oom;
+	}
+	for (unsigned int t = 0U; t < nthreads; t++) {
+		clo[t] = res.d;
+	}
+	rc = scan_edges(ctx, maxid, NULL, unite_chunk, clo, nthreads);
+	free(clo);
+	if (UNLIKELY(rc < 0)) {
+		goto oom;
+	}
+
+	/* flatten, parents are smaller than their children so
+	 * ascending order suffices */
+	for (rtz_vtx_t v = 1U; v <= maxid; v++) {
+		res.d[v] = res.d[res.d[v]];
+	}
+
+	/* vertices that don't exist (anymore) go to 0 */
+	if (UNLIKELY((ex = calloc(maxid / 64U + 1U, sizeof(*ex))) == NULL)) {
+		goto oom;
+	}
+	rotz_vtx_iter(ctx, bm_vtx_cb, ex);
+	for (rtz_vtx_t v = 0U; v <= maxid; v++) {
+		if (!bm_get(ex, v)) {
+			res.d[v] = 0U;
+		}
+	}
+	free(ex);
+	return res;
+
+oom:
+	free(res.d);
+	return (rtz_vtxlst_t){0U};
+}
+
+
+/* one-mode projections */
+struct ptab_s {
+	size_t z;
+	size_t n;
+	rtz_pair_t *k;
+	unsigned int *w;
+	/* set when the table couldn't be grown */
+	int oom;
+};
+
+static inline size_t
+ptab_hash(rtz_pair_t p)
+{
+	uint64_t k = (uint64_t)p;
+
+#if defined WITH_WIDE_IDS
+	k ^= (uint64_t)(p >> RTZ_PAIR_SHIFT) * 0x9e3779b97f4a7c15ULL;
+#endif	/* WITH_WIDE_IDS */
+	/* murmur3's finaliser */
+	k ^= k >> 33U;
+	k *= 0xff51afd7ed558ccdULL;
+	k ^= k >> 33U;
+	k *= 0xc4ceb9fe1a85ec53ULL;
+	k ^= k >> 33U;
+	return (size_t)k;
+}
+
+static int ptab_add(struct ptab_s *t, rtz_pair_t k, unsigned int w);
+
+static int
+ptab_grow(struct ptab_s *t)
+{
+	struct ptab_s old = *t;
+
+	t->z = old.z ? 2U * old.z : 1024U;
+	t->n = 0U;
+	t->k = calloc(t->z, sizeof(*t->k));
+	t->w = calloc(t->z, sizeof(*t->w));
+	if (UNLIKELY(t->k == NULL || t->w == NULL)) {
+		/* leave the old table in place */
+		if (t->k != NULL) {
+			free(t->k);
+		}
+		if (t->w != NULL) {
+			free(t->w);
+		}
+		*t = old;
+		t->oom = -1;
+		return -1;
+	}
+	for (size_t i = 0U; i < old.z; i++) {
+		if (old.k[i]) {
+			ptab_add(t, old.k[i], old.w[i]);
+		}
+	}
+	if (old.k != NULL) {
+		free(old.k);
+		free(old.w);
+	}
+	return 0;
+}
+
+static int
+ptab_add(struct ptab_s *t, rtz_pair_t k, unsigned int w)
+{
+/* add W to slot K, keys are never 0 as there's no vertex 0 */
+	size_t i;
+
+	if (UNLIKELY(2U * (t->n + 1U) > t->z) && ptab_grow(t) < 0) {
+		return -1;
+	}
+	for (i = ptab_hash(k) & (t->z - 1U);
+	     t->k[i] && t->k[i] != k; i = (i + 1U) & (t->z - 1U));
+	if (!t->k[i]) {
+		t->k[i] = k;
+		t->n++;
+	}
+	t->w[i] += w;
+	return 0;
+}
+
+static void
+proj_chunk(const struct chunk_s *c, void *clo)
+{
+	struct ptab_s *t = clo;
+
+	for (size_t i = 0U; i < c->n && !t->oom;) {
+		const rtz_vtx_t ntgt = c->d[++i];
+		const rtz_vtx_t *tp = c->d + ++i;
+
+		/* every pair of neighbours co-occurs once */
+		for (size_t j = 0U; j < ntgt; j++) {
+			for (size_t k = j + 1U; k < ntgt; k++) {
+				rtz_pair_t lo = tp[j] < tp[k] ? tp[j] : tp[k];
+				rtz_pair_t hi = tp[j] < tp[k] ? tp[k] : tp[j];
+
+				if (UNLIKELY(lo == hi)) {
+					continue;
+				}
+				if (ptab_add(t, lo << RTZ_PAIR_SHIFT | hi, 1U) < 0) {
+					return;
+				}
+			}
+		}
+		i += ntgt;
+	}
+	return;
+}
+
+struct srcp_clo_s {
+	uint64_t *srcs;
+	int(*srcp)(rtz_vtx_t, const char*, void*);
+	void *clo;
+};
+
+static int
+srcp_vtx_cb(rtz_vtx_t vid, const char *vtx, void *clo)
+{
+	struct srcp_clo_s *sc = clo;
+
+	if (sc->srcp(vid, vtx, sc->clo)) {
+		bm_tas(sc->srcs, vid);
+	}
+	return 0;
+}
+
+struct wedg_s {
+	rtz_pair_t k;
+	unsigned int w;
+};
+
+static int
+wedg_cmp(const void *x, const void *y)
+{
+	const struct wedg_s *ex = x;
+	const struct wedg_s *ey = y;
+
+	return (ex->k > ey->k) - (ex->k < ey->k);
+}
+
+rtz_wedglst_t
+rotz_project(
+	rotz_t ctx, int(*srcp)(rtz_vtx_t, const char*, void*), void *clo,
+	unsigned int minw, unsigned int nthreads)
+{
+	const rtz_vtx_t maxid = rotz_get_maxid(ctx);
+	rtz_wedglst_t res = {0U};
+	struct ptab_s *t = NULL;
+	struct wedg_s *e = NULL;
+	uint64_t *srcs;
+	void **tclo;
+	size_t ne = 0U;
+	int rc;
+
+	if (UNLIKELY(!maxid)) {
+		return res;
+	} else if (UNLIKELY(!nthreads)) {
+		nthreads = 1U;
+	}
+	/* find out about the sources first */
+	if (UNLIKELY((srcs = calloc(maxid / 64U + 1U, sizeof(*srcs))) == NULL)) {
+		return res;
+	}
+	with (struct srcp_clo_s sc = {srcs, srcp, clo}) {
+		rotz_vtx_iter(ctx, srcp_vtx_cb, &sc);
+	}
+
+	/* every worker counts into their own table */
+	t = calloc(nthreads, sizeof(*t));
+	tclo = malloc(nthreads * sizeof(*tclo));
+	if (UNLIKELY(t == NULL || tclo == NULL)) {
+		if (tclo != NULL) {
+			free(tclo);
+		}
+		free(srcs);
+		goto out;
+	}
+	for (unsigned int i = 0U; i < nthreads; i++) {
+		tclo[i] = t + i;
+	}
+	rc = scan_edges(ctx, maxid, srcs, proj_chunk, tclo, nthreads);
+	free(tclo);
+	free(srcs);
+	if (UNLIKELY(rc < 0)) {
+		goto out;
+	}
+
+	/* merge into the first table */
+	for (unsigned int i = 0U; i < nthreads; i++) {
+		if (UNLIKELY(t[i].oom)) {
+			goto out;
+		}
+	}
+	for (unsigned int i = 1U; i < nthreads; i++) {
+		for (size_t j = 0U; j < t[i].z; j++) {
+			if (t[i].k[j] && ptab_add(t, t[i].k[j], t[i].w[j]) < 0) {
+				goto out;
+			}
+		}
+	}
+
+	/* prune and sort */
+	if (UNLIKELY((e = malloc((t->n + 1U) * sizeof(*e))) == NULL)) {
+		goto out;
+	}
+	for (size_t j = 0U; j < t->z; j++) {
+		if (t->k[j] && t->w[j] >= minw) {
+			e[ne++] = (struct wedg_s){t->k[j], t->w[j]};
+		}
+	}
+	qsort(e, ne, sizeof(*e), wedg_cmp);
+
+	res.from = malloc((ne + 1U) * sizeof(*res.from));
+	res.to = malloc((ne + 1U) * sizeof(*res.to));
+	res.w = malloc((ne + 1U) * sizeof(*res.w));
+	if (UNLIKELY(res.from == NULL || res.to == NULL || res.w == NULL)) {
+		rotz_free_wedglst(res);
+		res = (rtz_wedglst_t){0U};
+		goto out;
+	}
+	res.z = ne;
+	for (size_t j = 0U; j < ne; j++) {
+		res.from[j] = (rtz_vtx_t)(e[j].k >> RTZ_PAIR_SHIFT);
+		res.to[j] = (rtz_vtx_t)e[j].k;
+		res.w[j] = e[j].w;
+	}
+out:
+	if (e != NULL) {
+		free(e);
+	}
+	if (t != NULL) {
+		for (unsigned int i = 0U; i < nthreads; i++) {
+			if (t[i].k != NULL) {
+				free(t[i].k);
+				free(t[i].w);
+			}
+		}
+		free(t);
+	}
+	return res;
+}
+
+void
+rotz_free_wedglst(rtz_wedglst_t el)
+{
+	if (LIKELY(el.from != NULL)) {
+		free(el.from);
+	}
+	if (LIKELY(el.to != NULL)) {
+		free(el.to);
+	}
+	if (LIKELY(el.w != NULL)) {
+		free(el.w);
+	}
+	return;
+}
+
+
+/* locality orderings
+ * Handles are handed out in first-seen order, which scatters the syms
+ * of a tag across the handle space.  We renumber breadth-first, like
+ * Cuthill-McKee, so the neighbours of a vertex get consecutive handles.
+ * BFS roots are taken by descending degree, neighbours are queued by
+ * ascending degree.  The graph is bipartite, so the side of the roots
+ * is numbered first and the other side after it.  Apart from the
+ * adjacency list being expanded only per-vertex state is kept. */
+static void
+deg_chunk(const struct chunk_s *c, void *clo)
+{
+	rtz_vtx_t *deg = clo;
+
+	for (size_t i = 0U; i < c->n;) {
+		const rtz_vtx_t src = c->d[i++];
+		const rtz_vtx_t ntgt = c->d[i++];
+
+		/* sources are unique, no need to lock */
+		deg[src] = ntgt;
+		i += ntgt;
+	}
+	return;
+}
+
+static int
+pair_cmp(const void *x, const void *y)
+{
+	const rtz_pair_t *px = x;
+	const rtz_pair_t *py = y;
+
+	return (*px > *py) - (*px < *py);
+}
+
+rtz_vtxlst_t
+rotz_locality_order(rotz_t ctx, unsigned int nthreads)
+{
+	const rtz_vtx_t maxid = rotz_get_maxid(ctx);
+	rtz_vtxlst_t res = {0U};
+	rtz_vtx_t *deg;
+	uint64_t *ex = NULL;
+	/* the side of the bipartition, roots are on the even side */
+	uint64_t *odd = NULL;
+	/* vertices keyed by degree */
+	rtz_pair_t *k = NULL;
+	size_t nk = 0U;
+	rtz_pair_t *nb = NULL;
+	size_t nbz = 0U;
+	/* the BFS queue, i.e. old handles in new order */
+	rtz_vtx_t *q = NULL;
+	size_t qh = 0U, qt = 0U;
+	void **clo;
+	int rc;
+
+	if (UNLIKELY(!maxid)) {
+		return res;
+	} else if (UNLIKELY(!nthreads)) {
+		nthreads = 1U;
+	}
+	/* degrees, ... */
+	if (UNLIKELY((deg = calloc(maxid + 1U, sizeof(*deg))) == NULL)) {
+		return res;
+	} else if (UNLIKELY((clo = malloc(nthreads * sizeof(*clo))) == NULL)) {
+		goto oom;
+	}
+	for (unsigned int t = 0U; t < nthreads; t++) {
+		clo[t] = deg;
+	}
+	rc = scan_edges(ctx, maxid, NULL, deg_chunk, clo, nthreads);
+	free(clo);
+	if (UNLIKELY(rc < 0)) {
+		goto oom;
+	}
+	/* ... and existence */
+	if (UNLIKELY((ex = calloc(maxid / 64U + 1U, sizeof(*ex))) == NULL)) {
+		goto oom;
+	}
+	rotz_vtx_iter(ctx, bm_vtx_cb, ex);
+
+	/* roots by descending degree, ties by ascending handle */
+	if (UNLIKELY((k = malloc((maxid + 1U) * sizeof(*k))) == NULL)) {
+		goto oom;
+	}
+	for (rtz_vtx_t v = 1U; v <= maxid; v++) {
+		if (bm_get(ex, v)) {
+			k[nk++] = (rtz_pair_t)deg[v] << RTZ_PAIR_SHIFT |
+				(rtz_vtx_t)~v;
+		}
+	}
+	qsort(k, nk, sizeof(*k), pair_cmp);
+
+	res.z = maxid + 1U;
+	res.d = calloc(res.z, sizeof(*res.d));
+	odd = calloc(maxid / 64U + 1U, sizeof(*odd));
+	q = malloc((nk + 1U) * sizeof(*q));
+	if (UNLIKELY(res.d == NULL || odd == NULL || q == NULL)) {
+		goto oom;
+	}
+	for (size_t r = nk; r-- > 0U;) {
+		const rtz_vtx_t root = ~(rtz_vtx_t)k[r];
+
+		if (res.d[root]) {
+			continue;
+		}
+		res.d[root] = (rtz_vtx_t)++qt;
+		q[qt - 1U] = root;
+
+		while (qh < qt) {
+			const rtz_vtx_t u = q[qh++];
+			rtz_vtxlst_t el = rotz_get_edges(ctx, u);
+			size_t nn = 0U;
+
+			if (UNLIKELY(el.z > nbz)) {
+				const size_t nuz = (el.z / 64U + 1U) * 64U;
+				rtz_pair_t *nu = realloc(nb, nuz * sizeof(*nb));
+
+				if (UNLIKELY(nu == NULL)) {
+					rotz_free_vtxlst(el);
+					goto oom;
+				}
+				nb = nu;
+				nbz = nuz;
+			}
+			for (size_t j = 0U; j < el.z; j++) {
+				const rtz_vtx_t w = el.d[j];
+
+				if (UNLIKELY(w > maxid) || !bm_get(ex, w)) {
+					continue;
+				} else if (res.d[w]) {
+					continue;
+				}
+				nb[nn++] = (rtz_pair_t)deg[w] << RTZ_PAIR_SHIFT | w;
+			}
+			rotz_free_vtxlst(el);
+			qsort(nb, nn, sizeof(*nb), pair_cmp);
+			for (size_t j = 0U; j < nn; j++) {
+				const rtz_vtx_t w = (rtz_vtx_t)nb[j];
+
+				res.d[w] = (rtz_vtx_t)++qt;
+				q[qt - 1U] = w;
+				if (!bm_get(odd, u)) {
+					bm_tas(odd, w);
+				}
+			}
+		}
+	}
+	/* number the even side first, then the odd one, so short lists
+	 * (usually the syms' tags) are dense too */
+	with (rtz_vtx_t nv = 0U) {
+		for (size_t i = 0U; i < qt; i++) {
+			if (!bm_get(odd, q[i])) {
+				res.d[q[i]] = ++nv;
+			}
+		}
+		for (size_t i = 0U; i < qt; i++) {
+			if (bm_get(odd, q[i])) {
+				res.d[q[i]] = ++nv;
+			}
+		}
+	}
+out:
+	if (nb != NULL) {
+		free(nb);
+	}
+	if (q != NULL) {
+		free(q);
+	}
+	if (k != NULL) {
+		free(k);
+	}
+	if (odd != NULL) {
+		free(odd);
+	}
+	if (ex != NULL) {
+		free(ex);
+	}
+	free(deg);
+	return res;
+
+oom:
+	if (res.d != NULL) {
+		free(res.d);
+	}
+	res = (rtz_vtxlst_t){0U};
+	goto out;
+}
+
+
+/* adjacency gaps */
+struct gap_s {
+	uint64_t sum;
+	uint64_t n;
+	rtz_vtx_t *buf;
+	size_t bufz;
+	/* set when BUF couldn't be grown */
+	int oom;
+};
+
+static int
+vtx_cmp(const void *x, const void *y)
+{
+	const rtz_vtx_t *vx = x;
+	const rtz_vtx_t *vy = y;
+
+	return (*vx > *vy) - (*vx < *vy);
+}
+
+static void
+gap_chunk(const struct chunk_s *c, void *clo)
+{
+	struct gap_s *g = clo;
+
+	for (size_t i = 0U; i < c->n;) {
+		const rtz_vtx_t ntgt = c->d[++i];
+
+		if (UNLIKELY(ntgt < 2U)) {
+			i += ntgt + 1U;
+			continue;
+		} else if (UNLIKELY(ntgt > g->bufz)) {
+			const size_t nuz = (ntgt / 64U + 1U) * 64U;
+			rtz_vtx_t *nu = realloc(g->buf, nuz * sizeof(*g->buf));
+
+			if (UNLIKELY(nu == NULL)) {
+				g->oom = -1;
+				return;
+			}
+			g->buf = nu;
+			g->bufz = nuz;
+		}
+		/* lists are kept in insertion order */
+		memcpy(g->buf, c->d + ++i, ntgt * sizeof(*g->buf));
+		qsort(g->buf, ntgt, sizeof(*g->buf), vtx_cmp);
+		for (size_t j = 1U; j < ntgt; j++) {
+			g->sum += g->buf[j] - g->buf[j - 1U];
+		}
+		g->n += ntgt - 1U;
+		i += ntgt;
+	}
+	return;
+}
+
+double
+rotz_avg_gap(rotz_t ctx, unsigned int nthreads)
+{
+	const rtz_vtx_t maxid = rotz_get_maxid(ctx);
+	struct gap_s *g;
+	uint64_t sum = 0U, n = 0U;
+	void **clo;
+	int rc;
+
+	if (UNLIKELY(!maxid)) {
+		return 0.;
+	} else if (UNLIKELY(!nthreads)) {
+		nthreads = 1U;
+	}
+	/* every worker sums up on their own */
+	if (UNLIKELY((g = calloc(nthreads, sizeof(*g))) == NULL)) {
+		return -1.;
+	} else if (UNLIKELY((clo = malloc(nthreads * sizeof(*clo))) == NULL)) {
+		free(g);
+		return -1.;
+	}
+	for (unsigned int t = 0U; t < nthreads; t++) {
+		clo[t] = g + t;
+	}
+	rc = scan_edges(ctx, maxid, NULL, gap_chunk, clo, nthreads);
+	free(clo);
+	for (unsigned int t = 0U; t < nthreads; t++) {
+		sum += g[t].sum;
+		n += g[t].n;
+		rc |= g[t].oom;
+		if (g[t].buf != NULL) {
+			free(g[t].buf);
+		}
+	}
+	free(g);
+	if (UNLIKELY(rc < 0)) {
+		return -1.;
+	}
+	return n ? (double)sum / (double)n : 0.;
+}
+
+/* rgraph.c ends here */
@@ -0,0 +1,111 @@
+/*** rgraph.h -- graph traversals over rotz databases
+ *
+ * Copyright (C) 2013 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of rotz.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if !defined INCLUDED_rgraph_h_
+#define INCLUDED_rgraph_h_
+
+#include "rotz.h"
+
+typedef struct {
+	size_t z;
+	rtz_vtx_t *from;
+	rtz_vtx_t *to;
+	unsigned int *w;
+} rtz_wedglst_t;
+
+/**
+ * Return all vertices within HOPS hops of the N vertices in V, in
+ * breadth-first order and not including V itself.
+ * Frontiers are expanded using NTHREADS threads, accesses to the
+ * rotz handle itself are serialised.
+ * If memory runs out along the way the result is empty.
+ * The result must be freed with `rotz_free_vtxlst()'. */
+extern rtz_vtxlst_t
+rotz_reach(
+	rotz_t, const rtz_vtx_t v[], size_t n,
+	unsigned int hops, unsigned int nthreads);
+
+/**
+ * Label the connected components of the graph in CTX.
+ * The returned list has one slot per object handle, i.e. its length
+ * is one more than `rotz_get_maxid()', and slot V holds the smallest
+ * vertex in V's component or 0 if V doesn't exist.
+ * The edge scan is fed to NTHREADS threads performing the unions.
+ * If memory runs out the result is empty.
+ * The result must be freed with `rotz_free_vtxlst()'. */
+extern rtz_vtxlst_t rotz_components(rotz_t, unsigned int nthreads);
+
+/**
+ * Return the one-mode projection onto the neighbours of all vertices
+ * for which SRCP returns non-0, i.e. every pair of vertices that share
+ * such a neighbour along with the number of neighbours shared.
+ * SRCP is called with the vertex, its name and CLO.
+ * Pairs with weights below MINW are dropped.  Pairs are ordered by
+ * vertex with FROM always being the smaller of the two.
+ * The adjacency lists are fed to NTHREADS threads each counting into
+ * its own table, the tables are merged at the end.
+ * If memory runs out the result is empty and its FROM slot is NULL.
+ * The result must be freed with `rotz_free_wedglst()'. */
+extern rtz_wedglst_t
+rotz_project(
+	rotz_t, int(*srcp)(rtz_vtx_t, const char*, void*), void *clo,
+	unsigned int minw, unsigned int nthreads);
+
+/**
+ * Free up weighted edge list resources as returned by `rotz_project()'. */
+extern void rotz_free_wedglst(rtz_wedglst_t);
+
+/**
+ * Compute a renumbering of the graph in CTX that puts neighbours next
+ * to each other, i.e. a breadth-first order from the vertices of
+ * highest degree with neighbours taken by ascending degree, the side
+ * of the bipartition holding those vertices is numbered first.
+ * The returned list has one slot per object handle, like the one of
+ * `rotz_components()', and slot V holds V's new handle or 0 if V doesn't
+ * exist, new handles are dense.  It is suitable for `rotz_renumber()'.
+ * Degrees are gathered by NTHREADS threads.
+ * If memory runs out the result is empty.
+ * The result must be freed with `rotz_free_vtxlst()'. */
+extern rtz_vtxlst_t rotz_locality_order(rotz_t, unsigned int nthreads);
+
+/**
+ * Return the average gap between handles adjacent in the sorted
+ * adjacency lists of the graph in CTX.
+ * The adjacency lists are fed to NTHREADS threads.
+ * Return -1 if memory runs out. */
+extern double rotz_avg_gap(rotz_t, unsigned int nthreads);
+
+#endif	/* INCLUDED_rgraph_h_ */
@@ -0,0 +1,222 @@
+/*** rinput.c -- line input for rotz commands
+ *
+ * Copyright (C) 2013 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of rotz.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include "rinput.h"
+#include "nifty.h"
+
+/* size of blocks read from non-regular files */
+#define RINPUT_BLK	(1U << 20U)
+
+struct rinput_s {
+	int fd;
+	int eof;
+	/* set when input stopped short because of an error */
+	int err;
+	/* the file mapping, if any */
+	char *map;
+	size_t mapz;
+	/* the window of unconsumed input [bp, ep) in BUF,
+	 * newlines have been searched for up to SP already */
+	char *buf;
+	size_t bsz;
+	size_t bp;
+	size_t sp;
+	size_t ep;
+	/* a mapping's last line, if it lacks the newline */
+	char *line;
+};
+
+
+static int
+refill(rinput_t in)
+{
+	ssize_t nrd;
+
+	/* move the partial line to the front */
+	if (in->bp > 0U) {
+		memmove(in->buf, in->buf + in->bp, in->ep - in->bp);
+		in->sp -= in->bp;
+		in->ep -= in->bp;
+		in->bp = 0U;
+	}
+	/* leave room for the final \nul */
+	if (in->ep + 1U >= in->bsz) {
+		size_t nsz = in->bsz * 2U;
+		char *nu;
+
+		if (UNLIKELY((nu = realloc(in->buf, nsz)) == NULL)) {
+			in->err = 1;
+			return -1;
+		}
+		in->buf = nu;
+		in->bsz = nsz;
+	}
+	do {
+		nrd = read(in->fd, in->buf + in->ep, in->bsz - in->ep - 1U);
+	} while (UNLIKELY(nrd < 0 && errno == EINTR));
+	if (UNLIKELY(nrd < 0)) {
+		in->err = 1;
+		return -1;
+	} else if (nrd == 0) {
+		in->eof = 1;
+		return -1;
+	}
+	in->ep += nrd;
+	return 0;
+}
+
+
+rinput_t
+make_rinput(int fd)
+{
+	struct rinput_s *res;
+	struct stat st;
+
+	if (UNLIKELY((res = calloc(1, sizeof(*res))) == NULL)) {
+		return NULL;
+	}
+	res->fd = fd;
+	if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+		off_t off = lseek(fd, 0, SEEK_CUR);
+		void *p;
+
+		/* private, lines are \nul-terminated in place and
+		 * that mustn't reach the file */
+		p = mmap(
+			NULL, st.st_size, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE, fd, 0);
+		if (p != MAP_FAILED && off >= 0 && off <= st.st_size) {
+			(void)madvise(p, st.st_size, MADV_SEQUENTIAL);
+			res->map = p;
+			res->mapz = st.st_size;
+			res->buf = p;
+			res->bp = res->sp = off;
+			res->ep = st.st_size;
+			res->eof = 1;
+			return res;
+		} else if (p != MAP_FAILED) {
+			munmap(p, st.st_size);
+		}
+	}
+	/* block reader then */
+	if (UNLIKELY((res->buf = malloc(RINPUT_BLK)) == NULL)) {
+		free(res);
+		return NULL;
+	}
+	res->bsz = RINPUT_BLK;
+	return res;
+}
+
+void
+free_rinput(rinput_t in)
+{
+	if (in->map != NULL) {
+		munmap(in->map, in->mapz);
+	} else {
+		free(in->buf);
+	}
+	if (in->line != NULL) {
+		free(in->line);
+	}
+	free(in);
+	return;
+}
+
+static char*
+term_last(rinput_t in, char *lp, size_t z)
+{
+/* \nul-terminate the final line LP of length Z, mappings end right
+ * after it so it's copied out for them */
+	if (in->map == NULL) {
+		lp[z] = '\0';
+		return lp;
+	} else if (UNLIKELY((in->line = malloc(z + 1U)) == NULL)) {
+		in->err = 1;
+		return NULL;
+	}
+	memcpy(in->line, lp, z);
+	in->line[z] = '\0';
+	return in->line;
+}
+
+char*
+rinput_line(rinput_t in, size_t *lz)
+{
+	do {
+		char *lp = in->buf + in->bp;
+		char *nl;
+
+		if ((nl = memchr(in->buf + in->sp, '\n', in->ep - in->sp))) {
+			*lz = nl - lp;
+			in->bp = in->sp = nl + 1U - in->buf;
+			*nl = '\0';
+			return lp;
+		}
+		in->sp = in->ep;
+	} while (!in->eof && refill(in) >= 0);
+
+	if (UNLIKELY(in->err)) {
+		/* don't pass off a partial line */
+		return NULL;
+	} else if (in->bp < in->ep) {
+		/* last line without newline */
+		char *lp = in->buf + in->bp;
+
+		*lz = in->ep - in->bp;
+		in->bp = in->sp = in->ep;
+		return term_last(in, lp, *lz);
+	}
+	return NULL;
+}
+
+int
+rinput_err(rinput_t in)
+{
+	return in->err;
+}
+
+/* rinput.c ends here */
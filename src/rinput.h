@@ -0,0 +1,85 @@
+/*** rinput.h -- line input for rotz commands
+ *
+ * Copyright (C) 2013 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of rotz.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if !defined INCLUDED_rinput_h_
+#define INCLUDED_rinput_h_
+
+#include <stddef.h>
+#include <string.h>
+
+typedef struct rinput_s *rinput_t;
+
+/**
+ * Open a line reader on file descriptor FD.
+ * Regular files are mapped into memory, anything else is read in
+ * large blocks.  Return NULL if the reader can't be set up. */
+extern rinput_t make_rinput(int fd);
+
+/**
+ * Release resources associated with the line reader. */
+extern void free_rinput(rinput_t);
+
+/**
+ * Return the next line from IN with the newline stripped, or NULL at
+ * the end of the input or on error, see `rinput_err()'.
+ * The length of the line is put into LZ.
+ * The line is \nul-terminated in place, in the reader's buffer or in
+ * a private mapping of the file.  It may be modified by the caller but
+ * is only valid until the next call. */
+extern char *rinput_line(rinput_t in, size_t *lz);
+
+/**
+ * Return non-0 if `rinput_line()' stopped because of a read error or
+ * because memory ran out rather than at the end of the input. */
+extern int rinput_err(rinput_t in);
+
+/**
+ * Split LINE of length LZ at the first tab, i.e. \nul-terminate the
+ * first field and return a pointer to the second, or NULL if LINE
+ * has no tab. */
+static inline char*
+rinput_tab(char *line, size_t lz)
+{
+	char *tab;
+
+	if ((tab = memchr(line, '\t', lz)) == NULL) {
+		return NULL;
+	}
+	*tab++ = '\0';
+	return tab;
+}
+
+#endif	/* INCLUDED_rinput_h_ */
@@ -0,0 +1,76 @@
+/*** rkern.h -- set operation and sort kernels
+ *
+ * Copyright (C) 2013 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of rotz.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if !defined INCLUDED_rkern_h_
+#define INCLUDED_rkern_h_
+
+#include "rotz.h"
+#include "raux.h"
+
+/* Internal, these are not part of the rotz api.  They are hidden from
+ * the shared library, bench/kernbench links librotz statically to
+ * measure them in isolation. */
+#if !defined RTZ_INTERN
+# define RTZ_INTERN	__attribute__((visibility("hidden")))
+#endif	/* !RTZ_INTERN */
+
+/**
+ * Return the index (1-based) of TO in EL or 0 if EL does not contain TO. */
+RTZ_INTERN size_t rtz_find_in_vtxlst(rtz_const_vtxlst_t el, rtz_vtx_t to);
+
+/**
+ * Return a pointer to the string S of length Z in the \nul-separated
+ * list of strings B, or NULL if S is not among them. */
+RTZ_INTERN const char*
+rtz_find_in_buf(rtz_const_buf_t b, const char *s, size_t z);
+
+/**
+ * Append the vertices of EL not yet in TGT to TGT.
+ * TGT is grown in arena A or, if A is NULL, on the heap. */
+RTZ_INTERN rtz_vtxlst_t
+rtz_vtxlst_union(rtz_arena_t a, rtz_vtxlst_t tgt, rtz_const_vtxlst_t el);
+
+/**
+ * Like `rtz_vtxlst_union()' but bump the weight of vertices already in TGT. */
+RTZ_INTERN rtz_wtxlst_t
+rtz_wtxlst_union(rtz_arena_t a, rtz_wtxlst_t tgt, rtz_const_vtxlst_t el);
+
+/**
+ * Remove the vertices from TGT that are not in EL, in place. */
+RTZ_INTERN rtz_vtxlst_t
+rtz_vtxlst_intersection(rtz_vtxlst_t tgt, rtz_const_vtxlst_t el);
+
+#endif	/* INCLUDED_rkern_h_ */
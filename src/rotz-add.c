@@ -47,55 +47,122 @@
 #include "rotz.h"
 #include "rotz-cmd-api.h"
 #include "rotz-umb.h"
+#include "rinput.h"
 #include "nifty.h"
 
 static int verbosep;
 #define _		rotz_massage_name
 
 
+static struct rtz_batch_s tg[1U];
+static struct rtz_batch_s sy[1U];
+
 static void
-add_tag(rotz_t ctx, rtz_vtx_t tid, const char *sym)
+add_tags(rotz_t ctx, rtz_vtx_t tid, const rtz_vtx_t *sids, size_t n)
 {
-	const char *symspc_sym;
-	rtz_vtx_t sid;
-
-	if (UNLIKELY((symspc_sym = rotz_sym(sym)) == NULL)) {
-		return;
-	} else if (UNLIKELY((sid = rotz_add_vertex(ctx, symspc_sym)) == 0U)) {
-		return;
+/* associate TID with the N syms in SIDS, TID's edge list is written once */
+	rotz_add_edges(ctx, tid, sids, n);
+	for (size_t i = 0U; i < n; i++) {
+		rotz_add_edge(ctx, sids[i], tid);
 	}
-	rotz_add_edge(ctx, tid, sid);
-	rotz_add_edge(ctx, sid, tid);
 
 	if (UNLIKELY(verbosep)) {
-		fputc('+', stdout);
-		fputs(_(rotz_get_name(ctx, tid)), stdout);
-		fputc('\t', stdout);
-		fputs(_(rotz_get_name(ctx, sid)), stdout);
-		fputc('\n', stdout);
+		for (size_t i = 0U; i < n; i++) {
+			fputc('+', stdout);
+			fputs(_(rotz_get_name(ctx, tid)), stdout);
+			fputc('\t', stdout);
+			fputs(_(rotz_get_name(ctx, sids[i])), stdout);
+			fputc('\n', stdout);
+		}
 	}
 	return;
 }
 
 static void
-add_tagsym(rotz_t ctx, const char *tag, const char *sym)
+add_batch(rotz_t ctx, rtz_vtx_t tid)
 {
-	rtz_vtx_t tid;
+/* associate the syms in SY with TID or, if TID is 0, with the
+ * respective tags in TG, runs of syms with the same tag are
+ * added in one go */
+	static rtz_vtx_t tids[RTZ_BATCH_Z];
+	static rtz_vtx_t sids[RTZ_BATCH_Z];
+	const char *const *tp = NULL;
+	const char *const *sp;
+	rtz_vtx_t rt = 0U;
+	size_t nr = 0U;
+	size_t nnew = 0U;
 
-	tag = rotz_tag(tag);
-	if (UNLIKELY((tid = rotz_add_vertex(ctx, tag)) == 0U)) {
-		return;
+	/* resolve the whole batch first */
+	if (!tid) {
+		tp = rotz_batch_seal(tg);
+		nnew += tg->n - rotz_get_vertices(ctx, tp, tg->n, tids);
+	}
+	sp = rotz_batch_seal(sy);
+	nnew += sy->n - rotz_get_vertices(ctx, sp, sy->n, sids);
+	if (nnew) {
+		/* get ids for the newcomers in one go */
+		rotz_reserve_ids(ctx, nnew);
 	}
-	add_tag(ctx, tid, sym);
+
+	for (size_t i = 0U; i < sy->n; i++) {
+		rtz_vtx_t t = tid ?: tids[i];
+		rtz_vtx_t s = sids[i];
+
+		/* vertices we haven't seen yet need adding */
+		if (t) {
+			;
+		} else if (UNLIKELY(!*tp[i])) {
+			continue;
+		} else if (UNLIKELY((t = rotz_add_vertex(ctx, tp[i])) == 0U)) {
+			continue;
+		}
+		if (s) {
+			;
+		} else if (UNLIKELY(!*sp[i])) {
+			continue;
+		} else if (UNLIKELY((s = rotz_add_vertex(ctx, sp[i])) == 0U)) {
+			continue;
+		}
+		if (t != rt) {
+			/* flush the run of the previous tag */
+			add_tags(ctx, rt, sids, nr);
+			rt = t;
+			nr = 0U;
+		}
+		/* SIDS doubles as run buffer, NR never overtakes I */
+		sids[nr++] = s;
+	}
+	add_tags(ctx, rt, sids, nr);
+	rotz_batch_clear(tg);
+	rotz_batch_clear(sy);
 	return;
 }
 
-
+static void
+add_sym(rotz_t ctx, rtz_vtx_t tid, const char *sym)
+{
+	rotz_batch_push_glued(sy, rotz_sym(sym));
+	if (UNLIKELY(sy->n >= RTZ_BATCH_Z)) {
+		add_batch(ctx, tid);
+	}
+	return;
+}
+
+static void
+add_tagsym(rotz_t ctx, const char *tag, const char *sym)
+{
+	rotz_batch_push_glued(tg, rotz_tag(tag));
+	add_sym(ctx, 0U, sym);
+	return;
+}
+
+
 #if defined STANDALONE
 int
 rotz_cmd_add(const struct yuck_cmd_add_s argi[static 1U])
 {
 	rotz_t ctx;
+	int rc = 0;
 	const char *tag;
 	rtz_vtx_t tid;
 
@@ -109,23 +176,31 @@ rotz_cmd_add(const struct yuck_cmd_add_s argi[static 1U])
 	}
 	if (argi->nargs == 0U && !isatty(STDIN_FILENO)) {
 		/* tag \t sym mode, both from stdin */
-		char *line = NULL;
-		size_t llen = 0U;
-		ssize_t nrd;
+		rinput_t rd = make_rinput(STDIN_FILENO);
+		char *line;
+		size_t llen;
 
-		while ((nrd = getline(&line, &llen, stdin)) > 0) {
+		if (UNLIKELY(rd == NULL)) {
+			fputs("Error: cannot read from stdin\n", stderr);
+			rc = 1;
+			goto fini;
+		}
+		while ((line = rinput_line(rd, &llen)) != NULL) {
 			const char *sym;
 
-			line[nrd - 1] = '\0';
 			tag = line;
-			if (UNLIKELY((sym = strchr(line, '\t')) == NULL)) {
+			/* \t -> \0 */
+			if (UNLIKELY((sym = rinput_tab(line, llen)) == NULL)) {
 				continue;
 			}
-			/* \t -> \0 */
-			line[sym++ - line] = '\0';
 			add_tagsym(ctx, tag, sym);
 		}
-		free(line);
+		if (UNLIKELY(rinput_err(rd))) {
+			fputs("Error: cannot read from stdin\n", stderr);
+			rc = 1;
+		}
+		free_rinput(rd);
+		add_batch(ctx, 0U);
 		goto fini;
 	}
 	/* ... otherwise associate with TAG somehow */
@@ -134,25 +209,36 @@ rotz_cmd_add(const struct yuck_cmd_add_s argi[static 1U])
 		goto fini;
 	}
 	for (size_t i = 1U; i < argi->nargs; i++) {
-		add_tag(ctx, tid, argi->args[i]);
+		add_sym(ctx, tid, argi->args[i]);
 	}
 	if (argi->nargs == 1U && !isatty(STDIN_FILENO)) {
 		/* add tags from stdin */
-		char *line = NULL;
-		size_t llen = 0U;
-		ssize_t nrd;
+		rinput_t rd = make_rinput(STDIN_FILENO);
+		char *line;
+		size_t llen;
 
-		while ((nrd = getline(&line, &llen, stdin)) > 0) {
-			line[nrd - 1] = '\0';
-			add_tag(ctx, tid, line);
+		if (UNLIKELY(rd == NULL)) {
+			fputs("Error: cannot read from stdin\n", stderr);
+			rc = 1;
+			goto fini;
+		}
+		while ((line = rinput_line(rd, &llen)) != NULL) {
+			add_sym(ctx, tid, line);
+		}
+		if (UNLIKELY(rinput_err(rd))) {
+			fputs("Error: cannot read from stdin\n", stderr);
+			rc = 1;
 		}
-		free(line);
+		free_rinput(rd);
 	}
+	add_batch(ctx, tid);
 
 fini:
 	/* big rcource freeing */
+	rotz_batch_free(tg);
+	rotz_batch_free(sy);
 	free_rotz(ctx);
-	return 0;
+	return rc;
 }
 #endif	/* STANDALONE */
 
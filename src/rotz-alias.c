@@ -47,6 +47,7 @@
 #include "rotz.h"
 #include "rotz-cmd-api.h"
 #include "rotz-umb.h"
+#include "rinput.h"
 #include "nifty.h"
 
 
@@ -97,6 +98,7 @@ int
 rotz_cmd_alias(const struct yuck_cmd_alias_s argi[static 1U])
 {
 	rotz_t ctx;
+	int rc = 0;
 	const char *tag;
 	rtz_vtx_t tid;
 
@@ -125,15 +127,23 @@ rotz_cmd_alias(const struct yuck_cmd_alias_s argi[static 1U])
 			aliases(ctx, tid, '\n');
 		} else {
 			/* alias tags from stdin */
-			char *line = NULL;
-			size_t llen = 0U;
-			ssize_t nrd;
+			rinput_t rd = make_rinput(STDIN_FILENO);
+			char *line;
+			size_t llen;
 
-			while ((nrd = getline(&line, &llen, stdin)) > 0) {
-				line[nrd - 1] = '\0';
+			if (UNLIKELY(rd == NULL)) {
+				fputs("Error: cannot read from stdin\n", stderr);
+				rc = 1;
+				goto fini;
+			}
+			while ((line = rinput_line(rd, &llen)) != NULL) {
 				alias_tag(ctx, tid, line);
 			}
-			free(line);
+			if (UNLIKELY(rinput_err(rd))) {
+				fputs("Error: cannot read from stdin\n", stderr);
+				rc = 1;
+			}
+			free_rinput(rd);
 		}
 	} else {
 		/* show all aliases mode */
@@ -143,7 +153,7 @@ rotz_cmd_alias(const struct yuck_cmd_alias_s argi[static 1U])
 fini:
 	/* big rcource freeing */
 	free_rotz(ctx);
-	return 0;
+	return rc;
 }
 #endif	/* STANDALONE */
 
@@ -0,0 +1,585 @@
+/*** rotz-batch.c -- run many commands over one handle
+ *
+ * Copyright (C) 2013-2014 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of rotz.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdio.h>
+#include <fcntl.h>
+
+#include "rotz.h"
+#include "rotz-cmd-api.h"
+#include "rotz-umb.h"
+#include "rinput.h"
+#include "routput.h"
+#include "nifty.h"
+
+/* commands per transaction unless told otherwise */
+#define BATCH_DFLT_Z	(10000U)
+
+/* error message of the last failing command */
+static char err[256U];
+
+static struct {
+	size_t z;
+	char **d;
+} av;
+
+/* sym ids of the command at hand */
+static struct {
+	size_t z;
+	rtz_vtx_t *d;
+} sv;
+
+static const char*
+fail(const char *fmt, const char *s)
+{
+	snprintf(err, sizeof(err), fmt, s);
+	return err;
+}
+
+static size_t
+tokenise(char *line)
+{
+/* split LINE in place into words like the shell would, honouring
+ * quotes and backslashes, and put them into AV */
+	char *tp = line;
+	size_t n = 0U;
+
+	for (char *s = line; *s;) {
+		char q = '\0';
+
+		while (*s == ' ' || *s == '\t') {
+			s++;
+		}
+		if (!*s || (n == 0U && *s == '#')) {
+			/* comments only at the beginning of lines */
+			break;
+		}
+		if (UNLIKELY(n >= av.z)) {
+			av.z = (av.z + 16U) * 2U;
+			av.d = realloc(av.d, av.z * sizeof(*av.d));
+		}
+		av.d[n++] = tp;
+		for (; *s && (q || (*s != ' ' && *s != '\t')); s++) {
+			if (*s == q) {
+				q = '\0';
+				continue;
+			} else if (!q && (*s == '\'' || *s == '"')) {
+				q = *s;
+				continue;
+			} else if (*s == '\\' && q != '\'' && s[1U]) {
+				s++;
+			}
+			*tp++ = *s;
+		}
+		/* step over the separator, TP might be about to overwrite it */
+		s += *s != '\0';
+		*tp++ = '\0';
+	}
+	return n;
+}
+
+static bool
+optp(const char *arg, const char *lng, const char *shrt)
+{
+	return !strcmp(arg, lng) || (shrt != NULL && !strcmp(arg, shrt));
+}
+
+
+/* the commands, they return NULL on success or an error message */
+static const char*
+b_add(rotz_t ctx, size_t argc, char *argv[])
+{
+	const char *tag;
+	rtz_vtx_t tid;
+	size_t n = 0U;
+
+	if (argc < 1U) {
+		return "need a TAG";
+	} else if ((tag = rotz_tag(argv[0U])) == NULL) {
+		return "empty TAG";
+	} else if (!(tid = rotz_get_vertex(ctx, tag)) &&
+		   !(tid = rotz_add_vertex(ctx, tag))) {
+		return fail("cannot add tag `%s'", argv[0U]);
+	} else if (UNLIKELY(argc - 1U > sv.z)) {
+		const size_t nz = (argc / 64U + 1U) * 64U;
+		rtz_vtx_t *nu;
+
+		if (UNLIKELY((nu = realloc(sv.d, nz * sizeof(*nu))) == NULL)) {
+			return "out of memory";
+		}
+		sv.d = nu;
+		sv.z = nz;
+	}
+	/* resolve the syms, then write TID's edge list just once */
+	for (size_t i = 1U; i < argc; i++) {
+		const char *sym;
+		rtz_vtx_t sid;
+
+		if ((sym = rotz_sym(argv[i])) == NULL) {
+			continue;
+		} else if (!(sid = rotz_get_vertex(ctx, sym)) &&
+			   !(sid = rotz_add_vertex(ctx, sym))) {
+			return fail("cannot add sym `%s'", argv[i]);
+		}
+		sv.d[n++] = sid;
+	}
+	if (UNLIKELY(rotz_add_edges(ctx, tid, sv.d, n) < 0)) {
+		return fail("cannot add syms to `%s'", argv[0U]);
+	}
+	for (size_t i = 0U; i < n; i++) {
+		if (UNLIKELY(rotz_add_edge(ctx, sv.d[i], tid) < 0)) {
+			return fail("cannot add `%s' to its syms", argv[0U]);
+		}
+	}
+	return NULL;
+}
+
+static const char*
+b_del(rotz_t ctx, size_t argc, char *argv[])
+{
+	bool symsp = false;
+	const char *v;
+	rtz_vtx_t tid;
+
+	for (; argc > 0U && *argv[0U] == '-'; argc--, argv++) {
+		if (optp(argv[0U], "--syms", NULL)) {
+			symsp = true;
+		} else if (!optp(argv[0U], "--verbose", "-v")) {
+			return fail("unknown option `%s'", argv[0U]);
+		}
+	}
+	if (argc < 1U) {
+		return "need a TAG";
+	} else if (symsp) {
+		/* delete the syms altogether */
+		for (size_t i = 0U; i < argc; i++) {
+			if ((v = rotz_sym(argv[i])) != NULL) {
+				rotz_drop_vertex(ctx, v);
+			}
+		}
+		return NULL;
+	} else if ((v = rotz_tag(argv[0U])) == NULL ||
+		   !(tid = rotz_get_vertex(ctx, v))) {
+		return fail("no such tag `%s'", argv[0U]);
+	} else if (argc == 1U) {
+		/* delete the tag altogether */
+		rotz_drop_vertex(ctx, v);
+		return NULL;
+	}
+	for (size_t i = 1U; i < argc; i++) {
+		rtz_vtx_t sid;
+
+		if ((v = rotz_sym(argv[i])) != NULL &&
+		    (sid = rotz_get_vertex(ctx, v))) {
+			rotz_rem_edge(ctx, tid, sid);
+			rotz_rem_edge(ctx, sid, tid);
+		}
+	}
+	return NULL;
+}
+
+static const char*
+b_alias(rotz_t ctx, size_t argc, char *argv[])
+{
+	bool delp = false;
+	const char *tag;
+	rtz_vtx_t tid;
+
+	for (; argc > 0U && *argv[0U] == '-'; argc--, argv++) {
+		if (optp(argv[0U], "--delete", "-d")) {
+			delp = true;
+		} else {
+			return fail("unknown option `%s'", argv[0U]);
+		}
+	}
+	if (argc < 1U) {
+		return "need a TAG";
+	} else if ((tag = rotz_tag(argv[0U])) == NULL ||
+		   !(tid = rotz_get_vertex(ctx, tag))) {
+		return fail("no such tag `%s'", argv[0U]);
+	} else if (delp) {
+		for (size_t i = 0U; i < argc; i++) {
+			if ((tag = rotz_tag(argv[i])) != NULL) {
+				rotz_rem_alias(ctx, tag);
+			}
+		}
+		return NULL;
+	} else if (argc < 2U) {
+		return "need an ALIAS";
+	}
+	for (size_t i = 1U; i < argc; i++) {
+		if ((tag = rotz_tag(argv[i])) == NULL) {
+			continue;
+		} else if (rotz_add_alias(ctx, tid, tag) < 0) {
+			return fail("cannot alias `%s'", argv[i]);
+		}
+	}
+	return NULL;
+}
+
+static const char*
+combine_into(rotz_t ctx, rtz_vtx_t into_tid, const char *name, bool aliasp)
+{
+/* merge NAME into INTO_TID, keep NAME's names as aliases iff ALIASP */
+	const char *tag;
+	rtz_vtx_t tid;
+	rtz_buf_t al = {0U};
+
+	if ((tag = rotz_tag(name)) == NULL || !(tid = rotz_get_vertex(ctx, tag))) {
+		return NULL;
+	} else if (!aliasp) {
+		/* names of TID, as they stand before the merge */
+		al = rotz_get_aliases(ctx, tid);
+	}
+	if (rotz_merge_vertices(ctx, into_tid, tid) < 0) {
+		rotz_free_r(al);
+		return fail("cannot combine `%s'", name);
+	}
+	for (const char *x = al.d, *const ex = al.d + al.z;
+	     x < ex; x += strlen(x) + 1U) {
+		rotz_rem_alias(ctx, x);
+	}
+	rotz_free_r(al);
+	return NULL;
+}
+
+static const char*
+b_combine(rotz_t ctx, size_t argc, char *argv[])
+{
+	const char *into = NULL;
+	const char *tag;
+	rtz_vtx_t into_tid;
+	bool aliasp = false;
+
+	for (; argc > 0U && *argv[0U] == '-'; argc--, argv++) {
+		if (!strncmp(argv[0U], "--into=", 7U)) {
+			into = argv[0U] + 7U;
+		} else {
+			return fail("unknown option `%s'", argv[0U]);
+		}
+	}
+	if (into == NULL && argc > 0U) {
+		/* combine everything into the first tag */
+		into = *argv++;
+		argc--;
+		aliasp = true;
+	} else if (into == NULL) {
+		return "need TAGs";
+	}
+	if ((tag = rotz_tag(into)) == NULL ||
+	    !(into_tid = rotz_get_vertex(ctx, tag))) {
+		return fail("no such tag `%s'", into);
+	}
+	for (size_t i = 0U; i < argc; i++) {
+		const char *msg;
+
+		if ((msg = combine_into(ctx, into_tid, argv[i], aliasp))) {
+			return msg;
+		}
+	}
+	return NULL;
+}
+
+static const char*
+b_rename(rotz_t ctx, size_t argc, char *argv[])
+{
+	const char *tag;
+	rtz_vtx_t tid;
+
+	if (argc != 2U) {
+		return "need OLDNAME and NEWNAME";
+	} else if ((tag = rotz_tag(argv[0U])) == NULL ||
+		   !(tid = rotz_get_vertex(ctx, tag))) {
+		return fail("no such tag `%s'", argv[0U]);
+	} else if ((tag = rotz_tag(argv[1U])) == NULL ||
+		   rotz_add_alias(ctx, tid, tag) < 0) {
+		return fail("target tag `%s' exists", argv[1U]);
+	}
+	rotz_rem_alias(ctx, rotz_tag(argv[0U]));
+	return NULL;
+}
+
+static const char*
+run(rotz_t ctx, size_t argc, char *argv[])
+{
+	static const struct {
+		const char *name;
+		const char*(*fn)(rotz_t, size_t, char*[]);
+	} cmds[] = {
+		{"add", b_add},
+		{"alias", b_alias},
+		{"combine", b_combine},
+		{"del", b_del},
+		{"rename", b_rename},
+	};
+
+	if (!strcmp(argv[0U], "rotz") && argc > 1U) {
+		/* allow lines straight out of shell scripts */
+		argc--;
+		argv++;
+	}
+	for (size_t i = 0U; i < countof(cmds); i++) {
+		if (!strcmp(argv[0U], cmds[i].name)) {
+			return cmds[i].fn(ctx, argc - 1U, argv + 1U);
+		}
+	}
+	return fail("unknown command `%s'", argv[0U]);
+}
+
+
+#if defined STANDALONE
+/* status lines of the current transaction, they go out after commit */
+static struct {
+	size_t n;
+	size_t z;
+	char *d;
+} st;
+
+static void
+st_add(size_t lno, const char *msg)
+{
+	char tmp[64U];
+	const size_t z = snprintf(
+		tmp, sizeof(tmp), msg ? "%zu\terror: " : "%zu\tok", lno);
+	const size_t mz = msg ? strlen(msg) : 0U;
+
+	if (UNLIKELY(st.n + z + mz + 1U > st.z)) {
+		st.z = ((st.n + z + mz + 1U) / 4096U + 1U) * 4096U;
+		st.d = realloc(st.d, st.z);
+	}
+	memcpy(st.d + st.n, tmp, z);
+	if (mz) {
+		memcpy(st.d + st.n + z, msg, mz);
+	}
+	st.n += z + mz;
+	st.d[st.n++] = '\n';
+	return;
+}
+
+/* lines of the commands that went through in the current transaction,
+ * \nul-separated and untokenised, so they can be run again */
+static struct {
+	size_t n;
+	size_t z;
+	char *d;
+} tx;
+
+static int
+tx_add(const char *line, size_t llen)
+{
+	if (UNLIKELY(tx.n + llen + 1U > tx.z)) {
+		const size_t nz = ((tx.n + llen + 1U) / 4096U + 1U) * 4096U;
+		char *nu;
+
+		if (UNLIKELY((nu = realloc(tx.d, nz)) == NULL)) {
+			return -1;
+		}
+		tx.d = nu;
+		tx.z = nz;
+	}
+	memcpy(tx.d + tx.n, line, llen);
+	tx.d[tx.n + llen] = '\0';
+	tx.n += llen + 1U;
+	return 0;
+}
+
+static int
+replay(rotz_t ctx)
+{
+/* roll back the current transaction and run the commands that went
+ * through again, so that a failing command leaves no trace */
+	rotz_abort(ctx);
+	if (UNLIKELY(rotz_begin(ctx) < 0)) {
+		return -1;
+	}
+	for (char *lp = tx.d, *const ep = tx.d + tx.n; lp < ep;) {
+		const size_t lz = strlen(lp);
+
+		if (UNLIKELY(run(ctx, tokenise(lp), av.d) != NULL)) {
+			rotz_abort(ctx);
+			return -1;
+		}
+		lp += lz + 1U;
+	}
+	return 0;
+}
+
+static int
+commit(rotz_t ctx, routput_t out)
+{
+	tx.n = 0U;
+	if (UNLIKELY(rotz_commit(ctx) < 0)) {
+		return -1;
+	}
+	/* only now are the commands' effects for real */
+	routput_buf(out, st.d, st.n);
+	st.n = 0U;
+	return 0;
+}
+
+int
+rotz_cmd_batch(const struct yuck_cmd_batch_s argi[static 1U])
+{
+	size_t nbatch = BATCH_DFLT_Z;
+	int fd = STDIN_FILENO;
+	rotz_t ctx;
+	rinput_t rd;
+	routput_t out;
+	char *line;
+	size_t llen;
+	size_t lno = 0U;
+	size_t ntx = 0U;
+	int rc = 0;
+
+	if (argi->batch_arg) {
+		nbatch = strtoul(argi->batch_arg, NULL, 0) ?: 1U;
+	}
+	if (argi->nargs && (fd = open(argi->args[0U], O_RDONLY)) < 0) {
+		fprintf(stderr, "Error: cannot open `%s'\n", argi->args[0U]);
+		return 1;
+	} else if (UNLIKELY((ctx = make_rotz(db, O_CREAT | O_RDWR)) == NULL)) {
+		fputs("Error opening rotz datastore\n", stderr);
+		rc = 1;
+		goto clo;
+	}
+	if (UNLIKELY((rd = make_rinput(fd)) == NULL)) {
+		fputs("Error: cannot read commands\n", stderr);
+		free_rotz(ctx);
+		rc = 1;
+		goto clo;
+	}
+	if (UNLIKELY((out = make_routput(STDOUT_FILENO)) == NULL)) {
+		fputs("Error: cannot allocate output buffer\n", stderr);
+		free_rinput(rd);
+		free_rotz(ctx);
+		rc = 1;
+		goto clo;
+	}
+
+	while ((line = rinput_line(rd, &llen)) != NULL) {
+		const size_t mark = tx.n;
+		const char *msg;
+		size_t argc;
+
+		lno++;
+		if (UNLIKELY(tx_add(line, llen) < 0)) {
+			fputs("Error: cannot allocate command buffer\n", stderr);
+			rc = 1;
+			break;
+		} else if (!(argc = tokenise(line))) {
+			tx.n = mark;
+			continue;
+		} else if (!ntx && UNLIKELY(rotz_begin(ctx) < 0)) {
+			fputs("Error: cannot start transaction\n", stderr);
+			rc = 1;
+			break;
+		}
+		if ((msg = run(ctx, argc, av.d)) != NULL) {
+			/* carry on but remember it, and undo whatever it did
+			 * get done, the transaction is cut short for that */
+			tx.n = mark;
+			st_add(lno, msg);
+			rc = 1;
+			if (UNLIKELY(replay(ctx) < 0)) {
+				fprintf(stderr, "\
+Error: cannot roll back line %zu, commands since the last commit are lost\n",
+					lno);
+				/* their status lines would be lies */
+				st.n = tx.n = ntx = 0U;
+				break;
+			}
+			ntx = 0U;
+			if (UNLIKELY(commit(ctx, out) < 0)) {
+				goto nocommit;
+			}
+			continue;
+		} else if (!argi->quiet_flag) {
+			st_add(lno, NULL);
+		}
+		if (++ntx < nbatch) {
+			continue;
+		}
+		ntx = 0U;
+		if (UNLIKELY(commit(ctx, out) < 0)) {
+			goto nocommit;
+		}
+	}
+	if (UNLIKELY(rinput_err(rd))) {
+		fprintf(stderr, "\
+Error: cannot read commands past line %zu\n", lno);
+		rc = 1;
+	}
+	if (ntx && UNLIKELY(commit(ctx, out) < 0)) {
+	nocommit:
+		fprintf(stderr, "\
+Error: cannot commit commands up to line %zu\n", lno);
+		rc = 1;
+	}
+
+	/* big rcource freeing */
+	if (free_routput(out) < 0) {
+		rc = 1;
+	}
+	free_rinput(rd);
+	free_rotz(ctx);
+clo:
+	if (st.d != NULL) {
+		free(st.d);
+	}
+	if (tx.d != NULL) {
+		free(tx.d);
+	}
+	if (av.d != NULL) {
+		free(av.d);
+	}
+	if (sv.d != NULL) {
+		free(sv.d);
+	}
+	if (fd != STDIN_FILENO) {
+		close(fd);
+	}
+	return rc;
+}
+#endif	/* STANDALONE */
+
+/* rotz-batch.c ends here */
@@ -49,6 +49,8 @@
 #include "nifty.h"
 
 static rotz_t ctx;
+static int idsp;
+static struct rtz_names_s nm[1U];
 
 struct iter_clo_s {
 	struct {
@@ -61,10 +63,12 @@ struct iter_clo_s {
 
 
 static void
-prnt_wtx(rtz_vtx_t it, unsigned int w)
+prnt_wtx(rtz_vtx_t it, const char *sym, unsigned int w)
 {
-	const char *sym = rotz_get_name(ctx, it);
-
+	if (idsp) {
+		fprintf(stdout, "%ju\t%u\n", (uintmax_t)it, w);
+		return;
+	}
 	fputs(rotz_massage_name(sym), stdout);
 	fputc('\t', stdout);
 	fprintf(stdout, "%u", w);
@@ -76,7 +80,7 @@ static int
 iter_cb(rtz_vtx_t vid, const char *vtx, void *clo)
 {
 	const struct iter_clo_s *cp = clo;
-	rtz_vtxlst_t el;
+	size_t ne;
 
 	if (memcmp(vtx, RTZ_SYMSPC, sizeof(RTZ_SYMSPC) - 1) == 0) {
 		/* that's a symbol, vtx would be a tag then */
@@ -89,32 +93,39 @@ iter_cb(rtz_vtx_t vid, const char *vtx, void *clo)
 		return 0;
 	}
 
-	el = rotz_get_edges(ctx, vid);
-	if (!cp->wl.z) {
+	/* only the count is needed, no need for a copy of the list */
+	ne = rotz_get_nedges(ctx, vid);
+	if (!cp->wl.z && idsp) {
+		fprintf(stdout, "%ju\t%zu\n", (uintmax_t)vid, ne);
+	} else if (!cp->wl.z) {
 		fputs(vtx, stdout);
 		fputc('\t', stdout);
-		fprintf(stdout, "%zu\n", el.z);
-	} else if (el.z >= cp->wl.w[0]) {
+		fprintf(stdout, "%zu\n", ne);
+	} else if (ne >= cp->wl.w[0]) {
 		size_t pos;
 
-		for (pos = 1; pos < cp->wl.z && el.z >= cp->wl.w[pos]; pos++);
+		for (pos = 1; pos < cp->wl.z && ne >= cp->wl.w[pos]; pos++);
 
 		/* pos - 1 is the position to insert to */
 		pos--;
 		memmove(cp->wl.d, cp->wl.d + 1, pos * sizeof(*cp->wl.d));
 		memmove(cp->wl.w, cp->wl.w + 1, pos * sizeof(*cp->wl.w));
 		cp->wl.d[pos] = vid;
-		cp->wl.w[pos] = el.z;
+		cp->wl.w[pos] = ne;
 	}
-	rotz_free_vtxlst(el);
 	return 0;
 }
 
 static void
 prnt_top(const struct iter_clo_s *cp)
 {
+	const char *const *s = NULL;
+
+	if (!idsp) {
+		s = rotz_names(ctx, nm, cp->wl.d, cp->wl.z);
+	}
 	for (size_t i = cp->wl.z; i-- > 0 && cp->wl.d[i];) {
-		prnt_wtx(cp->wl.d[i], cp->wl.w[i]);
+		prnt_wtx(cp->wl.d[i], s ? s[i] : NULL, cp->wl.w[i]);
 	}
 	return;
 }
@@ -125,33 +136,38 @@ pivot(const char *what)
 	rtz_vtx_t wid;
 	rtz_vtxlst_t el;
 	rtz_wtxlst_t wl = {0U};
+	rtz_arena_t ar;
 
 	if (!(wid = rotz_get_vertex(ctx, rotz_tag(what))) &&
 	    !(wid = rotz_get_vertex(ctx, rotz_sym(what)))) {
 		/* neither sym nor tag, better bugger off */
 		return;
-	} else if (UNLIKELY((el = rotz_get_edges(ctx, wid)).d == NULL)) {
+	} else if (UNLIKELY((ar = rotz_make_arena()) == NULL)) {
+		return;
+	} else if (UNLIKELY((el = rotz_get_edges_a(ctx, ar, wid)).d == NULL)) {
+		rotz_free_arena(ar);
 		return;
 	}
 
 	for (size_t i = 0; i < el.z; i++) {
 		rtz_vtx_t it = el.d[i];
 
-		wl = rotz_munion(ctx, wl, it);
+		wl = rotz_munion_a(ctx, ar, wl, it);
 	}
-	rotz_free_vtxlst(el);
 
-	/* sort and print */
+	/* sort, resolve and print */
 	sort_wtxlst(wl);
-	for (size_t i = 0; i < wl.z; i++) {
-		rtz_vtx_t it = wl.d[i];
-
-		if (UNLIKELY(it == wid)) {
-			continue;
+	with (const char *const *s = !idsp ? rotz_names(ctx, nm, wl.d, wl.z) : NULL) {
+		for (size_t i = 0; i < wl.z; i++) {
+			rtz_vtx_t it = wl.d[i];
+
+			if (UNLIKELY(it == wid)) {
+				continue;
+			}
+			prnt_wtx(it, s ? s[i] : NULL, wl.w[i] + 1U);
 		}
-		prnt_wtx(it, wl.w[i] + 1U);
 	}
-	rotz_free_wtxlst(wl);
+	rotz_free_arena(ar);
 	return;
 }
 
@@ -166,6 +182,7 @@ rotz_cmd_cloud(const struct yuck_cmd_cloud_s argi[static 1U])
 		fputs("Error opening rotz datastore\n", stderr);
 		return 1;
 	}
+	idsp = argi->ids_flag;
 
 	/* cloud all tags mode, undocumented prefix feature */
 	if (argi->nargs) {
@@ -188,6 +205,7 @@ rotz_cmd_cloud(const struct yuck_cmd_cloud_s argi[static 1U])
 	}
 
 	/* big rcource freeing */
+	rotz_names_free(nm);
 	free_rotz(ctx);
 	return 0;
 }
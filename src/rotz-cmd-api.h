@@ -42,12 +42,16 @@
 #include <string.h>
 #include <stdarg.h>
 #include <errno.h>
+#include "rotz.h"
 #include "nifty.h"
 
 #define RTZ_TAGSPC	"tag"
 #define RTZ_SYMSPC	":::"
 #define RTZ_PRE_Z	(4U)
 
+/* number of inputs that are resolved in one go */
+#define RTZ_BATCH_Z	(4096U)
+
 #if defined USE_LMDB
 # define RTZ_DFLT_DB	"rotz.mdb"
 #elif defined USE_TCBDB
@@ -63,7 +67,7 @@ static const char*
 rotz_glue(const char *pre, const char *str, size_t ssz)
 {
 /* produces PRE:STR, all *our* prefixes are 3 chars long */
-	static struct {
+	static __thread struct {
 		size_t z;
 		char *d;
 	} builder;
@@ -117,4 +121,132 @@ rotz_massage_name(const char *ts)
 	return ts;
 }
 
+/* batches of input strings */
+struct rtz_batch_s {
+	size_t n;
+	/* string space */
+	size_t i;
+	size_t z;
+	char *s;
+	/* offsets into string space */
+	size_t o[RTZ_BATCH_Z];
+	/* pointers into string space, as obtained by rotz_batch_seal() */
+	const char *d[RTZ_BATCH_Z];
+};
+
+static inline void
+rotz_batch_push(struct rtz_batch_s *b, const char *str, size_t ssz)
+{
+	if (UNLIKELY(b->i + ssz + 1U/*\nul*/ > b->z)) {
+		b->z = ((b->i + ssz + 1U) / 4096U + 1U) * 4096U;
+		b->s = realloc(b->s, b->z);
+	}
+	memcpy(b->s + b->i, str, ssz);
+	b->s[b->i + ssz] = '\0';
+	b->o[b->n++] = b->i;
+	b->i += ssz + 1U;
+	return;
+}
+
+static inline const char *const*
+rotz_batch_seal(struct rtz_batch_s *b)
+{
+	for (size_t i = 0U; i < b->n; i++) {
+		b->d[i] = b->s + b->o[i];
+	}
+	return b->d;
+}
+
+static inline void
+rotz_batch_clear(struct rtz_batch_s *b)
+{
+	b->n = 0U;
+	b->i = 0U;
+	return;
+}
+
+static inline void
+rotz_batch_free(struct rtz_batch_s *b)
+{
+	if (LIKELY(b->s != NULL)) {
+		free(b->s);
+	}
+	b->s = NULL;
+	b->z = 0U;
+	rotz_batch_clear(b);
+	return;
+}
+
+static inline void
+rotz_batch_push_glued(struct rtz_batch_s *b, const char *glued)
+{
+	/* rotz_glue() hands out NULL for empty strings */
+	if (UNLIKELY(glued == NULL)) {
+		glued = "";
+	}
+	rotz_batch_push(b, glued, strlen(glued));
+	return;
+}
+
+static inline size_t
+rotz_get_tagsyms(rotz_t ctx, rtz_vtx_t *restrict res, struct rtz_batch_s *in)
+{
+/* resolve the strings in IN as tags or, failing that, as syms */
+	static __thread struct rtz_batch_s nm[1U];
+	static __thread size_t mi[RTZ_BATCH_Z];
+	static __thread rtz_vtx_t mr[RTZ_BATCH_Z];
+	const char *const *ip = rotz_batch_seal(in);
+	size_t nres;
+
+	rotz_batch_clear(nm);
+	for (size_t i = 0U; i < in->n; i++) {
+		rotz_batch_push_glued(nm, rotz_tag(ip[i]));
+	}
+	nres = rotz_get_vertices(ctx, rotz_batch_seal(nm), nm->n, res);
+
+	/* retry the misses as syms */
+	rotz_batch_clear(nm);
+	for (size_t i = 0U; i < in->n; i++) {
+		if (res[i]) {
+			continue;
+		}
+		mi[nm->n] = i;
+		rotz_batch_push_glued(nm, rotz_sym(ip[i]));
+	}
+	nres += rotz_get_vertices(ctx, rotz_batch_seal(nm), nm->n, mr);
+	for (size_t i = 0U; i < nm->n; i++) {
+		res[mi[i]] = mr[i];
+	}
+	return nres;
+}
+
+/* batches of vertex names */
+struct rtz_names_s {
+	size_t z;
+	const char **d;
+	rtz_buf_t arena;
+};
+
+static inline const char *const*
+rotz_names(rotz_t ctx, struct rtz_names_s *nm, const rtz_vtx_t *v, size_t n)
+{
+	if (UNLIKELY(n > nm->z)) {
+		nm->z = ((n - 1U) / 64U + 1U) * 64U;
+		nm->d = realloc(nm->d, nm->z * sizeof(*nm->d));
+	}
+	rotz_get_names(ctx, v, n, nm->d, &nm->arena);
+	return nm->d;
+}
+
+static inline void
+rotz_names_free(struct rtz_names_s *nm)
+{
+	if (LIKELY(nm->d != NULL)) {
+		free(nm->d);
+	}
+	rotz_free_r(nm->arena);
+	*nm = (struct rtz_names_s){0U};
+	return;
+}
+
 #endif	/* INCLUDED_rotz_cmd_api_h_ */
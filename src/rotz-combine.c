@@ -47,34 +47,37 @@
 #include "rotz.h"
 #include "rotz-cmd-api.h"
 #include "rotz-umb.h"
+#include "rinput.h"
 #include "nifty.h"
 
 
 static void
 combine_into(rotz_t ctx, rtz_vtx_t into_tid, const char *tag)
 {
+/* merge TAG into INTO_TID and forget about TAG's names */
 	rtz_vtx_t tid;
-	rtz_vtxlst_t el;
+	rtz_buf_t al;
 
 	if (UNLIKELY((tag = rotz_tag(tag)) == NULL)) {
 		return;
 	} else if (UNLIKELY(!(tid = rotz_get_vertex(ctx, tag)))) {
 		return;
-	} else if (UNLIKELY((el = rotz_get_edges(ctx, tid)).d == NULL)) {
+	} else if (UNLIKELY(rotz_begin(ctx) < 0)) {
 		return;
 	}
-	/* otherwise combine TID into MASTER_TID by
-	 * traversing the edges of TID and adding them to MASTER_TID's */
-	for (rtz_vtx_t *p = el.d, *const ep = el.d + el.z; p < ep; p++) {
-		rotz_add_edge(ctx, into_tid, *p);
-		rotz_rem_edge(ctx, *p, tid);
-		rotz_add_edge(ctx, *p, into_tid);
+	/* names of TID, as they stand before the merge */
+	al = rotz_get_aliases(ctx, tid);
+	if (UNLIKELY(rotz_merge_vertices(ctx, into_tid, tid) < 0)) {
+		rotz_abort(ctx);
+		goto out;
 	}
-	rotz_free_vtxlst(el);
-	/* delete that vertex' edges */
-	rotz_rem_edges(ctx, tid);
-	/* now delete the whole vertex */
-	rotz_rem_vertex(ctx, tag);
+	for (const char *x = al.d, *const ex = al.d + al.z;
+	     x < ex; x += strlen(x) + 1U) {
+		rotz_rem_alias(ctx, x);
+	}
+	rotz_commit(ctx);
+out:
+	rotz_free_r(al);
 	return;
 }
 
@@ -88,9 +91,8 @@ combine_tag(rotz_t ctx, const char *tag)
 		master_tid = rotz_get_vertex(ctx, rotz_tag(tag));
 		return;
 	}
-	combine_into(ctx, master_tid, tag);
-	/* and add it as an alias for master_tid */
-	rotz_add_alias(ctx, master_tid, rotz_tag(tag));
+	/* merging makes TAG's names aliases of MASTER_TID */
+	rotz_merge_vertices(ctx, master_tid, rotz_get_vertex(ctx, rotz_tag(tag)));
 	return;
 }
 
@@ -100,6 +102,7 @@ int
 rotz_cmd_combine(const struct yuck_cmd_combine_s argi[static 1U])
 {
 	rotz_t ctx;
+	int rc = 0;
 
 	if (UNLIKELY((ctx = make_rotz(db, O_CREAT | O_RDWR)) == NULL)) {
 		fputs("Error opening rotz datastore\n", stderr);
@@ -125,21 +128,29 @@ Error moving into tag %s, no such tag\n", tag);
 		}
 	} else if (!isatty(STDIN_FILENO)) {
 		/* combine tags from stdin */
-		char *line = NULL;
-		size_t llen = 0U;
-		ssize_t nrd;
+		rinput_t rd = make_rinput(STDIN_FILENO);
+		char *line;
+		size_t llen;
 
-		while ((nrd = getline(&line, &llen, stdin)) > 0) {
-			line[nrd - 1] = '\0';
+		if (UNLIKELY(rd == NULL)) {
+			fputs("Error: cannot read from stdin\n", stderr);
+			rc = 1;
+			goto fina;
+		}
+		while ((line = rinput_line(rd, &llen)) != NULL) {
 			combine_tag(ctx, line);
 		}
-		free(line);
+		if (UNLIKELY(rinput_err(rd))) {
+			fputs("Error: cannot read from stdin\n", stderr);
+			rc = 1;
+		}
+		free_rinput(rd);
 	}
 
 fina:
 	/* big rcource freeing */
 	free_rotz(ctx);
-	return 0;
+	return rc;
 }
 #endif	/* STANDALONE */
 
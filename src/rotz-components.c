@@ -0,0 +1,175 @@
+/*** rotz-components.c -- rotz connected components
+ *
+ * Copyright (C) 2013-2014 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of rotz.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "rotz.h"
+#include "rgraph.h"
+#include "rotz-cmd-api.h"
+#include "rotz-umb.h"
+#include "routput.h"
+#include "raux.h"
+#include "nifty.h"
+
+
+static int
+tally(rtz_wtxlst_t *restrict res, rtz_vtxlst_t cc)
+{
+/* count component sizes, components are identified by their smallest
+ * member so the representatives come first */
+	unsigned int *cnt = calloc(cc.z, sizeof(*cnt));
+	size_t n = 0U;
+	int rc = 0;
+
+	*res = (rtz_wtxlst_t){0U};
+	if (UNLIKELY(cnt == NULL)) {
+		return -1;
+	}
+	for (size_t v = 0U; v < cc.z; v++) {
+		if (cc.d[v]) {
+			n += !cnt[cc.d[v]]++;
+		}
+	}
+	if (UNLIKELY(!n)) {
+		goto out;
+	}
+	res->d = malloc(n * sizeof(*res->d));
+	res->w = malloc(n * sizeof(*res->w));
+	if (UNLIKELY(res->d == NULL || res->w == NULL)) {
+		rotz_free_wtxlst(*res);
+		*res = (rtz_wtxlst_t){0U};
+		rc = -1;
+		goto out;
+	}
+	for (size_t v = 0U; v < cc.z; v++) {
+		if (cnt[v]) {
+			res->d[res->z] = v;
+			res->w[res->z] = cnt[v];
+			res->z++;
+		}
+	}
+out:
+	free(cnt);
+	return rc;
+}
+
+
+#if defined STANDALONE
+int
+rotz_cmd_components(const struct yuck_cmd_components_s argi[static 1U])
+{
+	static struct rtz_names_s nm[1U];
+	unsigned int nthr = 1U;
+	rtz_vtxlst_t cc;
+	rtz_wtxlst_t wl;
+	routput_t out;
+	rotz_t ctx;
+
+	if (argi->threads_arg) {
+		nthr = strtoul(argi->threads_arg, NULL, 0);
+	}
+
+	if (UNLIKELY((ctx = make_rotz(db)) == NULL)) {
+		fputs("Error opening rotz datastore\n", stderr);
+		return 1;
+	}
+
+	/* label them components */
+	cc = rotz_components(ctx, nthr);
+	if (UNLIKELY(cc.d == NULL && rotz_get_maxid(ctx))) {
+		fputs("Error: cannot label components\n", stderr);
+		free_rotz(ctx);
+		return 1;
+	} else if (UNLIKELY(tally(&wl, cc) < 0)) {
+		fputs("Error: cannot tally components\n", stderr);
+		rotz_free_vtxlst(cc);
+		free_rotz(ctx);
+		return 1;
+	}
+	rotz_free_vtxlst(cc);
+
+	/* largest first */
+	if (argi->top_arg) {
+		wl.z = top_wtxlst(wl, strtoul(argi->top_arg, NULL, 0));
+	} else {
+		sort_wtxlst_mt(wl, nthr);
+	}
+
+	if (UNLIKELY((out = make_routput(STDOUT_FILENO)) == NULL)) {
+		fputs("Error: cannot allocate output buffer\n", stderr);
+		rotz_free_wtxlst(wl);
+		free_rotz(ctx);
+		return 1;
+	} else if (argi->ids_flag) {
+		for (size_t i = 0U; i < wl.z; i++) {
+			routput_u(out, wl.d[i]);
+			routput_chr(out, '\t');
+			routput_u(out, wl.w[i]);
+			routput_chr(out, '\n');
+		}
+	} else {
+		const char *const *s = rotz_names(ctx, nm, wl.d, wl.z);
+
+		for (size_t i = 0U; i < wl.z; i++) {
+			if (LIKELY(s[i] != NULL)) {
+				routput_str(out, rotz_massage_name(s[i]));
+			} else {
+				/* dangling edges, print the id at least */
+				routput_u(out, wl.d[i]);
+			}
+			routput_chr(out, '\t');
+			routput_u(out, wl.w[i]);
+			routput_chr(out, '\n');
+		}
+	}
+	free_routput(out);
+
+	/* big rcource freeing */
+	rotz_free_wtxlst(wl);
+	rotz_names_free(nm);
+	free_rotz(ctx);
+	return 0;
+}
+#endif	/* STANDALONE */
+
+/* rotz-components.c ends here */
@@ -47,21 +47,20 @@
 #include "rotz.h"
 #include "rotz-cmd-api.h"
 #include "rotz-umb.h"
+#include "rinput.h"
 #include "nifty.h"
 
 
 static int verbosep;
 #define _		rotz_massage_name
 
+static struct rtz_batch_s in[1U];
+static struct rtz_batch_s nm[1U];
+
 static void
-del_tag(rotz_t ctx, rtz_vtx_t tid, const char *sym)
+del_tag(rotz_t ctx, rtz_vtx_t tid, const char *sym, rtz_vtx_t sid)
 {
-	const char *symspc_sym;
-	rtz_vtx_t sid;
-
-	if (UNLIKELY((symspc_sym = rotz_sym(sym)) == NULL)) {
-		return;
-	} else if (LIKELY((sid = rotz_get_vertex(ctx, symspc_sym)) == 0U)) {
+	if (LIKELY(sid == 0U)) {
 		if (UNLIKELY(verbosep)) {
 			fprintf(stderr, "\
 Error: cannot find sym `%s' in database file\n", sym);
@@ -77,43 +76,69 @@ Error: cannot find sym `%s' in database file\n", sym);
 		fputc('\n', stdout);
 	}
 
-	rotz_rem_edge(ctx, tid, sid);
 	rotz_rem_edge(ctx, sid, tid);
 	return;
 }
 
 static void
-del_vtx(rotz_t ctx, const char *v)
+del_vtx(rotz_t ctx, const char *v, rtz_vtx_t vid)
 {
-	rtz_vtxlst_t el;
-	rtz_vtx_t vid;
-
-	if (UNLIKELY((vid = rotz_get_vertex(ctx, v)) == 0U)) {
+	if (UNLIKELY(vid == 0U)) {
 		/* not sure what to delete */
 		return;
-	} else if (LIKELY((el = rotz_get_edges(ctx, vid)).d == NULL)) {
-		/* nothing to delete */
-		;
-	} else {
-		/* get rid of all the edges */
-		rotz_rem_edges(ctx, vid);
-
-		/* now go through the list EL and delete TID */
+	} else if (UNLIKELY(verbosep)) {
+		rtz_vtxlst_t el = rotz_get_edges(ctx, vid);
+
 		for (size_t i = 0; i < el.z; i++) {
-			if (UNLIKELY(verbosep)) {
-				fputc('-', stdout);
-				fputs(_(rotz_get_name(ctx, vid)), stdout);
-				fputc('\t', stdout);
-				fputs(_(rotz_get_name(ctx, el.d[i])), stdout);
-				fputc('\n', stdout);
-			}
-			rotz_rem_edge(ctx, el.d[i], vid);
+			fputc('-', stdout);
+			fputs(_(rotz_get_name(ctx, vid)), stdout);
+			fputc('\t', stdout);
+			fputs(_(rotz_get_name(ctx, el.d[i])), stdout);
+			fputc('\n', stdout);
 		}
 		/* finalise the list */
 		rotz_free_vtxlst(el);
 	}
-	/* finally delete the vertex */
-	rotz_rem_vertex(ctx, v);
+	/* neighbours keep a tombstone until the next rotz compact */
+	rotz_drop_vertex(ctx, v);
+	return;
+}
+
+static void
+del_batch(rotz_t ctx, rtz_vtx_t tid)
+{
+/* delete the syms in IN from TID or, if TID is 0, delete the
+ * vertices in IN altogether, NM holds the namespacified names */
+	static rtz_vtx_t ids[RTZ_BATCH_Z];
+	const char *const *ip = rotz_batch_seal(in);
+	const char *const *np = rotz_batch_seal(nm);
+
+	/* resolve the whole batch first */
+	rotz_get_vertices(ctx, np, nm->n, ids);
+	for (size_t i = 0U; i < nm->n; i++) {
+		if (tid) {
+			del_tag(ctx, tid, ip[i], ids[i]);
+		} else {
+			del_vtx(ctx, np[i], ids[i]);
+		}
+	}
+	if (tid) {
+		/* TID's edge list is rewritten just once */
+		rotz_rem_edges_bulk(ctx, tid, ids, nm->n);
+	}
+	rotz_batch_clear(in);
+	rotz_batch_clear(nm);
+	return;
+}
+
+static void
+del_input(rotz_t ctx, rtz_vtx_t tid, const char *s, const char *glued)
+{
+	rotz_batch_push(in, s, strlen(s));
+	rotz_batch_push_glued(nm, glued);
+	if (UNLIKELY(nm->n >= RTZ_BATCH_Z)) {
+		del_batch(ctx, tid);
+	}
 	return;
 }
 
@@ -121,7 +146,7 @@ static void
 del_syms(rotz_t ctx, const char *tag)
 {
 	/* massage tag */
-	del_vtx(ctx, rotz_tag(tag));
+	del_input(ctx, 0U, tag, rotz_tag(tag));
 	return;
 }
 
@@ -129,16 +154,17 @@ static void
 del_sym(rotz_t ctx, const char *sym)
 {
 	/* massage sym */
-	del_vtx(ctx, rotz_sym(sym));
+	del_input(ctx, 0U, sym, rotz_sym(sym));
 	return;
 }
 
-
+
 #if defined STANDALONE
 int
 rotz_cmd_del(const struct yuck_cmd_del_s argi[static 1U])
 {
 	rotz_t ctx;
+	int rc = 0;
 
 	if (argi->verbose_flag) {
 		verbosep = 1;
@@ -161,16 +187,20 @@ Error: cannot find tag `%s' in database file, no deletions\n", argi->args[0U]);
 			goto fini;
 		}
 		for (size_t i = 1U; i < argi->nargs; i++) {
-			del_tag(ctx, tid, argi->args[i]);
+			const char *sym = argi->args[i];
+
+			del_input(ctx, tid, sym, rotz_sym(sym));
 		}
+		del_batch(ctx, tid);
 	} else if (argi->nargs == 1U && isatty(STDIN_FILENO)) {
 		/* del all syms assoc'd with TAG */
 		del_syms(ctx, argi->args[0U]);
+		del_batch(ctx, 0U);
 	} else if (argi->nargs == 1U) {
 		/* del tag/sym pairs from stdin */
-		char *line = NULL;
-		size_t llen = 0U;
-		ssize_t nrd;
+		rinput_t rd;
+		char *line;
+		size_t llen;
 		const char *tag;
 		rtz_vtx_t tid;
 
@@ -183,35 +213,54 @@ Error: cannot find tag `%s' in database file, no deletions\n", argi->args[0U]);
 			goto fini;
 		}
 
-		while ((nrd = getline(&line, &llen, stdin)) > 0) {
-			line[nrd - 1] = '\0';
-			del_tag(ctx, tid, line);
+		if (UNLIKELY((rd = make_rinput(STDIN_FILENO)) == NULL)) {
+			fputs("Error: cannot read from stdin\n", stderr);
+			rc = 1;
+			goto fini;
+		}
+		while ((line = rinput_line(rd, &llen)) != NULL) {
+			del_input(ctx, tid, line, rotz_sym(line));
 		}
-		free(line);
+		if (UNLIKELY(rinput_err(rd))) {
+			fputs("Error: cannot read from stdin\n", stderr);
+			rc = 1;
+		}
+		free_rinput(rd);
+		del_batch(ctx, tid);
 	} else if (!isatty(STDIN_FILENO)) {
 		/* del tags from stdin */
-		char *line = NULL;
-		size_t llen = 0U;
-		ssize_t nrd;
+		rinput_t rd = make_rinput(STDIN_FILENO);
+		char *line;
+		size_t llen;
 
+		if (UNLIKELY(rd == NULL)) {
+			fputs("Error: cannot read from stdin\n", stderr);
+			rc = 1;
+			goto fini;
+		}
 		if (argi->syms_flag) {
-			while ((nrd = getline(&line, &llen, stdin)) > 0) {
-				line[nrd - 1] = '\0';
+			while ((line = rinput_line(rd, &llen)) != NULL) {
 				del_sym(ctx, line);
 			}
 		} else {
-			while ((nrd = getline(&line, &llen, stdin)) > 0) {
-				line[nrd - 1] = '\0';
+			while ((line = rinput_line(rd, &llen)) != NULL) {
 				del_syms(ctx, line);
 			}
 		}
-		free(line);
+		if (UNLIKELY(rinput_err(rd))) {
+			fputs("Error: cannot read from stdin\n", stderr);
+			rc = 1;
+		}
+		free_rinput(rd);
+		del_batch(ctx, 0U);
 	}
 
 fini:
 	/* big rcource freeing */
+	rotz_batch_free(in);
+	rotz_batch_free(nm);
 	free_rotz(ctx);
-	return 0;
+	return rc;
 }
 #endif	/* STANDALONE */
 
@@ -37,150 +37,976 @@
 #if defined HAVE_CONFIG_H
 # include "config.h"
 #endif	/* HAVE_CONFIG_H */
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <endian.h>
+#include <sys/stat.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
 #include <stdio.h>
+#include <limits.h>
+#include <pthread.h>
 
 #include "rotz.h"
+#include "rgraph.h"
 #include "rotz-cmd-api.h"
 #include "rotz-umb.h"
+#include "routput.h"
 #include "nifty.h"
 
 static int clusterp;
+static int idsp;
+static struct rtz_names_s nm[1U];
+/* for the projections' other end */
+static struct rtz_names_s nm2[1U];
+static routput_t out;
+
+/* id -> canonical name, preloaded for the partitioned scans */
+static struct {
+	rtz_vtx_t z;
+	const char **d;
+	rtz_buf_t arena;
+	int err;
+} ntab;
+
+/* per-scanner state */
+struct xprt_s {
+	rotz_t ctx;
+	routput_t out;
+	struct rtz_names_s nm[1U];
+	rtz_buf_t n;
+	/* set when the names of a target list could not be had */
+	int err;
+};
+
 
-
 static int
-iter_csv_cb(rtz_vtx_t vid, rtz_const_vtxlst_t vl, void *clo)
+ntab_cb(rtz_vtx_t vid, const char *vtx, void *clo)
 {
-	rtz_buf_t n = rotz_get_name_r(clo, vid);
-	const char *vtx = n.d;
+	size_t *off = clo;
+	const size_t vz = strlen(vtx) + 1U;
+	size_t nu;
 
-	if (memcmp(vtx, RTZ_SYMSPC, sizeof(RTZ_SYMSPC) - 1) == 0) {
-		/* that's a symbol, vtx would be a tag then */
+	if (UNLIKELY(vid >= ntab.z)) {
+		/* db's lying about maxid */
 		return 0;
+	}
+	/* offset 0 is reserved for unknown vertices */
+	if (UNLIKELY((nu = off[0U] + vz) > ntab.arena.z)) {
+		size_t nz = ntab.arena.z * 2U;
+		char *nd;
+
+		while (nz < nu) {
+			nz *= 2U;
+		}
+		if (UNLIKELY((nd = realloc(ntab.arena.d, nz)) == NULL)) {
+			ntab.err = -1;
+			return -1;
+		}
+		ntab.arena = (rtz_buf_t){nz, nd};
+	}
+	memcpy(ntab.arena.d + off[0U], vtx, vz);
+	off[vid] = off[0U];
+	off[0U] = nu;
+	return 0;
+}
+
+static int
+load_ntab(rotz_t ctx)
+{
+	size_t *off;
+
+	ntab.z = rotz_get_maxid(ctx) + 1U;
+	if (UNLIKELY((off = calloc(ntab.z, sizeof(*off))) == NULL)) {
+		return -1;
+	} else if (UNLIKELY((ntab.arena.d = malloc(64U * 1024U)) == NULL)) {
+		free(off);
+		return -1;
+	}
+	ntab.arena.z = 64U * 1024U;
+	/* unused slot 0 doubles as fill level */
+	off[0U] = 1U;
+	rotz_vtx_iter(ctx, ntab_cb, off);
+	if (UNLIKELY(ntab.err < 0)) {
+		/* a partial table would export unnamed targets */
+		free(off);
+		rotz_free_r(ntab.arena);
+		ntab.arena = (rtz_buf_t){0U};
+		return -1;
+	}
+
+	/* only now that the arena stays put can we turn offsets to pointers */
+	ntab.d = (const char**)off;
+	for (rtz_vtx_t i = 1U; i < ntab.z; i++) {
+		ntab.d[i] = off[i] ? ntab.arena.d + off[i] : NULL;
+	}
+	ntab.d[0U] = NULL;
+	return 0;
+}
+
+static void
+free_ntab(void)
+{
+	if (ntab.d != NULL) {
+		free(ntab.d);
+		rotz_free_r(ntab.arena);
+	}
+	return;
+}
+
+static const char *const*
+xprt_names(struct xprt_s *x, rtz_const_vtxlst_t vl)
+{
+	if (ntab.d == NULL) {
+		/* resolve all targets in one go */
+		return rotz_names(x->ctx, x->nm, vl.d, vl.z);
+	}
+	if (UNLIKELY(vl.z > x->nm->z)) {
+		const size_t nz = ((vl.z - 1U) / 64U + 1U) * 64U;
+		const char **nd = realloc(x->nm->d, nz * sizeof(*nd));
+
+		if (UNLIKELY(nd == NULL)) {
+			return NULL;
+		}
+		x->nm->d = nd;
+		x->nm->z = nz;
+	}
+	for (size_t i = 0U; i < vl.z; i++) {
+		x->nm->d[i] = vl.d[i] < ntab.z ? ntab.d[vl.d[i]] : NULL;
+	}
+	return x->nm->d;
+}
+
+static const char*
+xprt_src(struct xprt_s *x, rtz_vtx_t vid, size_t *vz)
+{
+/* return the name of source vertex VID as it should be printed and put
+ * its length into VZ, or NULL if VID is a symbol */
+	const char *vtx;
+
+	if (ntab.d != NULL) {
+		vtx = vid < ntab.z ? ntab.d[vid] : NULL;
+	} else {
+		rotz_free_r(x->n);
+		x->n = rotz_get_name_r(x->ctx, vid);
+		vtx = x->n.d;
+	}
+
+	if (UNLIKELY(vtx == NULL)) {
+		return NULL;
+	} else if (memcmp(vtx, RTZ_SYMSPC, sizeof(RTZ_SYMSPC) - 1) == 0) {
+		/* that's a symbol, vtx would be a tag then */
+		return NULL;
 	} else if (memcmp(vtx, RTZ_TAGSPC, sizeof(RTZ_TAGSPC) - 1) == 0) {
 		vtx += RTZ_PRE_Z;
-	} else if (clusterp) {
-		char *p = strchr(vtx, ':');
-		*p = '\0';
+		*vz = strlen(vtx);
+	} else if (clusterp && !idsp) {
+		const char *p = strchr(vtx, ':');
+		*vz = p ? (size_t)(p - vtx) : strlen(vtx);
+	} else {
+		*vz = strlen(vtx);
 	}
+	return vtx;
+}
 
-	for (size_t i = 0; i < vl.z; i++) {
-		const char *vld = rotz_get_name(clo, vl.d[i]);
-		const char *tgt = rotz_massage_name(vld);
+static void
+xprt_fini(struct xprt_s *x)
+{
+	rotz_names_free(x->nm);
+	rotz_free_r(x->n);
+	return;
+}
 
-		fputs(vtx, stdout);
-		fputc('\t', stdout);
-		fputs(tgt, stdout);
-		fputc('\n', stdout);
+
+static int
+iter_csv_cb(rtz_vtx_t vid, rtz_const_vtxlst_t vl, void *clo)
+{
+	struct xprt_s *x = clo;
+	routput_t o = x->out;
+	const char *vtx;
+	size_t vz;
+
+	if ((vtx = xprt_src(x, vid, &vz)) == NULL) {
+		return 0;
+	} else if (idsp) {
+		for (size_t i = 0; i < vl.z; i++) {
+			routput_u(o, vid);
+			routput_chr(o, '\t');
+			routput_u(o, vl.d[i]);
+			routput_chr(o, '\n');
+		}
+		return 0;
+	}
+	with (const char *const *s = xprt_names(x, vl)) {
+		if (UNLIKELY(s == NULL)) {
+			x->err = -1;
+			return -1;
+		}
+		for (size_t i = 0; i < vl.z; i++) {
+			const char *tgt = rotz_massage_name(s[i]);
+
+			routput_buf(o, vtx, vz);
+			routput_chr(o, '\t');
+			routput_str(o, tgt);
+			routput_chr(o, '\n');
+		}
 	}
-	rotz_free_r(n);
 	return 0;
 }
 
 static int
 iter_dot_cb(rtz_vtx_t vid, rtz_const_vtxlst_t vl, void *clo)
 {
-	rtz_buf_t n = rotz_get_name_r(clo, vid);
-	const char *vtx = n.d;
+	struct xprt_s *x = clo;
+	routput_t o = x->out;
+	const char *vtx;
+	size_t vz;
 
-	if (memcmp(vtx, RTZ_SYMSPC, sizeof(RTZ_SYMSPC) - 1) == 0) {
-		/* that's a symbol, vtx would be a tag then */
+	if ((vtx = xprt_src(x, vid, &vz)) == NULL) {
+		return 0;
+	} else if (idsp) {
+		for (size_t i = 0; i < vl.z; i++) {
+			routput_buf(o, "  ", 2U);
+			routput_u(o, vid);
+			routput_buf(o, " -- ", 4U);
+			routput_u(o, vl.d[i]);
+			routput_buf(o, ";\n", 2U);
+		}
 		return 0;
-	} else if (memcmp(vtx, RTZ_TAGSPC, sizeof(RTZ_TAGSPC) - 1) == 0) {
-		vtx += RTZ_PRE_Z;
-	} else if (clusterp) {
-		char *p = strchr(vtx, ':');
-		*p = '\0';
 	}
+	with (const char *const *s = xprt_names(x, vl)) {
+		if (UNLIKELY(s == NULL)) {
+			x->err = -1;
+			return -1;
+		}
+		for (size_t i = 0; i < vl.z; i++) {
+			const char *tgt = rotz_massage_name(s[i]);
 
-	for (size_t i = 0; i < vl.z; i++) {
-		const char *vld = rotz_get_name(clo, vl.d[i]);
-		const char *tgt = rotz_massage_name(vld);
-
-		printf("  \"%s\" -- \"%s\";\n", vtx, tgt);
+			routput_buf(o, "  \"", 3U);
+			routput_buf(o, vtx, vz);
+			routput_buf(o, "\" -- \"", 6U);
+			routput_str(o, tgt);
+			routput_buf(o, "\";\n", 3U);
+		}
 	}
-	rotz_free_r(n);
 	return 0;
 }
 
 static int
 iter_gmlv_cb(rtz_vtx_t vid, const char *vtx, void *UNUSED(clo))
 {
-	printf("\
-  node [\n\
-    id %u\n\
-    label \"%s\"\n\
-  ]\n", vid, rotz_massage_name(vtx));
+	static const char pre[] = "  node [\n    id ";
+
+	routput_buf(out, pre, sizeof(pre) - 1U);
+	routput_u(out, vid);
+	if (!idsp) {
+		routput_buf(out, "\n    label \"", 12U);
+		routput_str(out, rotz_massage_name(vtx));
+		routput_chr(out, '"');
+	}
+	routput_buf(out, "\n  ]\n", 5U);
 	return 0;
 }
 
 static int
 iter_gmle_cb(rtz_vtx_t sid, rtz_const_vtxlst_t vl, void *clo)
 {
-	const char *stx = rotz_get_name(clo, sid);
+	struct xprt_s *x = clo;
+	routput_t o = x->out;
+	size_t sz;
 
-	if (memcmp(stx, RTZ_SYMSPC, sizeof(RTZ_SYMSPC) - 1) == 0) {
+	if (xprt_src(x, sid, &sz) == NULL) {
 		return 0;
 	}
 
 	for (size_t i = 0; i < vl.z; i++) {
 		rtz_vtx_t tid = vl.d[i];
 
-		printf("\
-  edge [\n\
-    source %u\n\
-    target %u\n\
-  ]\n", sid, tid);
+		routput_buf(o, "  edge [\n    source ", 20U);
+		routput_u(o, sid);
+		routput_buf(o, "\n    target ", 12U);
+		routput_u(o, tid);
+		routput_buf(o, "\n  ]\n", 5U);
 	}
 	return 0;
 }
 
-static void
-xprt_csv(rotz_t ctx)
+
+/* partitioned scans */
+struct xslc_s {
+	rotz_t ctx;
+	int(*cb)(rtz_vtx_t, rtz_const_vtxlst_t, void*);
+	/* per-slice header and footer, for shards */
+	const char *hdr;
+	const char *ftr;
+	/* number of slices, next slice to be claimed */
+	unsigned int n;
+	unsigned int next;
+	/* one sink per slice */
+	const int *fds;
+	int err;
+};
+
+static void*
+xprt_slices(void *clo)
 {
+	struct xslc_s *q = clo;
+	struct xprt_s x = {.ctx = q->ctx};
+	unsigned int i;
+
+	while ((i = __atomic_fetch_add(&q->next, 1U, __ATOMIC_RELAXED)) < q->n) {
+		if (UNLIKELY((x.out = make_routput(q->fds[i])) == NULL)) {
+			__atomic_store_n(&q->err, 1, __ATOMIC_RELAXED);
+			continue;
+		}
+		if (q->hdr) {
+			routput_str(x.out, q->hdr);
+		}
+		rotz_edg_iter_slice(q->ctx, i, q->n, q->cb, &x);
+		if (q->ftr) {
+			routput_str(x.out, q->ftr);
+		}
+		if (UNLIKELY(free_routput(x.out) < 0 || x.err < 0)) {
+			__atomic_store_n(&q->err, 1, __ATOMIC_RELAXED);
+		}
+	}
+	xprt_fini(&x);
+	return NULL;
+}
+
+static int
+xprt_par(struct xslc_s *q, unsigned int nthr)
+{
+	pthread_t *th;
+	unsigned int t = 0U;
+
+	if (UNLIKELY(load_ntab(q->ctx) < 0)) {
+		return -1;
+	} else if (nthr > q->n) {
+		/* no point in idle threads */
+		nthr = q->n;
+	}
+	if (UNLIKELY((th = malloc(nthr * sizeof(*th))) == NULL)) {
+		nthr = 0U;
+	}
+	for (; t < nthr; t++) {
+		if (UNLIKELY(pthread_create(th + t, NULL, xprt_slices, q))) {
+			break;
+		}
+	}
+	if (UNLIKELY(t == 0U)) {
+		/* do it ourselves then */
+		xprt_slices(q);
+	}
+	while (t-- > 0U) {
+		pthread_join(th[t], NULL);
+	}
+	free(th);
+	return -q->err;
+}
+
+static int
+xprt_cat(rotz_t ctx, int(*cb)(rtz_vtx_t, rtz_const_vtxlst_t, void*),
+	 unsigned int nthr)
+{
+/* scan 4 slices per thread into temp files and append them to OUT */
+	const unsigned int n = nthr < UINT_MAX / 4U ? 4U * nthr : UINT_MAX;
+	FILE **tmp;
+	int *fds;
+	struct xslc_s q = {ctx, cb, .n = n};
+	int rc = 0;
+	unsigned int j = 0U;
+
+	if (UNLIKELY((tmp = malloc(n * sizeof(*tmp))) == NULL)) {
+		return -1;
+	} else if (UNLIKELY((fds = malloc(n * sizeof(*fds))) == NULL)) {
+		free(tmp);
+		return -1;
+	}
+	q.fds = fds;
+	for (; j < n; j++) {
+		if (UNLIKELY((tmp[j] = tmpfile()) == NULL)) {
+			rc = -1;
+			goto clo;
+		}
+		fds[j] = fileno(tmp[j]);
+	}
+	if (UNLIKELY((rc = xprt_par(&q, nthr)) < 0)) {
+		goto clo;
+	}
+	for (j = 0U; j < n; j++) {
+		char buf[65536U];
+		ssize_t nrd;
+
+		lseek(fds[j], 0, SEEK_SET);
+		while ((nrd = read(fds[j], buf, sizeof(buf))) > 0) {
+			routput_buf(out, buf, nrd);
+		}
+		if (UNLIKELY(nrd < 0)) {
+			rc = -1;
+			break;
+		}
+	}
+clo:
+	while (j-- > 0U) {
+		fclose(tmp[j]);
+	}
+	free(tmp);
+	free(fds);
+	return rc;
+}
+
+static int
+xprt_split(
+	rotz_t ctx, int(*cb)(rtz_vtx_t, rtz_const_vtxlst_t, void*),
+	unsigned int nthr, unsigned int n, const char *pre, const char *ext,
+	const char *hdr, const char *ftr)
+{
+/* scan N slices into files PRE.<j>.EXT */
+	int *fds;
+	struct xslc_s q = {ctx, cb, hdr, ftr, .n = n};
+	int rc = 0;
+	unsigned int j = 0U;
+
+	if (UNLIKELY((fds = malloc(n * sizeof(*fds))) == NULL)) {
+		return -1;
+	}
+	q.fds = fds;
+	for (; j < n; j++) {
+		char fn[PATH_MAX];
+
+		snprintf(fn, sizeof(fn), "%s.%u.%s", pre, j, ext);
+		if (UNLIKELY((fds[j] = open(
+				      fn, O_WRONLY | O_CREAT | O_TRUNC,
+				      0666)) < 0)) {
+			fprintf(stderr, "Error: cannot open shard `%s'\n", fn);
+			rc = -1;
+			goto clo;
+		}
+	}
+	rc = xprt_par(&q, nthr);
+clo:
+	while (j-- > 0U) {
+		close(fds[j]);
+	}
+	free(fds);
+	return rc;
+}
+
+static int
+xprt_csv(rotz_t ctx, unsigned int nthr)
+{
+	int rc = 0;
+
 	/* go through all edges */
-	rotz_edg_iter(ctx, iter_csv_cb, ctx);
-	return;
+	if (nthr > 1U) {
+		rc = xprt_cat(ctx, iter_csv_cb, nthr);
+	} else {
+		struct xprt_s x = {.ctx = ctx, .out = out};
+
+		rotz_edg_iter(ctx, iter_csv_cb, &x);
+		xprt_fini(&x);
+		rc = x.err;
+	}
+	return rc;
 }
 
-static void
-xprt_dot(rotz_t ctx)
+static int
+xprt_dot(rotz_t ctx, unsigned int nthr)
 {
-	puts("graph rotz {");
+	int rc = 0;
+
+	routput_str(out, "graph rotz {\n");
 
 	/* go through all edges */
-	rotz_edg_iter(ctx, iter_dot_cb, ctx);
+	if (nthr > 1U) {
+		rc = xprt_cat(ctx, iter_dot_cb, nthr);
+	} else {
+		struct xprt_s x = {.ctx = ctx, .out = out};
 
-	puts("}");
-	return;
+		rotz_edg_iter(ctx, iter_dot_cb, &x);
+		xprt_fini(&x);
+		rc = x.err;
+	}
+
+	routput_str(out, "}\n");
+	return rc;
 }
 
-static void
-xprt_gml(rotz_t ctx)
+static int
+xprt_gml(rotz_t ctx, unsigned int nthr)
 {
-	puts("\
-graph [\n\
-  directed 0\n\
-  id 0\n");
+	int rc = 0;
+
+	routput_str(out, "graph [\n  directed 0\n  id 0\n\n");
 
 	/* go through all vertices */
 	rotz_vtx_iter(ctx, iter_gmlv_cb, ctx);
 
 	/* go through all edges */
-	rotz_edg_iter(ctx, iter_gmle_cb, ctx);
+	if (nthr > 1U) {
+		rc = xprt_cat(ctx, iter_gmle_cb, nthr);
+	} else {
+		struct xprt_s x = {.ctx = ctx, .out = out};
+
+		rotz_edg_iter(ctx, iter_gmle_cb, &x);
+		xprt_fini(&x);
+		rc = x.err;
+	}
+
+	routput_str(out, "]\n");
+	return rc;
+}
+
+/* projections */
+static int
+symp(rtz_vtx_t UNUSED(vid), const char *vtx, void *UNUSED(clo))
+{
+	return !memcmp(vtx, RTZ_SYMSPC, sizeof(RTZ_SYMSPC) - 1);
+}
+
+static int
+tagp(rtz_vtx_t vid, const char *vtx, void *clo)
+{
+	return !symp(vid, vtx, clo);
+}
+
+static int
+iter_gmlv_proj_cb(rtz_vtx_t vid, const char *vtx, void *clo)
+{
+	int(*vtxp)(rtz_vtx_t, const char*, void*) = clo;
+
+	if (!vtxp(vid, vtx, NULL)) {
+		return 0;
+	}
+	return iter_gmlv_cb(vid, vtx, NULL);
+}
+
+static void
+xprt_proj_csv(rotz_t ctx, rtz_wedglst_t el)
+{
+	const char *const *fs;
+	const char *const *ts;
+
+	if (idsp) {
+		for (size_t i = 0U; i < el.z; i++) {
+			routput_u(out, el.from[i]);
+			routput_chr(out, '\t');
+			routput_u(out, el.to[i]);
+			routput_chr(out, '\t');
+			routput_u(out, el.w[i]);
+			routput_chr(out, '\n');
+		}
+		return;
+	}
+	/* resolve both ends in one go each */
+	fs = rotz_names(ctx, nm, el.from, el.z);
+	ts = rotz_names(ctx, nm2, el.to, el.z);
+	for (size_t i = 0U; i < el.z; i++) {
+		routput_str(out, rotz_massage_name(fs[i]));
+		routput_chr(out, '\t');
+		routput_str(out, rotz_massage_name(ts[i]));
+		routput_chr(out, '\t');
+		routput_u(out, el.w[i]);
+		routput_chr(out, '\n');
+	}
+	return;
+}
 
-	puts("]");
+static void
+xprt_proj_dot(rotz_t ctx, rtz_wedglst_t el)
+{
+	routput_str(out, "graph rotz {\n");
+
+	if (idsp) {
+		for (size_t i = 0U; i < el.z; i++) {
+			routput_buf(out, "  ", 2U);
+			routput_u(out, el.from[i]);
+			routput_buf(out, " -- ", 4U);
+			routput_u(out, el.to[i]);
+			routput_buf(out, " [weight=", 9U);
+			routput_u(out, el.w[i]);
+			routput_buf(out, "];\n", 3U);
+		}
+	} else {
+		const char *const *fs = rotz_names(ctx, nm, el.from, el.z);
+		const char *const *ts = rotz_names(ctx, nm2, el.to, el.z);
+
+		for (size_t i = 0U; i < el.z; i++) {
+			routput_buf(out, "  \"", 3U);
+			routput_str(out, rotz_massage_name(fs[i]));
+			routput_buf(out, "\" -- \"", 6U);
+			routput_str(out, rotz_massage_name(ts[i]));
+			routput_buf(out, "\" [weight=", 10U);
+			routput_u(out, el.w[i]);
+			routput_buf(out, "];\n", 3U);
+		}
+	}
+
+	routput_str(out, "}\n");
 	return;
 }
 
+static void
+xprt_proj_gml(
+	rotz_t ctx, rtz_wedglst_t el,
+	int(*vtxp)(rtz_vtx_t, const char*, void*))
+{
+	routput_str(out, "graph [\n  directed 0\n  id 0\n\n");
+
+	/* go through the projected vertices */
+	rotz_vtx_iter(ctx, iter_gmlv_proj_cb, vtxp);
+
+	for (size_t i = 0U; i < el.z; i++) {
+		routput_buf(out, "  edge [\n    source ", 20U);
+		routput_u(out, el.from[i]);
+		routput_buf(out, "\n    target ", 12U);
+		routput_u(out, el.to[i]);
+		routput_buf(out, "\n    weight ", 12U);
+		routput_u(out, el.w[i]);
+		routput_buf(out, "\n  ]\n", 5U);
+	}
+
+	routput_str(out, "]\n");
+	return;
+}
+
+/* compressed sparse rows */
+struct csr_s {
+	/* number of vertex slots, i.e. maxid + 1 */
+	rtz_vtx_t nv;
+	/* per-vertex counts, then file positions */
+	uint64_t *pos;
+	uint8_t *typ;
+	int fd;
+	int err;
+	/* for little-endian conversions */
+	rtz_vtx_t *le;
+	size_t lz;
+};
+
+#define CSR_TAG		(1U)
+#define CSR_SYM		(2U)
+
+/* targets are as wide as our handles */
+#if defined WITH_WIDE_IDS
+# define CSR_TGT_DTYPE	"<u8"
+# define htole_vtx	htole64
+#else  /* !WITH_WIDE_IDS */
+# define CSR_TGT_DTYPE	"<u4"
+# define htole_vtx	htole32
+#endif	/* WITH_WIDE_IDS */
+
+static int
+pwrite_all(int fd, const void *buf, size_t z, uint64_t off)
+{
+	for (const char *s = buf; z > 0U;) {
+		ssize_t nwr = pwrite(fd, s, z, off);
+
+		if (UNLIKELY(nwr < 0 && errno == EINTR)) {
+			continue;
+		} else if (UNLIKELY(nwr <= 0)) {
+			return -1;
+		}
+		s += nwr;
+		z -= nwr;
+		off += nwr;
+	}
+	return 0;
+}
+
+static int
+csr_vcnt_cb(rtz_vtx_t vid, const char *vtx, void *clo)
+{
+	struct csr_s *c = clo;
+
+	if (UNLIKELY(vid >= c->nv)) {
+		return 0;
+	}
+	c->typ[vid] = symp(vid, vtx, NULL) ? CSR_SYM : CSR_TAG;
+	c->pos[vid] = strlen(rotz_massage_name(vtx));
+	return 0;
+}
+
+static int
+csr_vput_cb(rtz_vtx_t vid, const char *vtx, void *clo)
+{
+	struct csr_s *c = clo;
+	const char *name;
+
+	if (UNLIKELY(vid >= c->nv)) {
+		return 0;
+	}
+	name = rotz_massage_name(vtx);
+	if (UNLIKELY(pwrite_all(c->fd, name, strlen(name), c->pos[vid]) < 0)) {
+		c->err = -1;
+		return -1;
+	}
+	return 0;
+}
+
+static int
+csr_ecnt_cb(rtz_vtx_t vid, rtz_const_vtxlst_t vl, void *clo)
+{
+	struct csr_s *c = clo;
+
+	if (UNLIKELY(vid >= c->nv)) {
+		return 0;
+	}
+	c->pos[vid] = vl.z;
+	return 0;
+}
+
+static int
+csr_eput_cb(rtz_vtx_t vid, rtz_const_vtxlst_t vl, void *clo)
+{
+	struct csr_s *c = clo;
+	const size_t z = vl.z * sizeof(*c->le);
+
+	if (UNLIKELY(vid >= c->nv)) {
+		return 0;
+	} else if (UNLIKELY(vl.z > c->lz)) {
+		const size_t nz = ((vl.z - 1U) / 1024U + 1U) * 1024U;
+		rtz_vtx_t *nu = realloc(c->le, nz * sizeof(*nu));
+
+		if (UNLIKELY(nu == NULL)) {
+			c->err = -1;
+			return -1;
+		}
+		c->le = nu;
+		c->lz = nz;
+	}
+	for (size_t i = 0U; i < vl.z; i++) {
+		c->le[i] = htole_vtx(vl.d[i]);
+	}
+	if (UNLIKELY(pwrite_all(
+			     c->fd, c->le, z,
+			     c->pos[vid] * sizeof(*c->le)) < 0)) {
+		c->err = -1;
+		return -1;
+	}
+	return 0;
+}
+
+static int
+csr_open(int dfd, const char *fn)
+{
+	return openat(dfd, fn, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+}
+
+static int
+csr_offs(struct csr_s *c, int dfd, const char *fn, uint64_t *tot)
+{
+/* turn the counts in C->POS into start offsets and write those, followed
+ * by the total, to FN */
+	uint64_t sum = 0U;
+	uint64_t le;
+	routput_t o;
+	int fd;
+	int rc;
+
+	if (UNLIKELY((fd = csr_open(dfd, fn)) < 0)) {
+		return -1;
+	} else if (UNLIKELY((o = make_routput(fd)) == NULL)) {
+		close(fd);
+		return -1;
+	}
+	for (rtz_vtx_t v = 0U; v < c->nv; v++) {
+		const uint64_t n = c->pos[v];
+
+		c->pos[v] = sum;
+		le = htole64(sum);
+		routput_buf(o, (const char*)&le, sizeof(le));
+		sum += n;
+	}
+	le = htole64(sum);
+	routput_buf(o, (const char*)&le, sizeof(le));
+	rc = free_routput(o);
+	close(fd);
+	*tot = sum;
+	return rc;
+}
+
+static int
+csr_hdr(int dfd, rtz_vtx_t nv, uint64_t ne, uint64_t nz)
+{
+	routput_t o;
+	int fd;
+	int rc;
+
+	if (UNLIKELY((fd = csr_open(dfd, "header.json")) < 0)) {
+		return -1;
+	} else if (UNLIKELY((o = make_routput(fd)) == NULL)) {
+		close(fd);
+		return -1;
+	}
+	routput_str(o, "{\n  \"format\": \"rotz-csr\",\n  \"version\": 1,\n");
+	routput_str(o, "  \"nvertices\": ");
+	routput_u(o, nv);
+	routput_str(o, ",\n  \"nedges\": ");
+	routput_u(o, ne);
+	routput_str(o, ",\n  \"types\": {\"0\": \"none\", \"1\": \"tag\", \"2\": \"sym\"},\n");
+	routput_str(o, "  \"arrays\": {\n");
+	routput_str(o, "    \"offsets\": {\"file\": \"offsets.bin\", \"dtype\": \"<u8\", \"length\": ");
+	routput_u(o, nv + 1U);
+	routput_str(o, "},\n    \"targets\": {\"file\": \"targets.bin\", \"dtype\": \"" CSR_TGT_DTYPE "\", \"length\": ");
+	routput_u(o, ne);
+	routput_str(o, "},\n    \"types\": {\"file\": \"types.bin\", \"dtype\": \"|u1\", \"length\": ");
+	routput_u(o, nv);
+	routput_str(o, "},\n    \"name_offsets\": {\"file\": \"name_offsets.bin\", \"dtype\": \"<u8\", \"length\": ");
+	routput_u(o, nv + 1U);
+	routput_str(o, "},\n    \"names\": {\"file\": \"names.bin\", \"dtype\": \"|u1\", \"length\": ");
+	routput_u(o, nz);
+	routput_str(o, "}\n  }\n}\n");
+	rc = free_routput(o);
+	close(fd);
+	return rc;
+}
+
+static int
+xprt_csr(rotz_t ctx, const char *dir)
+{
+/* Write vertex-indexed CSR arrays into DIR.  Memory use is linear in the
+ * number of vertices only, edges and names are put into place with
+ * positioned writes as the iterators hand them out. */
+	struct csr_s c = {.nv = rotz_get_maxid(ctx) + 1U};
+	uint64_t ne, nz;
+	int dfd;
+	int rc = -1;
+
+	if (UNLIKELY(mkdir(dir, 0777) < 0 && errno != EEXIST)) {
+		return -1;
+	} else if (UNLIKELY((dfd = open(dir, O_RDONLY | O_DIRECTORY)) < 0)) {
+		return -1;
+	}
+	c.pos = calloc(c.nv, sizeof(*c.pos));
+	c.typ = calloc(c.nv, sizeof(*c.typ));
+	if (UNLIKELY(c.pos == NULL || c.typ == NULL)) {
+		goto out;
+	}
+
+	/* vertices first, name lengths and types */
+	rotz_vtx_iter(ctx, csr_vcnt_cb, &c);
+	if (UNLIKELY(csr_offs(&c, dfd, "name_offsets.bin", &nz) < 0)) {
+		goto out;
+	} else if (UNLIKELY((c.fd = csr_open(dfd, "names.bin")) < 0)) {
+		goto out;
+	}
+	rotz_vtx_iter(ctx, csr_vput_cb, &c);
+	close(c.fd);
+	if (UNLIKELY(c.err < 0)) {
+		goto out;
+	} else if (UNLIKELY((c.fd = csr_open(dfd, "types.bin")) < 0)) {
+		goto out;
+	} else if (UNLIKELY(pwrite_all(c.fd, c.typ, c.nv, 0U) < 0)) {
+		close(c.fd);
+		goto out;
+	}
+	close(c.fd);
+
+	/* edges, degrees then adjacency lists */
+	memset(c.pos, 0, c.nv * sizeof(*c.pos));
+	rotz_edg_iter(ctx, csr_ecnt_cb, &c);
+	if (UNLIKELY(csr_offs(&c, dfd, "offsets.bin", &ne) < 0)) {
+		goto out;
+	} else if (UNLIKELY((c.fd = csr_open(dfd, "targets.bin")) < 0)) {
+		goto out;
+	}
+	rotz_edg_iter(ctx, csr_eput_cb, &c);
+	close(c.fd);
+	if (UNLIKELY(c.err < 0)) {
+		goto out;
+	}
+
+	rc = csr_hdr(dfd, c.nv, ne, nz);
+out:
+	free(c.pos);
+	free(c.typ);
+	free(c.le);
+	close(dfd);
+	return rc;
+}
+
+
 
 #if defined STANDALONE
+static int
+xprt_proj(rotz_t ctx, const struct yuck_cmd_export_s argi[static 1U])
+{
+	int(*srcp)(rtz_vtx_t, const char*, void*);
+	int(*vtxp)(rtz_vtx_t, const char*, void*);
+	unsigned int minw = 1U;
+	unsigned int nthr = 1U;
+	rtz_wedglst_t el;
+
+	if (!strcmp(argi->project_arg, "tags")) {
+		/* tags co-occurring on syms */
+		srcp = symp;
+		vtxp = tagp;
+	} else if (!strcmp(argi->project_arg, "syms")) {
+		/* syms co-occurring under tags */
+		srcp = tagp;
+		vtxp = symp;
+	} else {
+		fputs("Error: --project must be one of tags, syms\n", stderr);
+		return 1;
+	}
+	if (argi->min_weight_arg) {
+		minw = strtoul(argi->min_weight_arg, NULL, 0);
+	}
+	if (argi->threads_arg) {
+		nthr = strtoul(argi->threads_arg, NULL, 0);
+	}
+
+	el = rotz_project(ctx, srcp, NULL, minw, nthr);
+	if (UNLIKELY(el.from == NULL && rotz_get_maxid(ctx))) {
+		fputs("Error: cannot compute projection\n", stderr);
+		return 1;
+	} else if (argi->gml_flag) {
+		xprt_proj_gml(ctx, el, vtxp);
+	} else if (argi->dot_flag) {
+		xprt_proj_dot(ctx, el);
+	} else {
+		xprt_proj_csv(ctx, el);
+	}
+	rotz_free_wedglst(el);
+	return 0;
+}
+
+static int
+xprt_shards(rotz_t ctx, const struct yuck_cmd_export_s argi[static 1U])
+{
+	const char *pre = argi->prefix_arg ?: "export";
+	unsigned int nthr = 1U;
+	unsigned int n;
+
+	if (argi->gml_flag) {
+		fputs("Error: --split cannot be used with --gml\n", stderr);
+		return 1;
+	} else if (!(n = strtoul(argi->split_arg, NULL, 0))) {
+		fputs("Error: --split needs a positive number of shards\n", stderr);
+		return 1;
+	}
+	if (argi->threads_arg) {
+		nthr = strtoul(argi->threads_arg, NULL, 0) ?: 1U;
+	}
+
+	if (argi->dot_flag) {
+		return -xprt_split(
+			ctx, iter_dot_cb, nthr, n, pre, "dot",
+			"graph rotz {\n", "}\n");
+	}
+	return -xprt_split(ctx, iter_csv_cb, nthr, n, pre, "csv", NULL, NULL);
+}
+
 int
 rotz_cmd_export(const struct yuck_cmd_export_s argi[static 1U])
 {
+	unsigned int nthr = 1U;
 	rotz_t ctx;
+	int rc = 0;
 
 	if (UNLIKELY((ctx = make_rotz(db)) == NULL)) {
 		fputs("Error opening rotz datastore\n", stderr);
@@ -189,19 +1015,45 @@ rotz_cmd_export(const struct yuck_cmd_export_s argi[static 1U])
 
 	/* setting global opts */
 	clusterp = argi->cluster_flag;
+	idsp = argi->ids_flag;
+	if (argi->threads_arg) {
+		nthr = strtoul(argi->threads_arg, NULL, 0) ?: 1U;
+	}
+	if (UNLIKELY((out = make_routput(STDOUT_FILENO)) == NULL)) {
+		fputs("Error: cannot allocate output buffer\n", stderr);
+		free_rotz(ctx);
+		return 1;
+	}
 
-	if (argi->gml_flag) {
-		xprt_gml(ctx);
+	if (argi->binary_flag) {
+		rc = -rotz_export_binary(ctx, STDOUT_FILENO);
+	} else if (argi->csr_arg) {
+		if ((rc = -xprt_csr(ctx, argi->csr_arg))) {
+			fprintf(stderr, "Error: cannot write CSR arrays to `%s'\n",
+				argi->csr_arg);
+		}
+	} else if (argi->project_arg) {
+		rc = xprt_proj(ctx, argi);
+	} else if (argi->split_arg) {
+		rc = xprt_shards(ctx, argi);
+	} else if (argi->gml_flag) {
+		rc = -xprt_gml(ctx, nthr);
 	} else if (argi->dot_flag) {
-		xprt_dot(ctx);
+		rc = -xprt_dot(ctx, nthr);
 	} else {
 		/* default file format is csv */
-		xprt_csv(ctx);
+		rc = -xprt_csv(ctx, nthr);
 	}
 
 	/* big rcource freeing */
+	if (UNLIKELY(free_routput(out) < 0)) {
+		rc = 1;
+	}
+	rotz_names_free(nm);
+	rotz_names_free(nm2);
+	free_ntab();
 	free_rotz(ctx);
-	return 0;
+	return rc;
 }
 #endif	/* STANDALONE */
 
@@ -0,0 +1,154 @@
+/*** rotz-follow.c -- apply a change log to a replica
+ *
+ * Copyright (C) 2013-2014 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of rotz.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include "rotz.h"
+#include "rotz-cmd-api.h"
+#include "rotz-umb.h"
+#include "nifty.h"
+
+/* most we read and apply in one transaction, unless a record's bigger */
+#define FOLLOW_BATCH_Z	(1U << 22U)
+
+
+#if defined STANDALONE
+int
+rotz_cmd_follow(const struct yuck_cmd_follow_s argi[static 1U])
+{
+	unsigned long ival = 1000UL;
+	rtz_logpos_t pos;
+	rtz_buf_t b = {0U};
+	size_t bsz = FOLLOW_BATCH_Z;
+	rotz_t ctx;
+	int fd;
+	int rc = 0;
+
+	if (argi->nargs == 0U) {
+		fputs("Error: no change log given\n", stderr);
+		return 1;
+	} else if (UNLIKELY((fd = open(argi->args[0U], O_RDONLY)) < 0)) {
+		fprintf(stderr, "Error: cannot open `%s'\n", argi->args[0U]);
+		return 1;
+	} else if (UNLIKELY((ctx = make_rotz(db, O_CREAT | O_RDWR)) == NULL)) {
+		fputs("Error opening rotz datastore\n", stderr);
+		close(fd);
+		return 1;
+	}
+	if (argi->interval_arg) {
+		ival = strtoul(argi->interval_arg, NULL, 0);
+	}
+	/* find out where we left off */
+	pos = rotz_get_logpos(ctx);
+	free_rotz(ctx);
+
+	while (1) {
+		struct stat st;
+		ssize_t nrd;
+		int n;
+
+		if (UNLIKELY(fstat(fd, &st) < 0)) {
+			rc = 1;
+			break;
+		} else if (UNLIKELY((uint64_t)st.st_size < pos.off)) {
+			fputs("Error: change log is shorter than \
+what has been applied\n", stderr);
+			rc = 1;
+			break;
+		} else if ((uint64_t)st.st_size == pos.off) {
+			/* nothing new */
+			goto idle;
+		}
+
+		if (UNLIKELY(b.z < bsz)) {
+			b.d = realloc(b.d, b.z = bsz);
+		}
+		with (uint64_t left = st.st_size - pos.off) {
+			nrd = pread(fd, b.d, left < b.z ? left : b.z, pos.off);
+		}
+		if (UNLIKELY(nrd <= 0)) {
+			rc = 1;
+			break;
+		}
+
+		/* the database is only held while applying so that readers
+		 * of the replica get their turn in between */
+		if (UNLIKELY((ctx = make_rotz(db, O_CREAT | O_RDWR)) == NULL)) {
+			fputs("Error opening rotz datastore\n", stderr);
+			rc = 1;
+			break;
+		}
+		n = rotz_apply_changelog(ctx, &pos, b.d, nrd);
+		free_rotz(ctx);
+
+		if (UNLIKELY(n < 0)) {
+			fprintf(stderr, "\
+Error: cannot apply change log records past %llu\n",
+				(unsigned long long)pos.seq);
+			rc = 1;
+			break;
+		} else if (n > 0) {
+			/* there might be more */
+			continue;
+		} else if ((size_t)nrd == b.z) {
+			/* a record bigger than our buffer */
+			bsz *= 2U;
+			continue;
+		}
+	idle:
+		if (argi->once_flag) {
+			break;
+		}
+		usleep(ival * 1000UL);
+	}
+
+	/* big rcource freeing */
+	rotz_free_r(b);
+	close(fd);
+	return rc;
+}
+#endif	/* STANDALONE */
+
+/* rotz-follow.c ends here */
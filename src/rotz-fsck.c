@@ -47,6 +47,7 @@
 #endif	/* USE_TCBDB */
 
 #include "rotz.h"
+#include "rgraph.h"
 #include "rotz-cmd-api.h"
 #include "rotz-umb.h"
 #include "nifty.h"
@@ -126,28 +127,74 @@ opti(rotz_t ctx)
 }
 #endif	/* USE_TCBDB */
 
+static int
+reorder(rotz_t ctx, unsigned int nthr)
+{
+	rtz_vtxlst_t perm;
+	double gap[2U];
+	int res;
+
+	if (UNLIKELY((gap[0U] = rotz_avg_gap(ctx, nthr)) < 0.)) {
+		return -1;
+	}
+	perm = rotz_locality_order(ctx, nthr);
+	if (UNLIKELY(perm.d == NULL)) {
+		/* nothing to do, or no memory to do it */
+		return rotz_get_maxid(ctx) ? -1 : 0;
+	}
+	res = rotz_renumber(ctx, perm.d, perm.z);
+	rotz_free_vtxlst(perm);
+	if (UNLIKELY(res < 0)) {
+		return -1;
+	} else if (UNLIKELY((gap[1U] = rotz_avg_gap(ctx, nthr)) < 0.)) {
+		return -1;
+	}
+	printf("average gap %.2f -> %.2f\n", gap[0U], gap[1U]);
+	return 0;
+}
+
 
 #if defined STANDALONE
 int
-rotz_cmd_fsck(const struct yuck_cmd_fsck_s UNUSED(argi[static 1U]))
+rotz_cmd_fsck(const struct yuck_cmd_fsck_s argi[static 1U])
 {
+	unsigned int nthr = 1U;
 	rotz_t ctx;
+	int rc = 0;
+
+	if (argi->threads_arg) {
+		nthr = strtoul(argi->threads_arg, NULL, 0);
+	}
 
 	if (UNLIKELY((ctx = make_rotz(db, O_CREAT | O_RDWR)) == NULL)) {
 		fputs("Error opening rotz datastore\n", stderr);
 		return 1;
 	}
 
-	/* first step is to defrag, ... */
+	/* bring old databases up to date, ... */
+	if (UNLIKELY(rotz_upgrade(ctx) < 0)) {
+		fputs("Error during upgrade\n", stderr);
+		rc = 1;
+	}
+	/* ... renumber if asked to, ... */
+	if (argi->reorder_flag && UNLIKELY(reorder(ctx, nthr) < 0)) {
+		fputs("Error during renumbering\n", stderr);
+		rc = 1;
+	}
+	/* ... then defrag, ... */
 	if (UNLIKELY(dfrg(ctx) < 0)) {
 		dberror(ctx, "Error during defrag: ");
 	} else if (UNLIKELY(opti(ctx) < 0)) {
 		dberror(ctx, "Error during optimisation: ");
 	}
+	/* ... then rebuild indices */
+	if (UNLIKELY(rotz_reindex(ctx) < 0)) {
+		dberror(ctx, "Error during reindexing: ");
+	}
 
 	/* big rcource freeing */
 	free_rotz(ctx);
-	return 0;
+	return rc;
 }
 #endif	/* STANDALONE */
 
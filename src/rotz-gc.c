@@ -0,0 +1,85 @@
+/*** rotz-gc.c -- collect tags and symbols without associations
+ *
+ * Copyright (C) 2013-2014 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of rotz.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <fcntl.h>
+
+#include "rotz.h"
+#include "rotz-cmd-api.h"
+#include "rotz-umb.h"
+#include "nifty.h"
+
+
+#if defined STANDALONE
+int
+rotz_cmd_gc(const struct yuck_cmd_gc_s argi[static 1U])
+{
+	rotz_t ctx;
+	int n;
+	int rc = 0;
+
+	if (UNLIKELY((ctx = make_rotz(db, O_CREAT | O_RDWR)) == NULL)) {
+		fputs("Error opening rotz datastore\n", stderr);
+		return 1;
+	}
+
+	if (argi->auto_flag || argi->no_auto_flag) {
+		if (UNLIKELY(rotz_set_autogc(ctx, argi->auto_flag) < 0)) {
+			fputs("Error changing automatic collection\n", stderr);
+			rc = 1;
+			goto out;
+		}
+	}
+	if (UNLIKELY((n = rotz_gc(ctx)) < 0)) {
+		fputs("Error during collection\n", stderr);
+		rc = 1;
+	} else if (argi->verbose_flag) {
+		printf("%d tags and symbols collected\n", n);
+	}
+
+out:
+	/* big rcource freeing */
+	free_rotz(ctx);
+	return rc;
+}
+#endif	/* STANDALONE */
+
+/* rotz-gc.c ends here */
@@ -46,22 +46,20 @@
 #include "rotz.h"
 #include "rotz-cmd-api.h"
 #include "rotz-umb.h"
+#include "rinput.h"
 #include "raux.h"
 #include "nifty.h"
 
 
 #if defined STANDALONE
+static struct rtz_batch_s in[1U];
+
 static void
-handle_one(rotz_t ctx, const struct yuck_cmd_grep_s *argi, const char *input)
+handle_one(
+	rotz_t ctx, const struct yuck_cmd_grep_s *argi,
+	const char *input, rtz_vtx_t tsid)
 {
-	const char *tagsym;
-	rtz_vtx_t tsid;
-
-	if ((tagsym = rotz_tag(input),
-	     tsid = rotz_get_vertex(ctx, tagsym))) {
-		;
-	} else if ((tagsym = rotz_sym(input),
-		    tsid = rotz_get_vertex(ctx, tagsym))) {
+	if (tsid) {
 		;
 	} else if (argi->invert_match_flag) {
 		/* not found but we're in invert-match mode */
@@ -81,10 +79,38 @@ handle_one(rotz_t ctx, const struct yuck_cmd_grep_s *argi, const char *input)
 	return;
 }
 
+static void
+handle_batch(rotz_t ctx, const struct yuck_cmd_grep_s *argi)
+{
+	static rtz_vtx_t tsids[RTZ_BATCH_Z];
+	const char *const *ip;
+
+	/* resolve the whole batch first */
+	rotz_get_tagsyms(ctx, tsids, in);
+	ip = rotz_batch_seal(in);
+	for (size_t i = 0U; i < in->n; i++) {
+		handle_one(ctx, argi, ip[i], tsids[i]);
+	}
+	rotz_batch_clear(in);
+	return;
+}
+
+static void
+handle_input(
+	rotz_t ctx, const struct yuck_cmd_grep_s *argi, const char *s, size_t z)
+{
+	rotz_batch_push(in, s, z);
+	if (UNLIKELY(in->n >= RTZ_BATCH_Z)) {
+		handle_batch(ctx, argi);
+	}
+	return;
+}
+
 int
 rotz_cmd_grep(const struct yuck_cmd_grep_s argi[static 1U])
 {
 	rotz_t ctx;
+	int rc = 0;
 
 	if (UNLIKELY((ctx = make_rotz(db)) == NULL)) {
 		fputs("Error opening rotz datastore\n", stderr);
@@ -94,24 +120,36 @@ rotz_cmd_grep(const struct yuck_cmd_grep_s argi[static 1U])
 	for (size_t i = 0U; i < argi->nargs; i++) {
 		const char *const input = argi->args[i];
 
-		handle_one(ctx, argi, input);
+		handle_input(ctx, argi, input, strlen(input));
 	}
 	if (argi->nargs == 0U && !isatty(STDIN_FILENO)) {
 		/* read the guys from STDIN */
-		char *line = NULL;
-		size_t llen = 0U;
-		ssize_t nrd;
+		rinput_t rd = make_rinput(STDIN_FILENO);
+		char *line;
+		size_t llen;
 
-		while ((nrd = getline(&line, &llen, stdin)) > 0) {
-			line[nrd - 1] = '\0';
-			handle_one(ctx, argi, line);
+		if (UNLIKELY(rd == NULL)) {
+			fputs("Error: cannot read from stdin\n", stderr);
+			rc = 1;
+			goto fina;
+		}
+		while ((line = rinput_line(rd, &llen)) != NULL) {
+			handle_input(ctx, argi, line, llen);
+		}
+		if (UNLIKELY(rinput_err(rd))) {
+			fputs("Error: cannot read from stdin\n", stderr);
+			rc = 1;
 		}
-		free(line);
+		free_rinput(rd);
 	}
+	/* process the remainder */
+	handle_batch(ctx, argi);
 
+fina:
 	/* big rcource freeing */
+	rotz_batch_free(in);
 	free_rotz(ctx);
-	return 0;
+	return rc;
 }
 #endif	/* STANDALONE */
 
@@ -0,0 +1,125 @@
+/*** rotz-import.c -- rotz binary importer
+ *
+ * Copyright (C) 2013-2014 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of rotz.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include "rotz.h"
+#include "rotz-cmd-api.h"
+#include "rotz-umb.h"
+#include "nifty.h"
+
+
+static rtz_buf_t
+slurp(int fd, int *mappedp)
+{
+/* map FD if it's a regular file, read it in otherwise */
+	struct stat st;
+	rtz_buf_t res = {0U};
+	size_t bsz = 0U;
+	ssize_t nrd;
+
+	if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+		void *p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+		if (p != MAP_FAILED) {
+			(void)madvise(p, st.st_size, MADV_SEQUENTIAL);
+			*mappedp = 1;
+			return (rtz_buf_t){.z = st.st_size, .d = p};
+		}
+	}
+	*mappedp = 0;
+	do {
+		if (res.z >= bsz) {
+			bsz = bsz ? 2U * bsz : (1U << 20U);
+			res.d = realloc(res.d, bsz);
+		}
+		nrd = read(fd, res.d + res.z, bsz - res.z);
+	} while (nrd > 0 && (res.z += nrd, 1));
+	return res;
+}
+
+
+#if defined STANDALONE
+int
+rotz_cmd_import(const struct yuck_cmd_import_s argi[static 1U])
+{
+	int fd = STDIN_FILENO;
+	int mappedp;
+	rtz_buf_t b;
+	rotz_t ctx;
+	int rc = 0;
+
+	if (argi->nargs > 0U &&
+	    UNLIKELY((fd = open(argi->args[0U], O_RDONLY)) < 0)) {
+		fprintf(stderr, "Error: cannot open `%s'\n", argi->args[0U]);
+		return 1;
+	} else if (UNLIKELY((ctx = make_rotz(db, O_CREAT | O_RDWR)) == NULL)) {
+		fputs("Error opening rotz datastore\n", stderr);
+		return 1;
+	}
+
+	b = slurp(fd, &mappedp);
+	if (UNLIKELY(rotz_import_binary(ctx, b.d, b.z) < 0)) {
+		fputs("\
+Error: cannot import, database not empty or input corrupt\n", stderr);
+		rc = 1;
+	}
+
+	/* big rcource freeing */
+	if (mappedp) {
+		munmap(b.d, b.z);
+	} else {
+		rotz_free_r(b);
+	}
+	if (fd != STDIN_FILENO) {
+		close(fd);
+	}
+	free_rotz(ctx);
+	return rc;
+}
+#endif	/* STANDALONE */
+
+/* rotz-import.c ends here */
@@ -50,6 +50,18 @@
 struct rotz_s {
 	MDB_env *db;
 	MDB_dbi dbi;
+	struct rtz_log_s *log;
+	struct rtz_tmb_s *tmb;
+	/* the caller's write transaction, if any */
+	MDB_txn *txn;
+	/* ids reserved but not yet handed out, [idlo, idhi) */
+	rtz_vtx_t idlo;
+	rtz_vtx_t idhi;
+	/* copy of the last get_meta() value, z is the allocated size */
+	size_t metaz;
+	char *meta;
+	/* set for handles made by rotz_clone(), DB isn't theirs */
+	int clonep;
 };
 
 
@@ -87,11 +99,28 @@ make_rotz(const char *db, ...)
 	}
 	/* just finalise the transaction now */
 	mdb_txn_abort(txn);
+	res.log = NULL;
+	res.tmb = NULL;
+	res.txn = NULL;
+	res.idlo = res.idhi = 0U;
+	res.metaz = 0U;
+	res.meta = NULL;
+	res.clonep = 0;
 
 	/* clone the result */
 	{
 		struct rotz_s *resp = malloc(sizeof(*resp));
 		*resp = res;
+		/* learn the key format, ... */
+		if (UNLIKELY(open_fmt(resp, oparam & O_RDWR) < 0)) {
+			free_rotz(resp);
+			return NULL;
+		}
+		/* ... writers append to the change log, if any */
+		if ((oparam & O_RDWR) && UNLIKELY(open_log(resp) < 0)) {
+			free_rotz(resp);
+			return NULL;
+		}
 		return resp;
 	}
 
@@ -105,21 +134,124 @@ out0:
 	return NULL;
 }
 
+rotz_t
+rotz_clone(rotz_t ctx)
+{
+/* MDB_NOTLS lets every thread have a read transaction of its own */
+	struct rotz_s *res;
+
+	if (UNLIKELY((res = calloc(1U, sizeof(*res))) == NULL)) {
+		return NULL;
+	}
+	res->db = ctx->db;
+	res->dbi = ctx->dbi;
+	res->clonep = 1;
+	return res;
+}
+
 void
 free_rotz(rotz_t ctx)
 {
-	mdb_close(ctx->db, ctx->dbi);
-	mdb_env_sync(ctx->db, 1/*force synchronous*/);
-	mdb_env_close(ctx->db);
+	if (ctx->txn != NULL) {
+		/* whatever the caller left open, clones their snapshot */
+		mdb_txn_abort(ctx->txn);
+	}
+	unrsv_ids(ctx);
+	close_log(ctx);
+	free_tombs(ctx);
+	if (!ctx->clonep) {
+		mdb_close(ctx->db, ctx->dbi);
+		mdb_env_sync(ctx->db, 1/*force synchronous*/);
+		mdb_env_close(ctx->db);
+	}
+	if (ctx->meta != NULL) {
+		free(ctx->meta);
+	}
 	free(ctx);
 	return;
 }
+static MDB_txn*
+wtxn_begin(rotz_t ctx)
+{
+/* get us a write transaction unless the caller has one open */
+	MDB_txn *txn;
+
+	if (ctx->txn != NULL) {
+		return ctx->txn;
+	}
+	mdb_txn_begin(ctx->db, NULL, 0, &txn);
+	return txn;
+}
+
+static MDB_txn*
+rtxn_begin(rotz_t ctx)
+{
+/* get us a read transaction unless the caller has one open */
+	MDB_txn *txn;
+
+	if (ctx->txn != NULL) {
+		return ctx->txn;
+	}
+	mdb_txn_begin(ctx->db, NULL, MDB_RDONLY, &txn);
+	return txn;
+}
+
+static void
+rtxn_end(rotz_t ctx, MDB_txn *txn)
+{
+	if (txn != ctx->txn) {
+		mdb_txn_abort(txn);
+	}
+	return;
+}
+
+static int
+put_mark(rotz_t ctx, MDB_txn *txn)
+{
+/* commit the change log position along with the records' writes */
+	const_buf_t m = log_mark(ctx);
+	MDB_val key = {
+		.mv_size = sizeof(seqkey),
+		.mv_data = seqkey,
+	};
+	MDB_val val = {
+		.mv_size = m.z,
+		.mv_data = m.d,
+	};
+
+	if (m.z == 0U) {
+		/* nothing's logged */
+		return 0;
+	}
+	return mdb_put(txn, ctx->dbi, &key, &val, 0) ? -1 : 0;
+}
+
+static int
+wtxn_commit(rotz_t ctx, MDB_txn *txn)
+{
+	if (txn == ctx->txn) {
+		/* the caller commits */
+		return 0;
+	} else if (UNLIKELY(log_lock(ctx) < 0) ||
+		   UNLIKELY(put_mark(ctx, txn) < 0)) {
+		mdb_txn_abort(txn);
+		log_drop(ctx);
+		return -1;
+	} else if (UNLIKELY(mdb_txn_commit(txn) != 0)) {
+		log_drop(ctx);
+		return -1;
+	}
+	/* the change log follows suit */
+	return log_write(ctx, 0);
+}
+
 
 
 /* vertex accessors */
 static rtz_vtx_t
-next_id(rotz_t cp)
+next_ids(rotz_t cp, rtz_vtx_t n)
 {
+/* reserve N ids in one go and return the first one */
 	static const char nid[] = "\x1d";
 
 	MDB_val key = {
@@ -129,8 +261,9 @@ next_id(rotz_t cp)
 	MDB_txn *txn;
 	MDB_val val;
 	rtz_vtx_t res = 0U;
+	rtz_vtx_t max;
 
-	mdb_txn_begin(cp->db, NULL, 0, &txn);
+	txn = wtxn_begin(cp);
 	switch (mdb_get(txn, cp->dbi, &key, &val)) {
 	default:
 		res = 0U;
@@ -138,19 +271,85 @@ next_id(rotz_t cp)
 	case 0:
 		res = *(const rtz_vtx_t*)val.mv_data;
 	case MDB_NOTFOUND:
-		res++;
-		val.mv_data = &res;
-		val.mv_size = sizeof(res);
+		max = res + n;
+		val.mv_data = &max;
+		val.mv_size = sizeof(max);
 
 		/* put back into the db */
-		mdb_put(txn, cp->dbi, &key, &val, 0);
+		if (UNLIKELY(mdb_put(txn, cp->dbi, &key, &val, 0) != 0)) {
+			res = 0U;
+			break;
+		}
+		log_rec(cp, RTZ_LOG_NEXT_ID, NULL, 0U, &n, sizeof(n));
+		res++;
 		break;
 	}
 	/* and commit */
-	mdb_txn_commit(txn);
+	if (UNLIKELY(wtxn_commit(cp, txn) < 0)) {
+		res = 0U;
+	}
 	return (rtz_vtx_t)res;
 }
 
+static int
+ret_ids(rotz_t cp, rtz_vtx_t from, rtz_vtx_t till)
+{
+/* give back the ids [FROM, TILL) unless others reserved ids after them */
+	static const char nid[] = "\x1d";
+
+	MDB_val key = {
+		.mv_size = sizeof(nid),
+		.mv_data = nid,
+	};
+	MDB_txn *txn;
+	MDB_val val;
+	rtz_vtx_t max = from - 1U;
+	int res = 0;
+
+	txn = wtxn_begin(cp);
+	if (mdb_get(txn, cp->dbi, &key, &val) != 0 ||
+	    UNLIKELY(val.mv_size != sizeof(max)) ||
+	    *(const rtz_vtx_t*)val.mv_data != till - 1U) {
+		/* abandon them then */
+		;
+	} else if (UNLIKELY(mdb_put(
+				    txn, cp->dbi, &key,
+				    &(MDB_val){sizeof(max), &max}, 0) != 0)) {
+		res = -1;
+	} else {
+		log_rec(cp, RTZ_LOG_RET_IDS,
+			NULL, 0U, (rtz_vtx_t[]){from, till}, 2U * sizeof(max));
+		res = 1;
+	}
+	/* and commit */
+	if (UNLIKELY(wtxn_commit(cp, txn) < 0)) {
+		res = -1;
+	}
+	return res;
+}
+
+static rtz_vtx_t
+get_maxid(rotz_t cp)
+{
+	static const char nid[] = "\x1d";
+
+	MDB_val key = {
+		.mv_size = sizeof(nid),
+		.mv_data = nid,
+	};
+	MDB_txn *txn;
+	MDB_val val;
+	rtz_vtx_t res = 0U;
+
+	txn = rtxn_begin(cp);
+	if (mdb_get(txn, cp->dbi, &key, &val) == 0 &&
+	    LIKELY(val.mv_size == sizeof(res))) {
+		res = *(const rtz_vtx_t*)val.mv_data;
+	}
+	rtxn_end(cp, txn);
+	return res;
+}
+
 static rtz_vtx_t
 get_vertex(rotz_t cp, const char *v, size_t z)
 {
@@ -163,7 +362,7 @@ get_vertex(rotz_t cp, const char *v, size_t z)
 	MDB_val val;
 
 	/* get us a transaction */
-	mdb_txn_begin(cp->db, NULL, MDB_RDONLY, &txn);
+	txn = rtxn_begin(cp);
 
 	if (UNLIKELY(mdb_get(txn, cp->dbi, &key, &val) != 0)) {
 		res = 0U;
@@ -174,10 +373,58 @@ get_vertex(rotz_t cp, const char *v, size_t z)
 	}
 
 	/* and commit */
-	mdb_txn_commit(txn);
+	rtxn_end(cp, txn);
 	return res;
 }
 
+static size_t
+get_vertices(rotz_t cp, rtz_vtx_t *restrict r, const const_buf_t *v, size_t n)
+{
+/* V is assumed to be sorted */
+	MDB_txn *txn;
+	MDB_cursor *crs;
+	size_t i = 0U;
+	size_t nr = 0U;
+
+	/* get us a transaction and a cursor */
+	txn = rtxn_begin(cp);
+	if (mdb_cursor_open(txn, cp->dbi, &crs) != 0) {
+		goto out0;
+	}
+	for (; i < n; i++) {
+		MDB_val key = {
+			.mv_size = v[i].z,
+			.mv_data = v[i].d,
+		};
+		MDB_val val;
+
+		r[i] = 0U;
+		if (mdb_cursor_get(crs, &key, &val, MDB_SET_RANGE) != 0) {
+			/* we're past the last key */
+			break;
+		} else if (key.mv_size != v[i].z ||
+			   memcmp(key.mv_data, v[i].d, v[i].z)) {
+			/* not found */
+			continue;
+		} else if (UNLIKELY(val.mv_size != sizeof(*r))) {
+			continue;
+		}
+		r[i] = *(const rtz_vtx_t*)val.mv_data;
+		nr++;
+	}
+
+	/* cursor finalising */
+	mdb_cursor_close(crs);
+out0:
+	/* and out */
+	rtxn_end(cp, txn);
+	/* everything we haven't seen is a miss */
+	for (; i < n; i++) {
+		r[i] = 0U;
+	}
+	return nr;
+}
+
 static int
 put_vertex(rotz_t cp, const char *a, size_t az, rtz_vtx_t v)
 {
@@ -193,14 +440,20 @@ put_vertex(rotz_t cp, const char *a, size_t az, rtz_vtx_t v)
 	};
 
 	/* get us a transaction */
-	mdb_txn_begin(cp->db, NULL, 0, &txn);
+	txn = wtxn_begin(cp);
 
 	if (UNLIKELY(mdb_put(txn, cp->dbi, &key, &val, 0) != 0)) {
 		res = -1;
 	}
 
+	if (res == 0) {
+		log_rec(cp, RTZ_LOG_PUT_VERTEX, a, az, &v, sizeof(v));
+	}
+
 	/* and commit */
-	mdb_txn_commit(txn);
+	if (UNLIKELY(wtxn_commit(cp, txn) < 0)) {
+		res = -1;
+	}
 	return res;
 }
 
@@ -219,7 +472,7 @@ rnm_vertex(rotz_t cp, rtz_vtxkey_t vkey, const char *v, size_t z)
 	MDB_txn *txn;
 
 	/* get us a transaction */
-	mdb_txn_begin(cp->db, NULL, 0, &txn);
+	txn = wtxn_begin(cp);
 
 	if (UNLIKELY(mdb_put(txn, cp->dbi, &key, &val, 0) != 0)) {
 		key = (MDB_val){z, v};
@@ -227,8 +480,14 @@ rnm_vertex(rotz_t cp, rtz_vtxkey_t vkey, const char *v, size_t z)
 		res = -1;
 	}
 
+	if (res == 0) {
+		log_rec(cp, RTZ_LOG_RNM_VERTEX, vkey, RTZ_VTXKEY_Z, v, z + 1);
+	}
+
 	/* and commit */
-	mdb_txn_commit(txn);
+	if (UNLIKELY(wtxn_commit(cp, txn) < 0)) {
+		res = -1;
+	}
 	return res;
 }
 
@@ -243,14 +502,20 @@ unput_vertex(rotz_t cp, const char *v, size_t z)
 	MDB_txn *txn;
 
 	/* get us a transaction */
-	mdb_txn_begin(cp->db, NULL, 0, &txn);
+	txn = wtxn_begin(cp);
 
 	if (UNLIKELY(mdb_del(txn, cp->dbi, &key, NULL) != 0)) {
 		res = -1;
 	}
 
+	if (res == 0) {
+		log_rec(cp, RTZ_LOG_UNPUT_VERTEX, v, z, NULL, 0U);
+	}
+
 	/* and commit */
-	mdb_txn_commit(txn);
+	if (UNLIKELY(wtxn_commit(cp, txn) < 0)) {
+		res = -1;
+	}
 	return res;
 }
 
@@ -265,14 +530,20 @@ unrnm_vertex(rotz_t cp, rtz_vtxkey_t vkey)
 	MDB_txn *txn;
 
 	/* get us a transaction */
-	mdb_txn_begin(cp->db, NULL, 0, &txn);
+	txn = wtxn_begin(cp);
 
 	if (UNLIKELY(mdb_del(txn, cp->dbi, &key, NULL) != 0)) {
 		res = -1;
 	}
 
+	if (res == 0) {
+		log_rec(cp, RTZ_LOG_UNRNM_VERTEX, vkey, RTZ_VTXKEY_Z, NULL, 0U);
+	}
+
 	/* and commit */
-	mdb_txn_commit(txn);
+	if (UNLIKELY(wtxn_commit(cp, txn) < 0)) {
+		res = -1;
+	}
 	return res;
 }
 
@@ -324,14 +595,20 @@ add_alias(rotz_t cp, rtz_vtxkey_t vkey, const char *a, size_t az)
 	MDB_txn *txn;
 
 	/* get us a transaction */
-	mdb_txn_begin(cp->db, NULL, 0, &txn);
+	txn = wtxn_begin(cp);
 
 	if (mdb_putcat(txn, cp->dbi, &key, &val) != 0) {
 		res = -1;
 	}
 
+	if (res == 0) {
+		log_rec(cp, RTZ_LOG_ADD_ALIAS, vkey, RTZ_VTXKEY_Z, a, az + 1);
+	}
+
 	/* and commit */
-	mdb_txn_commit(txn);
+	if (UNLIKELY(wtxn_commit(cp, txn) < 0)) {
+		res = -1;
+	}
 	return res;
 }
 
@@ -339,6 +616,7 @@ static int
 add_akalst(rotz_t ctx, rtz_vtxkey_t ak, const_buf_t al)
 {
 	int res = 0;
+	int rc;
 	MDB_val key = {
 		.mv_size = RTZ_VTXKEY_Z,
 		.mv_data = ak,
@@ -350,12 +628,17 @@ add_akalst(rotz_t ctx, rtz_vtxkey_t ak, const_buf_t al)
 	MDB_txn *txn;
 
 	/* get us a transaction */
-	mdb_txn_begin(ctx->db, NULL, 0, &txn);
+	txn = wtxn_begin(ctx);
 
-	/* first delete the old guy */
-	if (mdb_del(txn, ctx->dbi, &key, NULL) != 0) {
+	/* first delete the old guy, if any */
+	if (!(rc = mdb_del(txn, ctx->dbi, &key, NULL)) || rc == MDB_NOTFOUND) {
+		;
+	} else {
 		/* ok, we're fucked */
 		res = -1;
+	}
+	if (res < 0) {
+		;
 	} else if (UNLIKELY(val.mv_size == 0U)) {
 		/* leave it del'd */
 		;
@@ -364,8 +647,14 @@ add_akalst(rotz_t ctx, rtz_vtxkey_t ak, const_buf_t al)
 		res = -1;
 	}
 
+	if (res == 0) {
+		log_rec(ctx, RTZ_LOG_ADD_AKALST, ak, RTZ_VTXKEY_Z, al.d, al.z);
+	}
+
 	/* and commit */
-	mdb_txn_commit(txn);
+	if (UNLIKELY(wtxn_commit(ctx, txn) < 0)) {
+		res = -1;
+	}
 	return res;
 }
 
@@ -381,7 +670,7 @@ get_aliases(rotz_t cp, rtz_vtxkey_t svtx)
 	MDB_txn *txn;
 
 	/* get us a transaction */
-	mdb_txn_begin(cp->db, NULL, MDB_RDONLY, &txn);
+	txn = rtxn_begin(cp);
 
 	if (UNLIKELY(mdb_get(txn, cp->dbi, &key, &val) < 0)) {
 		res = (const_buf_t){0U};
@@ -390,10 +679,49 @@ get_aliases(rotz_t cp, rtz_vtxkey_t svtx)
 	}
 
 	/* and commit */
-	mdb_txn_commit(txn);
+	rtxn_end(cp, txn);
 	return res;
 }
 
+static size_t
+get_names(
+	rotz_t cp, const rtz_vtx_t *v, size_t n,
+	void(*cb)(size_t, const char*, void*), void *clo)
+{
+/* V is assumed to be sorted in key order */
+	MDB_txn *txn;
+	MDB_cursor *crs;
+	size_t nr = 0U;
+
+	/* get us a transaction and a cursor */
+	txn = rtxn_begin(cp);
+	if (mdb_cursor_open(txn, cp->dbi, &crs) != 0) {
+		goto out0;
+	}
+	for (size_t i = 0U; i < n; i++) {
+		MDB_val key = {
+			.mv_size = RTZ_VTXKEY_Z,
+			.mv_data = rtz_vtxkey(v[i]),
+		};
+		MDB_val val;
+
+		if (mdb_cursor_get(crs, &key, &val, MDB_SET_KEY) != 0) {
+			/* not found */
+			continue;
+		}
+		/* we're interested in the first name only */
+		cb(i, val.mv_data, clo);
+		nr++;
+	}
+
+	/* cursor finalising */
+	mdb_cursor_close(crs);
+out0:
+	/* and out */
+	rtxn_end(cp, txn);
+	return nr;
+}
+
 static rtz_buf_t
 get_aliases_r(rotz_t cp, rtz_vtxkey_t svtx)
 {
@@ -419,7 +747,7 @@ get_edges(rotz_t ctx, rtz_edgkey_t src)
 	MDB_txn *txn;
 
 	/* get us a transaction */
-	mdb_txn_begin(ctx->db, NULL, MDB_RDONLY, &txn);
+	txn = rtxn_begin(ctx);
 
 	if (UNLIKELY(mdb_get(txn, ctx->dbi, &key, &val) < 0)) {
 		res = (const_vtxlst_t){0U};
@@ -431,7 +759,7 @@ get_edges(rotz_t ctx, rtz_edgkey_t src)
 	}
 
 	/* and commit */
-	mdb_txn_commit(txn);
+	rtxn_end(ctx, txn);
 	return res;
 }
 
@@ -450,14 +778,20 @@ add_edge(rotz_t ctx, rtz_edgkey_t src, rtz_vtx_t to)
 	MDB_txn *txn;
 
 	/* get us a transaction */
-	mdb_txn_begin(ctx->db, NULL, 0, &txn);
+	txn = wtxn_begin(ctx);
 
 	if (mdb_putcat(txn, ctx->dbi, &key, &val) != 0) {
 		res = -1;
 	}
 
+	if (res == 0) {
+		log_rec(ctx, RTZ_LOG_ADD_EDGE, src, RTZ_EDGKEY_Z, &to, sizeof(to));
+	}
+
 	/* and commit */
-	mdb_txn_commit(txn);
+	if (UNLIKELY(wtxn_commit(ctx, txn) < 0)) {
+		res = -1;
+	}
 	return res;
 }
 
@@ -470,28 +804,33 @@ add_vtxlst(rotz_t ctx, rtz_edgkey_t src, const_vtxlst_t el)
 		.mv_data = src,
 	};
 	MDB_val val = {
-		.mv_size = el.z,
+		.mv_size = el.z * sizeof(*el.d),
 		.mv_data = el.d,
 	};
 	MDB_txn *txn;
 
 	/* get us a transaction */
-	mdb_txn_begin(ctx->db, NULL, 0, &txn);
+	txn = wtxn_begin(ctx);
 
-	/* first delete the old guy */
-	if (mdb_del(txn, ctx->dbi, &key, NULL) != 0) {
-		/* ok, we're fucked */
-		res = -1;
-	} else if (UNLIKELY(val.mv_size == 0U)) {
-		/* leave it del'd */
-		;
+	if (UNLIKELY(val.mv_size == 0U)) {
+		/* just delete the list */
+		if (mdb_del(txn, ctx->dbi, &key, NULL) != 0) {
+			res = -1;
+		}
 	} else if (mdb_put(txn, ctx->dbi, &key, &val, 0) != 0) {
 		/* putting the new list failed */
 		res = -1;
 	}
 
+	if (res == 0) {
+		log_rec(ctx, RTZ_LOG_ADD_VTXLST,
+			src, RTZ_EDGKEY_Z, el.d, el.z * sizeof(*el.d));
+	}
+
 	/* and commit */
-	mdb_txn_commit(txn);
+	if (UNLIKELY(wtxn_commit(ctx, txn) < 0)) {
+		res = -1;
+	}
 	return res;
 }
 
@@ -506,14 +845,304 @@ rem_edges(rotz_t ctx, rtz_edgkey_t src)
 	MDB_txn *txn;
 
 	/* get us a transaction */
-	mdb_txn_begin(ctx->db, NULL, 0, &txn);
+	txn = wtxn_begin(ctx);
 
 	if (UNLIKELY(mdb_del(txn, ctx->dbi, &key, NULL) != 0)) {
 		res = -1;
 	}
 
+	if (res == 0) {
+		log_rec(ctx, RTZ_LOG_REM_EDGES, src, RTZ_EDGKEY_Z, NULL, 0U);
+	}
+
+	/* and commit */
+	if (UNLIKELY(wtxn_commit(ctx, txn) < 0)) {
+		res = -1;
+	}
+	return res;
+}
+
+
+/* parent accessors */
+static const_vtxlst_t
+get_children(rotz_t ctx, rtz_parkey_t par)
+{
+	const_vtxlst_t res;
+	MDB_val key = {
+		.mv_size = par.z,
+		.mv_data = par.d,
+	};
+	MDB_val val;
+	MDB_txn *txn;
+
+	/* get us a transaction */
+	txn = rtxn_begin(ctx);
+
+	if (UNLIKELY(mdb_get(txn, ctx->dbi, &key, &val) != 0)) {
+		res = (const_vtxlst_t){0U};
+	} else {
+		res = (const_vtxlst_t){
+			.z = val.mv_size / sizeof(rtz_vtx_t),
+			.d = val.mv_data
+		};
+	}
+
+	/* and commit */
+	rtxn_end(ctx, txn);
+	return res;
+}
+
+static int
+add_child(rotz_t ctx, rtz_parkey_t par, rtz_vtx_t chld)
+{
+	int res = 0;
+	MDB_val key = {
+		.mv_size = par.z,
+		.mv_data = par.d,
+	};
+	MDB_val val = {
+		.mv_size = sizeof(chld),
+		.mv_data = &chld,
+	};
+	MDB_txn *txn;
+
+	/* get us a transaction */
+	txn = wtxn_begin(ctx);
+
+	if (mdb_putcat(txn, ctx->dbi, &key, &val) != 0) {
+		res = -1;
+	}
+
+	if (res == 0) {
+		log_rec(ctx, RTZ_LOG_ADD_CHILD, par.d, par.z, &chld, sizeof(chld));
+	}
+
+	/* and commit */
+	if (UNLIKELY(wtxn_commit(ctx, txn) < 0)) {
+		res = -1;
+	}
+	return res;
+}
+
+static int
+add_chldlst(rotz_t ctx, rtz_parkey_t par, const_vtxlst_t el)
+{
+	int res = 0;
+	MDB_val key = {
+		.mv_size = par.z,
+		.mv_data = par.d,
+	};
+	MDB_val val = {
+		.mv_size = el.z * sizeof(*el.d),
+		.mv_data = el.d,
+	};
+	MDB_txn *txn;
+
+	/* get us a transaction */
+	txn = wtxn_begin(ctx);
+
+	if (UNLIKELY(val.mv_size == 0U)) {
+		/* just delete the list */
+		if (mdb_del(txn, ctx->dbi, &key, NULL) != 0) {
+			res = -1;
+		}
+	} else if (mdb_put(txn, ctx->dbi, &key, &val, 0) != 0) {
+		/* putting the new list failed */
+		res = -1;
+	}
+
+	if (res == 0) {
+		log_rec(ctx, RTZ_LOG_ADD_CHLDLST,
+			par.d, par.z, el.d, el.z * sizeof(*el.d));
+	}
+
 	/* and commit */
-	mdb_txn_commit(txn);
+	if (UNLIKELY(wtxn_commit(ctx, txn) < 0)) {
+		res = -1;
+	}
+	return res;
+}
+
+
+/* bulk loading */
+static int
+put_sorted(rotz_t ctx, const const_buf_t *k, const const_buf_t *v, size_t n)
+{
+	MDB_txn *txn;
+	MDB_cursor *crs;
+	int res = 0;
+
+	/* one transaction for the lot */
+	if ((txn = ctx->txn) != NULL) {
+		/* part of the caller's */
+		;
+	} else if (UNLIKELY(mdb_txn_begin(ctx->db, NULL, 0, &txn) != 0)) {
+		return -1;
+	}
+	if (UNLIKELY(mdb_cursor_open(txn, ctx->dbi, &crs) != 0)) {
+		res = -1;
+		goto out;
+	}
+	for (size_t i = 0U; i < n; i++) {
+		MDB_val key = {
+			.mv_size = k[i].z,
+			.mv_data = k[i].d,
+		};
+		MDB_val val = {
+			.mv_size = v[i].z,
+			.mv_data = v[i].d,
+		};
+		int rc;
+
+		/* keys come in order, so just fill up the last page,
+		 * unless there's bigger keys already, like meta data */
+		if (UNLIKELY((rc = mdb_cursor_put(
+				      crs, &key, &val, MDB_APPEND)) == MDB_KEYEXIST)) {
+			rc = mdb_cursor_put(crs, &key, &val, 0);
+		}
+		if (UNLIKELY(rc != 0)) {
+			res = -1;
+			break;
+		}
+		log_rec(ctx, RTZ_LOG_PUT_SORTED, k[i].d, k[i].z, v[i].d, v[i].z);
+	}
+	mdb_cursor_close(crs);
+
+out:
+	if (txn == ctx->txn) {
+		;
+	} else if (UNLIKELY(res < 0)) {
+		mdb_txn_abort(txn);
+		log_drop(ctx);
+	} else if (UNLIKELY(wtxn_commit(ctx, txn) < 0)) {
+		res = -1;
+	}
+	return res;
+}
+
+
+/* transactions and meta data */
+static int
+tx_begin(rotz_t ctx)
+{
+	return mdb_txn_begin(ctx->db, NULL, 0, &ctx->txn) ? -1 : 0;
+}
+
+static int
+tx_commit(rotz_t ctx)
+{
+	MDB_txn *txn = ctx->txn;
+
+	ctx->txn = NULL;
+	if (UNLIKELY(log_lock(ctx) < 0) ||
+	    UNLIKELY(put_mark(ctx, txn) < 0)) {
+		/* we can't log it, so it mustn't happen */
+		mdb_txn_abort(txn);
+		log_drop(ctx);
+		ctx->idlo = ctx->idhi = 0U;
+		return -1;
+	} else if (UNLIKELY(mdb_txn_commit(txn) != 0)) {
+		log_drop(ctx);
+		return -1;
+	}
+	/* followers get the transaction's records, durably */
+	return log_write(ctx, 1);
+}
+
+static void
+tx_abort(rotz_t ctx)
+{
+	mdb_txn_abort(ctx->txn);
+	ctx->txn = NULL;
+	log_drop(ctx);
+	/* our reservation might have been rolled back */
+	ctx->idlo = ctx->idhi = 0U;
+	return;
+}
+
+static int
+tx_p(rotz_t ctx)
+{
+	return ctx->txn != NULL;
+}
+
+static int
+rd_begin(rotz_t ctx)
+{
+/* a snapshot for all subsequent reads */
+	return mdb_txn_begin(ctx->db, NULL, MDB_RDONLY, &ctx->txn) ? -1 : 0;
+}
+
+static void
+rd_end(rotz_t ctx)
+{
+	mdb_txn_abort(ctx->txn);
+	ctx->txn = NULL;
+	return;
+}
+
+static const_buf_t
+get_meta(rotz_t ctx, const char *k, size_t kz)
+{
+/* the value is copied out before the read transaction ends, it stays
+ * valid until the next get_meta() on CTX */
+	const_buf_t res = {0U};
+	MDB_val key = {
+		.mv_size = kz,
+		.mv_data = k,
+	};
+	MDB_val val;
+	MDB_txn *txn;
+
+	txn = rtxn_begin(ctx);
+	if (mdb_get(txn, ctx->dbi, &key, &val) != 0 || val.mv_size == 0U) {
+		goto out;
+	} else if (val.mv_size > ctx->metaz) {
+		char *tmp = realloc(ctx->meta, val.mv_size);
+
+		if (UNLIKELY(tmp == NULL)) {
+			goto out;
+		}
+		ctx->meta = tmp;
+		ctx->metaz = val.mv_size;
+	}
+	memcpy(ctx->meta, val.mv_data, val.mv_size);
+	res = (const_buf_t){.z = val.mv_size, .d = ctx->meta};
+out:
+	rtxn_end(ctx, txn);
+	return res;
+}
+
+static int
+put_meta(rotz_t ctx, const char *k, size_t kz, const_buf_t v)
+{
+	int res = 0;
+	int rc;
+	MDB_val key = {
+		.mv_size = kz,
+		.mv_data = k,
+	};
+	MDB_val val = {
+		.mv_size = v.z,
+		.mv_data = v.d,
+	};
+	MDB_txn *txn;
+
+	txn = wtxn_begin(ctx);
+
+	if (v.z > 0U) {
+		if (UNLIKELY(mdb_put(txn, ctx->dbi, &key, &val, 0) != 0)) {
+			res = -1;
+		}
+	} else if ((rc = mdb_del(txn, ctx->dbi, &key, NULL)) != 0 &&
+		   UNLIKELY(rc != MDB_NOTFOUND)) {
+		/* it's fine if there was nothing to delete */
+		res = -1;
+	}
+
+	if (UNLIKELY(wtxn_commit(ctx, txn) < 0)) {
+		res = -1;
+	}
 	return res;
 }
 
@@ -531,7 +1160,7 @@ rotz_vtx_iter(rotz_t ctx, int(*cb)(rtz_vtx_t, const char*, void*), void *clo)
 	MDB_val val;
 
 	/* get us a transaction and a cursor */
-	mdb_txn_begin(ctx->db, NULL, MDB_RDONLY, &txn);
+	txn = rtxn_begin(ctx);
 	if (mdb_cursor_open(txn, ctx->dbi, &crs) != 0) {
 		goto out0;
 	} else if (mdb_cursor_get(crs, &key, NULL, MDB_SET_RANGE) != 0) {
@@ -558,12 +1187,14 @@ out1:
 	mdb_cursor_close(crs);
 out0:
 	/* and out */
-	mdb_txn_abort(txn);
+	rtxn_end(ctx, txn);
 	return;
 }
 
-void
-rotz_edg_iter(rotz_t ctx, int(*cb)(rtz_vtx_t, const_vtxlst_t, void*), void *clo)
+static void
+edg_iter(
+	rotz_t ctx, rtz_edgkey_t from, rtz_edgkey_t till,
+	int(*cb)(rtz_vtx_t, const_vtxlst_t, void*), void *clo)
 {
 	MDB_txn *txn;
 	MDB_cursor *crs;
@@ -573,8 +1204,12 @@ rotz_edg_iter(rotz_t ctx, int(*cb)(rtz_vtx_t, const_vtxlst_t, void*), void *clo)
 	};
 	MDB_val val;
 
-	/* get us a transaction and a cursor */
-	mdb_txn_begin(ctx->db, NULL, MDB_RDONLY, &txn);
+	if (from != NULL) {
+		key = (MDB_val){.mv_size = RTZ_EDGKEY_Z, .mv_data = from};
+	}
+	/* get us a transaction and a cursor, the transaction is ours
+	 * so this can run alongside other iterations */
+	txn = rtxn_begin(ctx);
 	if (mdb_cursor_open(txn, ctx->dbi, &crs) != 0) {
 		goto out0;
 	} else if (mdb_cursor_get(crs, &key, NULL, MDB_SET_RANGE) != 0) {
@@ -589,6 +1224,9 @@ rotz_edg_iter(rotz_t ctx, int(*cb)(rtz_vtx_t, const_vtxlst_t, void*), void *clo)
 		if (UNLIKELY(key.mv_size != RTZ_EDGKEY_Z) ||
 		    UNLIKELY(!(eid = rtz_edg(key.mv_data)))) {
 			break;
+		} else if (till != NULL &&
+			   memcmp(key.mv_data, till, RTZ_EDGKEY_Z) >= 0) {
+			break;
 		}
 		/* ctor the vl */
 		cvl = (const_vtxlst_t){
@@ -607,7 +1245,7 @@ out1:
 	mdb_cursor_close(crs);
 out0:
 	/* and out */
-	mdb_txn_abort(txn);
+	rtxn_end(ctx, txn);
 	return;
 }
 
@@ -625,7 +1263,7 @@ rotz_iter(
 	MDB_val val;
 
 	/* get us a transaction and a cursor */
-	mdb_txn_begin(ctx->db, NULL, MDB_RDONLY, &txn);
+	txn = rtxn_begin(ctx);
 	if (mdb_cursor_open(txn, ctx->dbi, &crs) != 0) {
 		goto out0;
 	} else if (mdb_cursor_get(crs, &key, NULL, MDB_SET_RANGE) != 0) {
@@ -639,7 +1277,8 @@ rotz_iter(
 		const_buf_t kb;
 		const_buf_t vb;
 
-		if (UNLIKELY(memcmp(key.mv_data, prfx_match.d, prfx_match.z))) {
+		if (UNLIKELY(key.mv_size < prfx_match.z) ||
+		    UNLIKELY(memcmp(key.mv_data, prfx_match.d, prfx_match.z))) {
 			break;
 		}
 		/* otherwise pack the bufs and call the callback */
@@ -657,7 +1296,7 @@ out1:
 	mdb_cursor_close(crs);
 out0:
 	/* and out */
-	mdb_txn_abort(txn);
+	rtxn_end(ctx, txn);
 	return;
 }
 
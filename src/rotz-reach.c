@@ -0,0 +1,177 @@
+/*** rotz-reach.c -- rotz k-hop neighbourhoods
+ *
+ * Copyright (C) 2013-2014 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of rotz.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "rotz.h"
+#include "rgraph.h"
+#include "rotz-cmd-api.h"
+#include "rotz-umb.h"
+#include "rinput.h"
+#include "routput.h"
+#include "nifty.h"
+
+static struct rtz_batch_s in[1U];
+/* resolved start vertices */
+static rtz_vtxlst_t st;
+static size_t stz;
+
+
+static void
+handle_batch(rotz_t ctx)
+{
+	if (UNLIKELY(st.z + in->n > stz)) {
+		stz = ((st.z + in->n) / 64U + 1U) * 64U;
+		st.d = realloc(st.d, stz * sizeof(*st.d));
+	}
+	rotz_get_tagsyms(ctx, st.d + st.z, in);
+	st.z += in->n;
+	rotz_batch_clear(in);
+	return;
+}
+
+static void
+handle_input(rotz_t ctx, const char *s, size_t z)
+{
+	rotz_batch_push(in, s, z);
+	if (UNLIKELY(in->n >= RTZ_BATCH_Z)) {
+		handle_batch(ctx);
+	}
+	return;
+}
+
+static int
+prnt_vtxlst(rotz_t ctx, rtz_vtxlst_t vl, int idsp)
+{
+	static struct rtz_names_s nm[1U];
+	routput_t out;
+	const char *const *s;
+
+	if (UNLIKELY((out = make_routput(STDOUT_FILENO)) == NULL)) {
+		return -1;
+	} else if (idsp) {
+		for (size_t i = 0U; i < vl.z; i++) {
+			routput_u(out, vl.d[i]);
+			routput_chr(out, '\n');
+		}
+		goto out;
+	}
+	s = rotz_names(ctx, nm, vl.d, vl.z);
+	for (size_t i = 0U; i < vl.z; i++) {
+		routput_str(out, rotz_massage_name(s[i]));
+		routput_chr(out, '\n');
+	}
+	rotz_names_free(nm);
+out:
+	return free_routput(out);
+}
+
+
+#if defined STANDALONE
+int
+rotz_cmd_reach(const struct yuck_cmd_reach_s argi[static 1U])
+{
+	unsigned int hops = 2U;
+	unsigned int nthr = 1U;
+	rtz_vtxlst_t vl;
+	rotz_t ctx;
+	int rc = 0;
+
+	if (argi->hops_arg) {
+		hops = strtoul(argi->hops_arg, NULL, 0);
+	}
+	if (argi->threads_arg) {
+		nthr = strtoul(argi->threads_arg, NULL, 0);
+	}
+
+	if (UNLIKELY((ctx = make_rotz(db)) == NULL)) {
+		fputs("Error opening rotz datastore\n", stderr);
+		return 1;
+	}
+
+	for (size_t i = 0U; i < argi->nargs; i++) {
+		const char *const input = argi->args[i];
+
+		handle_input(ctx, input, strlen(input));
+	}
+	if (argi->nargs == 0U && !isatty(STDIN_FILENO)) {
+		/* read the guys from STDIN */
+		rinput_t rd = make_rinput(STDIN_FILENO);
+		char *line;
+		size_t llen;
+
+		if (UNLIKELY(rd == NULL)) {
+			fputs("Error: cannot read from stdin\n", stderr);
+			rc = 1;
+			goto fina;
+		}
+		while ((line = rinput_line(rd, &llen)) != NULL) {
+			handle_input(ctx, line, llen);
+		}
+		if (UNLIKELY(rinput_err(rd))) {
+			fputs("Error: cannot read from stdin\n", stderr);
+			rc = 1;
+		}
+		free_rinput(rd);
+	}
+	/* process the remainder */
+	handle_batch(ctx);
+
+	/* go traversing */
+	vl = rotz_reach(ctx, st.d, st.z, hops, nthr);
+	if (UNLIKELY(prnt_vtxlst(ctx, vl, argi->ids_flag) < 0)) {
+		fputs("Error: cannot write results\n", stderr);
+		rc = 1;
+	}
+	rotz_free_vtxlst(vl);
+
+fina:
+	/* big rcource freeing */
+	rotz_free_vtxlst(st);
+	rotz_batch_free(in);
+	free_rotz(ctx);
+	return rc;
+}
+#endif	/* STANDALONE */
+
+/* rotz-reach.c ends here */
@@ -0,0 +1,1490 @@
+/*** rotz-serve.c -- http front-end to rotz
+ *
+ * Copyright (C) 2013-2014 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of rotz.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <strings.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+#include <pthread.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#include "rotz.h"
+#include "rotz-cmd-api.h"
+#include "rotz-umb.h"
+#include "raux.h"
+#include "rshow.h"
+#include "nifty.h"
+
+#if !defined EPOLLEXCLUSIVE
+# define EPOLLEXCLUSIVE	(0U)
+#endif	/* !EPOLLEXCLUSIVE */
+
+/* request headers beyond this size are refused */
+#define SERVE_HDR_MAX	(1U << 16U)
+/* request bodies beyond this size are refused */
+#define SERVE_BODY_MAX	(1U << 26U)
+/* bytes we try to read off a socket in one go */
+#define SERVE_READ_Z	(1U << 16U)
+
+/* buffer that grows as needed */
+struct buf_s {
+	size_t n;
+	size_t z;
+	char *d;
+	/* set when the buffer couldn't grow, its contents are incomplete */
+	bool oom;
+};
+
+struct worker_s;
+
+struct conn_s {
+	int fd;
+	/* epoll events we're waiting for */
+	uint32_t evs;
+	/* request bytes read so far */
+	struct buf_s in;
+	/* response bytes to go out, the first OP of which have */
+	struct buf_s out;
+	size_t op;
+	/* the peer has stopped sending */
+	bool eofp;
+	/* close the connection once the output has gone out */
+	bool closep;
+	/* a write request of ours is with the writer */
+	bool busyp;
+	/* the peer went away while we were busy */
+	bool gonep;
+	/* we told the peer to go ahead with the body */
+	bool contp;
+	/* freed at the end of the current round of events */
+	bool deadp;
+	/* all connections of a worker, or the dead ones */
+	struct conn_s *prev;
+	struct conn_s *next;
+};
+
+/* write requests, carried out by the writer thread */
+struct job_s {
+	struct job_s *next;
+	struct worker_s *w;
+	struct conn_s *c;
+	enum {
+		JOB_ADD,
+		JOB_DEL,
+	} op;
+	/* tag given in the query string or NULL */
+	const char *tag;
+	/* request body, lines of TAG\tSYM or just SYM if there's a tag */
+	char *d;
+	size_t z;
+	/* outcome, status and number of associations changed */
+	unsigned int st;
+	size_t n;
+};
+
+struct worker_s {
+	pthread_t th;
+	int ep;
+	int efd;
+	/* jobs handed back by the writer */
+	pthread_mutex_t mtx;
+	struct job_s *done;
+	/* our connections, and those to be freed */
+	struct conn_s *conns;
+	struct conn_s *dead;
+	/* response body under construction */
+	struct buf_s bdy;
+	/* our database handle and query results */
+	rotz_t ctx;
+	rtz_arena_t ar;
+};
+
+struct req_s {
+	enum {
+		METH_GET,
+		METH_POST,
+	} meth;
+	const char *path;
+	/* decoded query parameters, KEY\0VAL\0 pairs */
+	const char *qry;
+	const char *qend;
+	const char *body;
+	size_t bz;
+	bool keepp;
+	/* the client waits for a 100 before sending the body */
+	bool expp;
+	/* status to respond with if the request is malformed */
+	unsigned int st;
+};
+
+/* the writer's database handle, workers read through clones of it,
+ * each in a snapshot of its own, so DBMTX is only for writes */
+static rotz_t wctx;
+static pthread_mutex_t dbmtx = PTHREAD_MUTEX_INITIALIZER;
+/* the handle and scratch space of the calling thread */
+static __thread rotz_t ctx;
+static __thread struct rtz_names_s nm[1U];
+static __thread struct rtz_batch_s in[1U];
+static __thread rtz_vtx_t tsids[RTZ_BATCH_Z];
+/* query results, cleared after every request */
+static __thread rtz_arena_t ar;
+
+static int lsn = -1;
+static volatile int stopp;
+
+/* write queue */
+static pthread_mutex_t qmtx = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t qcnd = PTHREAD_COND_INITIALIZER;
+static struct job_s *qhead;
+static struct job_s **qtail = &qhead;
+static bool wstopp;
+/* milliseconds a write waits for others to join its transaction */
+static unsigned long coalesce = 10UL;
+
+
+static int
+buf_need(struct buf_s *b, size_t z)
+{
+	if (UNLIKELY(b->n + z > b->z)) {
+		const size_t nz = ((b->n + z) / 4096U + 1U) * 4096U;
+		char *nd;
+
+		if (UNLIKELY((nd = realloc(b->d, nz)) == NULL)) {
+			b->oom = true;
+			return -1;
+		}
+		b->d = nd;
+		b->z = nz;
+	}
+	return 0;
+}
+
+static void
+buf_add(struct buf_s *b, const char *s, size_t z)
+{
+	if (UNLIKELY(buf_need(b, z) < 0)) {
+		return;
+	}
+	memcpy(b->d + b->n, s, z);
+	b->n += z;
+	return;
+}
+
+static void
+buf_str(struct buf_s *b, const char *s)
+{
+	buf_add(b, s, strlen(s));
+	return;
+}
+
+static void
+buf_chr(struct buf_s *b, char c)
+{
+	if (UNLIKELY(buf_need(b, 1U) < 0)) {
+		return;
+	}
+	b->d[b->n++] = c;
+	return;
+}
+
+static void
+buf_u(struct buf_s *b, uint_fast64_t x)
+{
+	char tmp[24U];
+	int z = snprintf(tmp, sizeof(tmp), "%llu", (unsigned long long)x);
+
+	buf_add(b, tmp, z);
+	return;
+}
+
+static void
+buf_free(struct buf_s *b)
+{
+	if (b->d != NULL) {
+		free(b->d);
+	}
+	*b = (struct buf_s){0U};
+	return;
+}
+
+
+/* requests */
+static int
+hexdig(char c)
+{
+	switch (c) {
+	case '0' ... '9':
+		return c - '0';
+	case 'a' ... 'f':
+		return c - 'a' + 10;
+	case 'A' ... 'F':
+		return c - 'A' + 10;
+	default:
+		break;
+	}
+	return -1;
+}
+
+static char*
+qry_decode(char *s, const char *ep)
+{
+/* turn k=v&k=v in S into k\0v\0k\0v\0 in place, parameters without
+ * a value are dropped, return a pointer past the last pair or NULL
+ * if S is malformed */
+	char *tp = s;
+
+	while (s < ep) {
+		char *const kp = tp;
+		bool eqp = false;
+
+		for (; s < ep && *s != '&'; s++) {
+			int hi, lo;
+
+			if (*s == '=' && !eqp) {
+				eqp = true;
+				*tp++ = '\0';
+				continue;
+			} else if (*s == '+') {
+				*tp++ = ' ';
+				continue;
+			} else if (*s != '%') {
+				*tp++ = *s;
+				continue;
+			} else if (UNLIKELY(s + 2U >= ep ||
+					    (hi = hexdig(s[1U])) < 0 ||
+					    (lo = hexdig(s[2U])) < 0 ||
+					    (hi | lo) == 0)) {
+				/* no nuls please */
+				return NULL;
+			}
+			*tp++ = (char)(hi << 4U | lo);
+			s += 2U;
+		}
+		/* skip the & */
+		s += s < ep;
+		if (!eqp) {
+			tp = kp;
+			continue;
+		}
+		*tp++ = '\0';
+	}
+	return tp;
+}
+
+static ssize_t
+req_parse(struct req_s *rq, char *s, size_t z)
+{
+/* parse the request at S of size Z into RQ and return its size,
+ * or 0 if it's incomplete, or -1 if it's malformed */
+	const char *eoh;
+	const char *rle;
+	char *p, *sp, *q;
+	size_t hz, cl = 0U;
+
+	*rq = (struct req_s){0U};
+	if ((eoh = memmem(s, z, "\r\n\r\n", 4U)) == NULL) {
+		if (UNLIKELY(z > SERVE_HDR_MAX)) {
+			rq->st = 431U;
+			return -1;
+		}
+		return 0;
+	}
+	hz = eoh + 4U - s;
+	rle = memchr(s, '\r', hz);
+
+	/* request line */
+	if (rle - s > 4 && !memcmp(s, "GET ", 4U)) {
+		rq->meth = METH_GET;
+		p = s + 4U;
+	} else if (rle - s > 5 && !memcmp(s, "POST ", 5U)) {
+		rq->meth = METH_POST;
+		p = s + 5U;
+	} else {
+		rq->st = 501U;
+		return -1;
+	}
+	if (UNLIKELY(*p != '/' || (sp = memchr(p, ' ', rle - p)) == NULL)) {
+		rq->st = 400U;
+		return -1;
+	} else if (rle - sp == 9 && !memcmp(sp + 1U, "HTTP/1.1", 8U)) {
+		rq->keepp = true;
+	} else if (rle - sp == 9 && !memcmp(sp + 1U, "HTTP/1.0", 8U)) {
+		rq->keepp = false;
+	} else {
+		rq->st = 400U;
+		return -1;
+	}
+
+	/* headers, we only care about a few */
+	for (const char *l = rle + 2U, *le; l < eoh; l = le + 2U) {
+		const char *col;
+		const char *v;
+		size_t nz, vz;
+
+		if ((le = memchr(l, '\r', eoh - l)) == NULL) {
+			le = eoh;
+		}
+		if (UNLIKELY((col = memchr(l, ':', le - l)) == NULL)) {
+			rq->st = 400U;
+			return -1;
+		}
+		nz = col - l;
+		for (v = col + 1U; v < le && (*v == ' ' || *v == '\t'); v++);
+		for (vz = le - v; vz > 0U && v[vz - 1U] == ' '; vz--);
+
+#define HDRP(x)	(nz == sizeof(x) - 1U && !strncasecmp(l, x, nz))
+#define VALP(x)	(vz == sizeof(x) - 1U && !strncasecmp(v, x, vz))
+		if (HDRP("Content-Length")) {
+			if (UNLIKELY(vz == 0U)) {
+				rq->st = 400U;
+				return -1;
+			}
+			cl = 0U;
+			for (size_t i = 0U; i < vz; i++) {
+				if (UNLIKELY(v[i] < '0' || v[i] > '9')) {
+					rq->st = 400U;
+					return -1;
+				} else if (UNLIKELY(cl > SERVE_BODY_MAX)) {
+					break;
+				}
+				cl = cl * 10U + (v[i] - '0');
+			}
+		} else if (HDRP("Transfer-Encoding")) {
+			/* we insist on a content length */
+			rq->st = 411U;
+			return -1;
+		} else if (HDRP("Connection")) {
+			if (VALP("close")) {
+				rq->keepp = false;
+			} else if (VALP("keep-alive")) {
+				rq->keepp = true;
+			}
+		} else if (HDRP("Expect")) {
+			rq->expp = VALP("100-continue");
+		}
+#undef HDRP
+#undef VALP
+	}
+	if (UNLIKELY(cl > SERVE_BODY_MAX)) {
+		rq->st = 413U;
+		return -1;
+	} else if (z < hz + cl) {
+		/* body's still on its way */
+		return 0;
+	}
+	rq->body = s + hz;
+	rq->bz = cl;
+
+	/* now that we know it's all there, chop up the request target */
+	*sp = '\0';
+	rq->path = p;
+	rq->qry = rq->qend = sp;
+	if ((q = memchr(p, '?', sp - p)) != NULL) {
+		*q++ = '\0';
+		rq->qry = q;
+		if (UNLIKELY((rq->qend = qry_decode(q, sp)) == NULL)) {
+			rq->st = 400U;
+			return -1;
+		}
+	}
+	return hz + cl;
+}
+
+static const char*
+par_get(const struct req_s *rq, const char *key)
+{
+	for (const char *k = rq->qry, *v; k < rq->qend; k = v + strlen(v) + 1U) {
+		v = k + strlen(k) + 1U;
+		if (!strcmp(k, key)) {
+			return v;
+		}
+	}
+	return NULL;
+}
+
+/* inputs of a request, q parameters then body lines */
+struct inp_s {
+	const char *qp;
+	const char *qe;
+	const char *bp;
+	const char *be;
+};
+
+static struct inp_s
+make_inp(const struct req_s *rq)
+{
+	return (struct inp_s){
+		.qp = rq->qry, .qe = rq->qend,
+		.bp = rq->body, .be = rq->body + rq->bz,
+	};
+}
+
+static const char*
+inp_next(struct inp_s *it, size_t *z)
+{
+	while (it->qp < it->qe) {
+		const char *k = it->qp;
+		const char *v = k + strlen(k) + 1U;
+
+		it->qp = v + (*z = strlen(v)) + 1U;
+		if (!strcmp(k, "q") && *z) {
+			return v;
+		}
+	}
+	while (it->bp < it->be) {
+		const char *l = it->bp;
+		const char *eol;
+
+		if ((eol = memchr(l, '\n', it->be - l)) == NULL) {
+			eol = it->be;
+		}
+		it->bp = eol + (eol < it->be);
+		*z = eol - l - (eol > l && eol[-1] == '\r');
+		if (*z) {
+			return l;
+		}
+	}
+	return NULL;
+}
+
+
+/* readers, called in a snapshot of the worker's handle */
+static void
+prnt_vtxlst(void *clo, rtz_const_vtxlst_t el, const char *pair, size_t pz)
+{
+	struct buf_s *o = clo;
+	const char *const *s = rotz_names(ctx, nm, el.d, el.z);
+
+	for (size_t j = 0; j < el.z; j++) {
+		if (pair != NULL) {
+			buf_add(o, pair, pz);
+			buf_chr(o, '\t');
+		}
+		buf_str(o, rotz_massage_name(s[j]));
+		buf_chr(o, '\n');
+	}
+	return;
+}
+
+static int
+show_all_cb(rtz_vtx_t UNUSED(vid), const char *vtx, void *clo)
+{
+	struct rshow_s *sh = clo;
+	const bool symp = !memcmp(vtx, RTZ_SYMSPC, sizeof(RTZ_SYMSPC) - 1);
+
+	if (symp == (sh->mode == RSHOW_PAIRS)) {
+		buf_str(sh->clo, rotz_massage_name(vtx));
+		buf_chr(sh->clo, '\n');
+	}
+	return 0;
+}
+
+static unsigned int
+do_show(struct buf_s *o, const struct req_s *rq)
+{
+	struct rshow_s sh = {
+		.ctx = ctx,
+		.ar = ar,
+		.prnt = prnt_vtxlst,
+		.clo = o,
+		.in = in,
+		.tsids = tsids,
+	};
+	struct inp_s it = make_inp(rq);
+	const char *op = par_get(rq, "op");
+	const char *s;
+	size_t z;
+
+	if (op == NULL) {
+		sh.mode = rq->meth == METH_POST || par_get(rq, "pairs")
+			? RSHOW_PAIRS : RSHOW_EDGES;
+	} else if (!strcmp(op, "union")) {
+		sh.mode = RSHOW_UNION;
+	} else if (!strcmp(op, "intersection")) {
+		sh.mode = RSHOW_ISECT;
+	} else {
+		return 400U;
+	}
+
+	if ((s = inp_next(&it, &z)) == NULL) {
+		/* all tags, or all syms */
+		sh.mode = par_get(rq, "syms") ? RSHOW_PAIRS : RSHOW_EDGES;
+		rotz_vtx_iter(ctx, show_all_cb, &sh);
+		return 200U;
+	}
+	do {
+		rshow_push(&sh, s, z);
+	} while ((s = inp_next(&it, &z)) != NULL);
+	if (UNLIKELY(rshow_flush(&sh) < 0)) {
+		return 500U;
+	}
+
+	if (sh.mode == RSHOW_UNION || sh.mode == RSHOW_ISECT) {
+		prnt_vtxlst(o, (rtz_const_vtxlst_t){sh.r.vl.z, sh.r.vl.d},
+			    NULL, 0U);
+	}
+	return 200U;
+}
+
+static void
+grep_batch(struct buf_s *o, bool invp)
+{
+	const char *const *ip;
+
+	rotz_get_tagsyms(ctx, tsids, in);
+	ip = rotz_batch_seal(in);
+	for (size_t i = 0U; i < in->n; i++) {
+		if (!tsids[i] == invp) {
+			buf_str(o, ip[i]);
+			buf_chr(o, '\n');
+		}
+	}
+	rotz_batch_clear(in);
+	return;
+}
+
+static unsigned int
+do_grep(struct buf_s *o, const struct req_s *rq)
+{
+	struct inp_s it = make_inp(rq);
+	const bool invp = par_get(rq, "invert") != NULL;
+	const char *s;
+	size_t z;
+
+	while ((s = inp_next(&it, &z)) != NULL) {
+		rotz_batch_push(in, s, z);
+		if (UNLIKELY(in->n >= RTZ_BATCH_Z)) {
+			grep_batch(o, invp);
+		}
+	}
+	grep_batch(o, invp);
+	return 200U;
+}
+
+static int
+search_cb(rtz_const_buf_t k, rtz_const_buf_t v, void *clo)
+{
+	struct buf_s *o = clo;
+	rtz_vtx_t vid;
+
+	memcpy(&vid, v.d, sizeof(vid));
+	buf_str(o, rotz_massage_name(k.d));
+	buf_chr(o, '\t');
+	buf_u(o, rotz_get_nedges(ctx, vid));
+	buf_chr(o, '\n');
+	return 0;
+}
+
+static unsigned int
+do_search(struct buf_s *o, const struct req_s *rq)
+{
+	const char *q;
+
+	if ((q = par_get(rq, "q")) == NULL || !*q) {
+		return 400U;
+	}
+	q = rotz_tag(q);
+	rotz_iter(ctx, (rtz_const_buf_t){strlen(q), q}, search_cb, o);
+	return 200U;
+}
+
+struct cloud_s {
+	struct buf_s *o;
+	/* collect tags for a top-N cloud, Z is the capacity */
+	bool topp;
+	size_t z;
+	rtz_wtxlst_t wl;
+};
+
+static int
+cloud_cb(rtz_vtx_t vid, const char *vtx, void *clo)
+{
+	struct cloud_s *cl = clo;
+	size_t ne;
+
+	if (!memcmp(vtx, RTZ_SYMSPC, sizeof(RTZ_SYMSPC) - 1)) {
+		/* that's a symbol */
+		return 0;
+	}
+	ne = rotz_get_nedges(ctx, vid);
+	if (!cl->topp) {
+		buf_str(cl->o, rotz_massage_name(vtx));
+		buf_chr(cl->o, '\t');
+		buf_u(cl->o, ne);
+		buf_chr(cl->o, '\n');
+		return 0;
+	} else if (UNLIKELY(cl->wl.z >= cl->z)) {
+		const size_t nz = (cl->z + 64U) * 2U;
+		rtz_vtx_t *nd;
+		unsigned int *nw;
+
+		if (UNLIKELY((nd = realloc(
+				      cl->wl.d, nz * sizeof(*nd))) == NULL)) {
+			cl->o->oom = true;
+			return -1;
+		}
+		cl->wl.d = nd;
+		if (UNLIKELY((nw = realloc(
+				      cl->wl.w, nz * sizeof(*nw))) == NULL)) {
+			cl->o->oom = true;
+			return -1;
+		}
+		cl->wl.w = nw;
+		cl->z = nz;
+	}
+	cl->wl.d[cl->wl.z] = vid;
+	cl->wl.w[cl->wl.z] = ne;
+	cl->wl.z++;
+	return 0;
+}
+
+static unsigned int
+do_cloud(struct buf_s *o, const struct req_s *rq)
+{
+	struct cloud_s cl = {.o = o};
+	const char *top = par_get(rq, "top");
+	const char *const *s;
+	size_t n;
+
+	if (top == NULL) {
+		rotz_vtx_iter(ctx, cloud_cb, &cl);
+		return 200U;
+	}
+	n = strtoul(top, NULL, 0);
+	cl.topp = true;
+	rotz_vtx_iter(ctx, cloud_cb, &cl);
+	if (UNLIKELY(o->oom)) {
+		rotz_free_wtxlst(cl.wl);
+		return 500U;
+	}
+
+	n = top_wtxlst(cl.wl, n);
+	s = rotz_names(ctx, nm, cl.wl.d, n);
+	for (size_t i = 0U; i < n; i++) {
+		buf_str(o, rotz_massage_name(s[i]));
+		buf_chr(o, '\t');
+		buf_u(o, cl.wl.w[i]);
+		buf_chr(o, '\n');
+	}
+	rotz_free_wtxlst(cl.wl);
+	return 200U;
+}
+
+
+/* writer */
+static size_t
+add_one(const char *tag, const char *sym)
+{
+	const char *v;
+	rtz_vtx_t t, s;
+
+	/* tag first, rotz_tag() and rotz_sym() share their buffer */
+	if ((v = rotz_tag(tag)) == NULL) {
+		return 0U;
+	} else if (!(t = rotz_get_vertex(ctx, v)) &&
+		   !(t = rotz_add_vertex(ctx, v))) {
+		return 0U;
+	} else if ((v = rotz_sym(sym)) == NULL) {
+		return 0U;
+	} else if (!(s = rotz_get_vertex(ctx, v)) &&
+		   !(s = rotz_add_vertex(ctx, v))) {
+		return 0U;
+	}
+	rotz_add_edge(ctx, t, s);
+	rotz_add_edge(ctx, s, t);
+	return 1U;
+}
+
+static size_t
+del_one(const char *tag, const char *sym)
+{
+	const char *v;
+	rtz_vtx_t t, s;
+
+	if ((v = rotz_tag(tag)) == NULL || !(t = rotz_get_vertex(ctx, v))) {
+		return 0U;
+	} else if ((v = rotz_sym(sym)) == NULL ||
+		   !(s = rotz_get_vertex(ctx, v))) {
+		return 0U;
+	}
+	rotz_rem_edge(ctx, t, s);
+	rotz_rem_edge(ctx, s, t);
+	return 1U;
+}
+
+static size_t
+job_apply(struct job_s *j)
+{
+	char *const ep = j->d + j->z;
+	size_t n = 0U;
+
+	for (char *l = j->d, *eol; l < ep; l = eol + 1U) {
+		const char *tag = j->tag;
+		const char *sym = l;
+
+		if ((eol = memchr(l, '\n', ep - l)) == NULL) {
+			eol = ep;
+		}
+		*eol = '\0';
+		if (eol > l && eol[-1] == '\r') {
+			eol[-1] = '\0';
+		}
+		if (tag == NULL) {
+			char *tab;
+
+			if ((tab = strchr(l, '\t')) == NULL) {
+				continue;
+			}
+			*tab = '\0';
+			tag = l;
+			sym = tab + 1U;
+		}
+		switch (j->op) {
+		case JOB_ADD:
+			n += add_one(tag, sym);
+			break;
+		case JOB_DEL:
+			n += del_one(tag, sym);
+			break;
+		}
+	}
+	return n;
+}
+
+static void
+commit_jobs(struct job_s *jq)
+{
+/* apply all jobs in JQ in one transaction and hand them back */
+	unsigned int st = 200U;
+
+	pthread_mutex_lock(&dbmtx);
+	if (UNLIKELY(rotz_begin(ctx) < 0)) {
+		st = 503U;
+	} else {
+		for (struct job_s *j = jq; j != NULL; j = j->next) {
+			j->n = job_apply(j);
+		}
+		if (UNLIKELY(rotz_commit(ctx) < 0)) {
+			st = 500U;
+		}
+	}
+	pthread_mutex_unlock(&dbmtx);
+
+	for (struct job_s *j = jq, *nx; j != NULL; j = nx) {
+		static const uint64_t one = 1U;
+		struct worker_s *w = j->w;
+
+		nx = j->next;
+		j->st = st;
+		pthread_mutex_lock(&w->mtx);
+		j->next = w->done;
+		w->done = j;
+		pthread_mutex_unlock(&w->mtx);
+		if (UNLIKELY(write(w->efd, &one, sizeof(one)) < 0)) {
+			/* can't be, the counter would have to overflow */
+			;
+		}
+	}
+	return;
+}
+
+static void*
+write_loop(void *UNUSED(clo))
+{
+	ctx = wctx;
+	pthread_mutex_lock(&qmtx);
+	while (1) {
+		struct job_s *jq;
+
+		while (qhead == NULL && !wstopp) {
+			pthread_cond_wait(&qcnd, &qmtx);
+		}
+		if (qhead == NULL) {
+			break;
+		} else if (coalesce && !wstopp) {
+			/* give other writes a chance to join the transaction */
+			pthread_mutex_unlock(&qmtx);
+			usleep(coalesce * 1000UL);
+			pthread_mutex_lock(&qmtx);
+		}
+		jq = qhead;
+		qhead = NULL;
+		qtail = &qhead;
+		pthread_mutex_unlock(&qmtx);
+
+		commit_jobs(jq);
+
+		pthread_mutex_lock(&qmtx);
+	}
+	pthread_mutex_unlock(&qmtx);
+	return NULL;
+}
+
+static int
+enqueue(struct worker_s *w, struct conn_s *c, const struct req_s *rq, int op)
+{
+	const char *tag = par_get(rq, "tag");
+	const size_t tz = tag != NULL ? strlen(tag) + 1U : 0U;
+	struct job_s *j;
+	char *p;
+
+	if (UNLIKELY((j = malloc(sizeof(*j) + tz + rq->bz + 1U)) == NULL)) {
+		return -1;
+	}
+	*j = (struct job_s){.w = w, .c = c, .op = op};
+	p = (char*)(j + 1U);
+	if (tag != NULL) {
+		j->tag = memcpy(p, tag, tz);
+		p += tz;
+	}
+	j->d = memcpy(p, rq->body, rq->bz);
+	j->d[j->z = rq->bz] = '\0';
+	c->busyp = true;
+
+	pthread_mutex_lock(&qmtx);
+	*qtail = j;
+	qtail = &j->next;
+	pthread_cond_signal(&qcnd);
+	pthread_mutex_unlock(&qmtx);
+	return 0;
+}
+
+
+/* connections */
+static const char*
+status_text(unsigned int st)
+{
+	switch (st) {
+	case 200U:
+		return "OK";
+	case 400U:
+		return "Bad Request";
+	case 404U:
+		return "Not Found";
+	case 405U:
+		return "Method Not Allowed";
+	case 411U:
+		return "Length Required";
+	case 413U:
+		return "Payload Too Large";
+	case 431U:
+		return "Request Header Fields Too Large";
+	case 501U:
+		return "Not Implemented";
+	case 503U:
+		return "Service Unavailable";
+	default:
+		break;
+	}
+	return "Internal Server Error";
+}
+
+static void
+respond(struct conn_s *c, unsigned int st, const struct buf_s *bdy)
+{
+	const char *txt = status_text(st);
+	struct buf_s *o = &c->out;
+
+	buf_str(o, "HTTP/1.1 ");
+	buf_u(o, st);
+	buf_chr(o, ' ');
+	buf_str(o, txt);
+	buf_str(o, "\r\nContent-Type: text/plain\r\nContent-Length: ");
+	if (st >= 400U) {
+		/* errors get their reason as body */
+		buf_u(o, strlen(txt) + 1U);
+	} else {
+		buf_u(o, bdy->n);
+	}
+	if (c->closep) {
+		buf_str(o, "\r\nConnection: close");
+	}
+	buf_str(o, "\r\n\r\n");
+	if (st >= 400U) {
+		buf_str(o, txt);
+		buf_chr(o, '\n');
+	} else {
+		buf_add(o, bdy->d, bdy->n);
+	}
+	return;
+}
+
+static void
+conn_free(struct worker_s *w, struct conn_s *c)
+{
+/* unlink C and put it on the dead list, the current round of events
+ * might still refer to it */
+	if (c->fd >= 0) {
+		close(c->fd);
+		c->fd = -1;
+	}
+	if (c->prev != NULL) {
+		c->prev->next = c->next;
+	} else {
+		w->conns = c->next;
+	}
+	if (c->next != NULL) {
+		c->next->prev = c->prev;
+	}
+	c->deadp = true;
+	c->prev = NULL;
+	c->next = w->dead;
+	w->dead = c;
+	return;
+}
+
+static void
+conn_drop(struct worker_s *w, struct conn_s *c)
+{
+	if (c->busyp) {
+		/* the writer still has our job, free C when it's back */
+		close(c->fd);
+		c->fd = -1;
+		c->gonep = true;
+		return;
+	}
+	conn_free(w, c);
+	return;
+}
+
+static void
+conn_watch(struct worker_s *w, struct conn_s *c, uint32_t evs)
+{
+	if (evs != c->evs) {
+		struct epoll_event ev = {.events = evs, .data.ptr = c};
+
+		epoll_ctl(w->ep, EPOLL_CTL_MOD, c->fd, &ev);
+		c->evs = evs;
+	}
+	return;
+}
+
+static void
+conn_flush(struct worker_s *w, struct conn_s *c)
+{
+	if (UNLIKELY(c->out.oom)) {
+		/* a response got cut short, the stream can't be trusted */
+		conn_drop(w, c);
+		return;
+	}
+	while (c->op < c->out.n) {
+		ssize_t nwr = send(
+			c->fd, c->out.d + c->op, c->out.n - c->op,
+			MSG_NOSIGNAL);
+
+		if (nwr >= 0) {
+			c->op += nwr;
+		} else if (errno == EINTR) {
+			;
+		} else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+			break;
+		} else {
+			conn_drop(w, c);
+			return;
+		}
+	}
+	if (c->op < c->out.n) {
+		conn_watch(w, c, (c->eofp ? 0U : EPOLLIN) | EPOLLOUT);
+		return;
+	}
+	c->op = c->out.n = 0U;
+	if (c->closep && !c->busyp) {
+		conn_free(w, c);
+		return;
+	}
+	conn_watch(w, c, c->eofp ? 0U : EPOLLIN);
+	return;
+}
+
+static int
+conn_read(struct conn_s *c)
+{
+/* read what's there, return 1 if the peer's done sending, -1 on error */
+	while (1) {
+		ssize_t nrd;
+
+		if (UNLIKELY(buf_need(&c->in, SERVE_READ_Z) < 0)) {
+			return -1;
+		}
+		nrd = recv(c->fd, c->in.d + c->in.n, c->in.z - c->in.n, 0);
+		if (nrd > 0) {
+			c->in.n += nrd;
+			if (UNLIKELY(c->in.n > 2U * SERVE_BODY_MAX)) {
+				return -1;
+			}
+		} else if (nrd == 0) {
+			return 1;
+		} else if (errno == EINTR) {
+			;
+		} else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+			return 0;
+		} else {
+			return -1;
+		}
+	}
+}
+
+static void
+handle(struct worker_s *w, struct conn_s *c, const struct req_s *rq)
+{
+	unsigned int(*fn)(struct buf_s*, const struct req_s*);
+	unsigned int st;
+	int op;
+
+	if (!strcmp(rq->path, "/show")) {
+		fn = do_show;
+	} else if (!strcmp(rq->path, "/grep")) {
+		fn = do_grep;
+	} else if (!strcmp(rq->path, "/search")) {
+		fn = do_search;
+	} else if (!strcmp(rq->path, "/cloud")) {
+		fn = do_cloud;
+	} else if (!strcmp(rq->path, "/add")) {
+		op = JOB_ADD;
+		goto wr;
+	} else if (!strcmp(rq->path, "/del")) {
+		op = JOB_DEL;
+		goto wr;
+	} else {
+		st = 404U;
+		goto resp;
+	}
+
+	w->bdy.n = 0U;
+	w->bdy.oom = false;
+	if (UNLIKELY(rotz_begin_read(ctx) < 0)) {
+		st = 503U;
+		goto resp;
+	}
+	st = fn(&w->bdy, rq);
+	rotz_end_read(ctx);
+	rotz_clear_arena(ar);
+	if (UNLIKELY(w->bdy.oom)) {
+		/* don't hand out half a result */
+		st = 500U;
+	}
+	goto resp;
+
+wr:
+	if (rq->meth != METH_POST) {
+		st = 405U;
+	} else if (UNLIKELY(enqueue(w, c, rq, op) < 0)) {
+		st = 503U;
+	} else {
+		/* the writer will get back to us */
+		return;
+	}
+resp:
+	respond(c, st, &w->bdy);
+	return;
+}
+
+static void
+conn_serve(struct worker_s *w, struct conn_s *c)
+{
+/* handle the complete requests in C's input, in order */
+	while (!c->busyp && !c->closep && c->in.n > 0U) {
+		struct req_s rq;
+		ssize_t n;
+
+		if ((n = req_parse(&rq, c->in.d, c->in.n)) < 0) {
+			c->closep = true;
+			respond(c, rq.st, NULL);
+			break;
+		} else if (n == 0) {
+			if (rq.expp && !c->contp) {
+				buf_str(&c->out, "HTTP/1.1 100 Continue\r\n\r\n");
+				c->contp = true;
+			}
+			break;
+		}
+		c->contp = false;
+		c->closep = !rq.keepp;
+		handle(w, c, &rq);
+		/* consume the request */
+		c->in.n -= n;
+		memmove(c->in.d, c->in.d + n, c->in.n);
+	}
+	if (c->eofp && !c->busyp) {
+		c->closep = true;
+	}
+	return;
+}
+
+static void
+conn_accept(struct worker_s *w)
+{
+	int fd;
+
+	while ((fd = accept4(lsn, NULL, NULL,
+			     SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+		static const int yes = 1;
+		struct epoll_event ev = {.events = EPOLLIN};
+		struct conn_s *c;
+
+		if (UNLIKELY((c = calloc(1U, sizeof(*c))) == NULL)) {
+			close(fd);
+			continue;
+		}
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+		c->fd = fd;
+		c->evs = ev.events;
+		ev.data.ptr = c;
+		if (UNLIKELY(epoll_ctl(w->ep, EPOLL_CTL_ADD, fd, &ev) < 0)) {
+			close(fd);
+			free(c);
+			continue;
+		}
+		if ((c->next = w->conns) != NULL) {
+			c->next->prev = c;
+		}
+		w->conns = c;
+	}
+	return;
+}
+
+static void
+conn_ev(struct worker_s *w, struct conn_s *c, uint32_t evs)
+{
+	if (c->deadp || c->gonep) {
+		/* freed earlier this round */
+		return;
+	}
+	if (evs & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+		switch (conn_read(c)) {
+		case 0:
+			break;
+		case 1:
+			c->eofp = true;
+			break;
+		default:
+			conn_drop(w, c);
+			return;
+		}
+	}
+	conn_serve(w, c);
+	conn_flush(w, c);
+	return;
+}
+
+static void
+work_done(struct worker_s *w)
+{
+/* take back the jobs the writer is done with */
+	struct job_s *jq;
+	uint64_t cnt;
+
+	if (read(w->efd, &cnt, sizeof(cnt)) < 0) {
+		/* no news */
+		;
+	}
+	pthread_mutex_lock(&w->mtx);
+	jq = w->done;
+	w->done = NULL;
+	pthread_mutex_unlock(&w->mtx);
+
+	for (struct job_s *j = jq, *nx; j != NULL; j = nx) {
+		struct conn_s *c = j->c;
+
+		nx = j->next;
+		c->busyp = false;
+		if (c->gonep) {
+			conn_free(w, c);
+		} else {
+			w->bdy.n = 0U;
+			w->bdy.oom = false;
+			buf_u(&w->bdy, j->n);
+			buf_chr(&w->bdy, '\n');
+			respond(c, j->st, &w->bdy);
+			/* there might be more requests waiting */
+			conn_serve(w, c);
+			conn_flush(w, c);
+		}
+		free(j);
+	}
+	return;
+}
+
+static void*
+work(void *clo)
+{
+	struct worker_s *w = clo;
+
+	ctx = w->ctx;
+	ar = w->ar;
+	while (!stopp) {
+		struct epoll_event ev[64U];
+		int n = epoll_wait(w->ep, ev, countof(ev), -1);
+
+		for (int i = 0; i < n; i++) {
+			void *p = ev[i].data.ptr;
+
+			if (p == &lsn) {
+				conn_accept(w);
+			} else if (p == w) {
+				work_done(w);
+			} else {
+				conn_ev(w, p, ev[i].events);
+			}
+		}
+		/* now it's safe to free the dead */
+		for (struct conn_s *c = w->dead, *nx; c != NULL; c = nx) {
+			nx = c->next;
+			buf_free(&c->in);
+			buf_free(&c->out);
+			free(c);
+		}
+		w->dead = NULL;
+	}
+	rotz_batch_free(in);
+	rotz_names_free(nm);
+	return NULL;
+}
+
+static int
+work_init(struct worker_s *w)
+{
+	struct epoll_event ev;
+
+	*w = (struct worker_s){.ep = -1, .efd = -1};
+	pthread_mutex_init(&w->mtx, NULL);
+	if (UNLIKELY((w->ctx = rotz_clone(wctx)) == NULL)) {
+		return -1;
+	} else if (UNLIKELY((w->ar = rotz_make_arena()) == NULL)) {
+		return -1;
+	} else if (UNLIKELY((w->ep = epoll_create1(EPOLL_CLOEXEC)) < 0)) {
+		return -1;
+	} else if (UNLIKELY((w->efd = eventfd(
+				     0U, EFD_NONBLOCK | EFD_CLOEXEC)) < 0)) {
+		return -1;
+	}
+	ev = (struct epoll_event){.events = EPOLLIN, .data.ptr = w};
+	if (UNLIKELY(epoll_ctl(w->ep, EPOLL_CTL_ADD, w->efd, &ev) < 0)) {
+		return -1;
+	}
+	/* only wake one of the workers for a new connection */
+	ev = (struct epoll_event){
+		.events = EPOLLIN | EPOLLEXCLUSIVE, .data.ptr = &lsn,
+	};
+	if (UNLIKELY(epoll_ctl(w->ep, EPOLL_CTL_ADD, lsn, &ev) < 0)) {
+		return -1;
+	}
+	return 0;
+}
+
+static void
+work_fini(struct worker_s *w)
+{
+	for (struct job_s *j = w->done, *nx; j != NULL; j = nx) {
+		nx = j->next;
+		free(j);
+	}
+	while (w->conns != NULL) {
+		conn_free(w, w->conns);
+	}
+	for (struct conn_s *c = w->dead, *nx; c != NULL; c = nx) {
+		nx = c->next;
+		buf_free(&c->in);
+		buf_free(&c->out);
+		free(c);
+	}
+	buf_free(&w->bdy);
+	if (w->efd >= 0) {
+		close(w->efd);
+	}
+	if (w->ep >= 0) {
+		close(w->ep);
+	}
+	if (w->ar != NULL) {
+		rotz_free_arena(w->ar);
+	}
+	if (w->ctx != NULL) {
+		free_rotz(w->ctx);
+	}
+	pthread_mutex_destroy(&w->mtx);
+	return;
+}
+
+static int
+listen_on(const char *addr, const char *port)
+{
+	struct addrinfo hints = {
+		.ai_family = AF_UNSPEC,
+		.ai_socktype = SOCK_STREAM,
+		.ai_flags = AI_PASSIVE,
+	};
+	struct addrinfo *ai;
+	int s = -1;
+
+	if (getaddrinfo(addr, port, &hints, &ai) != 0) {
+		return -1;
+	}
+	for (const struct addrinfo *a = ai; a != NULL; a = a->ai_next) {
+		static const int yes = 1;
+
+		s = socket(a->ai_family,
+			   a->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC,
+			   a->ai_protocol);
+		if (s < 0) {
+			continue;
+		}
+		setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+		if (bind(s, a->ai_addr, a->ai_addrlen) == 0 &&
+		    listen(s, SOMAXCONN) == 0) {
+			break;
+		}
+		close(s);
+		s = -1;
+	}
+	freeaddrinfo(ai);
+	return s;
+}
+
+
+#if defined STANDALONE
+int
+rotz_cmd_serve(const struct yuck_cmd_serve_s argi[static 1U])
+{
+	const char *addr = argi->address_arg ?: "127.0.0.1";
+	const char *port = argi->port_arg ?: "8080";
+	size_t nthr = 4U;
+	struct worker_s *w = NULL;
+	pthread_t wr;
+	size_t i = 0U;
+	/* number of workers running */
+	size_t nup = 0U;
+	sigset_t ss;
+	int rc = 0;
+
+	if (argi->threads_arg && !(nthr = strtoul(argi->threads_arg, NULL, 0))) {
+		fputs("Error: need at least one worker thread\n", stderr);
+		return 1;
+	}
+	if (argi->coalesce_arg) {
+		coalesce = strtoul(argi->coalesce_arg, NULL, 0);
+	}
+
+	if (UNLIKELY((wctx = make_rotz(db, O_CREAT | O_RDWR)) == NULL)) {
+		fputs("Error opening rotz datastore\n", stderr);
+		return 1;
+	} else if (UNLIKELY((lsn = listen_on(addr, port)) < 0)) {
+		fprintf(stderr, "Error: cannot listen on %s:%s\n", addr, port);
+		rc = 1;
+		goto clo;
+	} else if (UNLIKELY((w = calloc(nthr, sizeof(*w))) == NULL)) {
+		rc = 1;
+		goto clo;
+	}
+	for (; i < nthr; i++) {
+		if (UNLIKELY(work_init(w + i) < 0)) {
+			fputs("Error: cannot set up worker\n", stderr);
+			rc = 1;
+			i++;
+			goto fin;
+		}
+	}
+
+	/* signals are for this thread only, block them before spawning */
+	sigemptyset(&ss);
+	sigaddset(&ss, SIGINT);
+	sigaddset(&ss, SIGTERM);
+	sigaddset(&ss, SIGHUP);
+	pthread_sigmask(SIG_BLOCK, &ss, NULL);
+
+	if (UNLIKELY(pthread_create(&wr, NULL, write_loop, NULL))) {
+		fputs("Error: cannot start writer thread\n", stderr);
+		rc = 1;
+		goto fin;
+	}
+	for (; nup < nthr; nup++) {
+		if (UNLIKELY(pthread_create(&w[nup].th, NULL, work, w + nup))) {
+			fputs("Error: cannot start worker thread\n", stderr);
+			rc = 1;
+			break;
+		}
+	}
+	if (LIKELY(nup == nthr)) {
+		int sig;
+		sigwait(&ss, &sig);
+	}
+
+	/* stop taking requests */
+	stopp = 1;
+	for (size_t j = 0U; j < nup; j++) {
+		static const uint64_t one = 1U;
+
+		if (write(w[j].efd, &one, sizeof(one)) < 0) {
+			;
+		}
+		pthread_join(w[j].th, NULL);
+	}
+	/* let the writer commit what's still queued */
+	pthread_mutex_lock(&qmtx);
+	wstopp = true;
+	pthread_cond_signal(&qcnd);
+	pthread_mutex_unlock(&qmtx);
+	pthread_join(wr, NULL);
+
+fin:
+	while (i-- > 0U) {
+		work_fini(w + i);
+	}
+	free(w);
+clo:
+	/* big rcource freeing */
+	if (lsn >= 0) {
+		close(lsn);
+	}
+	free_rotz(wctx);
+	return rc;
+}
+#endif	/* STANDALONE */
+
+/* rotz-serve.c ends here */
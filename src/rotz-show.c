@@ -46,55 +46,79 @@
 #include "rotz.h"
 #include "rotz-cmd-api.h"
 #include "rotz-umb.h"
+#include "rinput.h"
+#include "routput.h"
 #include "raux.h"
+#include "rshow.h"
 #include "nifty.h"
 
 
+/* print vertex ids instead of names */
+static int idsp;
+static struct rtz_names_s nm[1U];
+static routput_t out;
+
 static int
-iter_cb(rtz_vtx_t UNUSED(vid), const char *vtx, void *UNUSED(clo))
+iter_cb(rtz_vtx_t vid, const char *vtx, void *UNUSED(clo))
 {
 	if (memcmp(vtx, RTZ_SYMSPC, sizeof(RTZ_SYMSPC) - 1) == 0) {
 		/* that's a symbol, vtx would be a tag then */
 		return 0;
+	} else if (idsp) {
+		routput_u(out, vid);
+		routput_chr(out, '\n');
+		return 0;
 	} else if (memcmp(vtx, RTZ_TAGSPC, sizeof(RTZ_TAGSPC) - 1) == 0) {
 		vtx += RTZ_PRE_Z;
 	}
-	puts(vtx);
+	routput_str(out, vtx);
+	routput_chr(out, '\n');
 	return 0;
 }
 
 static int
-iter_syms_cb(rtz_vtx_t UNUSED(vid), const char *vtx, void *UNUSED(clo))
+iter_syms_cb(rtz_vtx_t vid, const char *vtx, void *UNUSED(clo))
 {
 	if (memcmp(vtx, RTZ_SYMSPC, sizeof(RTZ_SYMSPC) - 1) != 0) {
 		/* it's not a symbol, bugger off */
 		return 0;
+	} else if (idsp) {
+		routput_u(out, vid);
+		routput_chr(out, '\n');
+		return 0;
 	}
 	vtx += RTZ_PRE_Z;
-	puts(vtx);
+	routput_str(out, vtx);
+	routput_chr(out, '\n');
 	return 0;
 }
 
 static void
-prnt_vtxlst(rotz_t ctx, rtz_vtxlst_t el)
+prnt_vtxlst(void *clo, rtz_const_vtxlst_t el, const char *pair, size_t pz)
 {
-	for (size_t j = 0; j < el.z; j++) {
-		const char *s = rotz_get_name(ctx, el.d[j]);
-		puts(rotz_massage_name(s));
+	rotz_t ctx = clo;
+	const char *const *s;
+
+	if (idsp) {
+		for (size_t j = 0; j < el.z; j++) {
+			if (pair != NULL) {
+				routput_buf(out, pair, pz);
+				routput_chr(out, '\t');
+			}
+			routput_u(out, el.d[j]);
+			routput_chr(out, '\n');
+		}
+		return;
 	}
-	return;
-}
-
-static void
-prnt_vtxlst_pair(rotz_t ctx, rtz_vtxlst_t el, const char *pair)
-{
+	/* resolve all names in one go */
+	s = rotz_names(ctx, nm, el.d, el.z);
 	for (size_t j = 0; j < el.z; j++) {
-		const char *s = rotz_get_name(ctx, el.d[j]);
-
-		fputs(pair, stdout);
-		fputc('\t', stdout);
-		fputs(rotz_massage_name(s), stdout);
-		fputc('\n', stdout);
+		if (pair != NULL) {
+			routput_buf(out, pair, pz);
+			routput_chr(out, '\t');
+		}
+		routput_str(out, rotz_massage_name(s[j]));
+		routput_chr(out, '\n');
 	}
 	return;
 }
@@ -102,122 +126,99 @@ prnt_vtxlst_pair(rotz_t ctx, rtz_vtxlst_t el, const char *pair)
 static void
 prnt_wtxlst(rotz_t ctx, rtz_wtxlst_t wl)
 {
-	/* quick service */
+	const char *const *s;
 
+	/* quick service */
+	if (idsp) {
+		for (size_t j = 0; j < wl.z; j++) {
+			routput_u(out, wl.d[j]);
+			routput_chr(out, '\t');
+			routput_u(out, wl.w[j] + 1U);
+			routput_chr(out, '\n');
+		}
+		return;
+	}
+	s = rotz_names(ctx, nm, wl.d, wl.z);
 	for (size_t j = 0; j < wl.z; j++) {
-		const char *s = rotz_get_name(ctx, wl.d[j]);
-		fputs(rotz_massage_name(s), stdout);
-		fputc('\t', stdout);
-		fprintf(stdout, "%u\n", wl.w[j] + 1U);
+		routput_str(out, rotz_massage_name(s[j]));
+		routput_chr(out, '\t');
+		routput_u(out, wl.w[j] + 1U);
+		routput_chr(out, '\n');
 	}
 	return;
 }
 
-static void
-show_tagsym(rotz_t ctx, rtz_vtx_t tsid)
-{
-/* show all syms associated with tag vertex TSID, or
- * all tags assoc'd with sym vertex TSID. */
-	rtz_vtxlst_t vl;
-
-	/* get all them edges and iterate */
-	vl = rotz_get_edges(ctx, tsid);
-
-	/* print it */
-	prnt_vtxlst(ctx, vl);
-
-	/* get ready for the next round */
-	rotz_free_vtxlst(vl);
-	return;
-}
-
-static void
-show_tagsym_pair(rotz_t ctx, rtz_vtx_t tsid, const char *pair)
-{
-/* show all syms associated with tag vertex TSID, or
- * all tags assoc'd with sym vertex TSID. */
-	rtz_vtxlst_t vl;
-
-	/* get all them edges and iterate */
-	vl = rotz_get_edges(ctx, tsid);
-
-	/* print it */
-	prnt_vtxlst_pair(ctx, vl, pair);
-
-	/* get ready for the next round */
-	rotz_free_vtxlst(vl);
-	return;
-}
-
-
 #if defined STANDALONE
-static union {
-	rtz_vtxlst_t vl;
-	rtz_wtxlst_t wl;
-} r = {0U};
-
-static void
-handle_one(rotz_t ctx, const struct yuck_cmd_show_s *argi, const char *input)
-{
-	static size_t i;
-	const char *tagsym;
-	rtz_vtx_t tsid;
-
-	if ((tagsym = rotz_tag(input),
-	     tsid = rotz_get_vertex(ctx, tagsym))) {
-		;
-	} else if ((tagsym = rotz_sym(input),
-		    tsid = rotz_get_vertex(ctx, tagsym))) {
-		;
-	} else {
-		/* nothing to worry about */
-		return;
-	}
-
-	if (argi->union_flag) {
-		r.vl = rotz_union(ctx, r.vl, tsid);
-	} else if (argi->munion_flag) {
-		r.wl = rotz_munion(ctx, r.wl, tsid);
-	} else if (argi->intersection_flag) {
-		if (i++ > 0) {
-			r.vl = rotz_intersection(ctx, r.vl, tsid);
-		} else {
-			r.vl = rotz_get_edges(ctx, tsid);
-		}
-	} else if (argi->pairs_flag) {
-		show_tagsym_pair(ctx, tsid, input);
-	} else {
-		show_tagsym(ctx, tsid);
-	}
-	return;
-}
+static struct rtz_batch_s in[1U];
+static rtz_vtx_t tsids[RTZ_BATCH_Z];
 
 int
 rotz_cmd_show(const struct yuck_cmd_show_s argi[static 1U])
 {
+	struct rshow_s sh = {
+		.prnt = prnt_vtxlst,
+		.in = in,
+		.tsids = tsids,
+	};
 	rotz_t ctx;
+	rtz_arena_t ar;
+	int rc = 0;
 
 	if (UNLIKELY((ctx = make_rotz(db)) == NULL)) {
 		fputs("Error opening rotz datastore\n", stderr);
 		return 1;
+	} else if (UNLIKELY((ar = rotz_make_arena()) == NULL)) {
+		fputs("Error: cannot allocate query results\n", stderr);
+		free_rotz(ctx);
+		return 1;
+	}
+	idsp = argi->ids_flag;
+	if (UNLIKELY((out = make_routput(STDOUT_FILENO)) == NULL)) {
+		fputs("Error: cannot allocate output buffer\n", stderr);
+		rotz_free_arena(ar);
+		free_rotz(ctx);
+		return 1;
+	}
+
+	sh.ctx = ctx;
+	sh.clo = ctx;
+	sh.ar = ar;
+	if (argi->union_flag) {
+		sh.mode = RSHOW_UNION;
+	} else if (argi->munion_flag) {
+		sh.mode = RSHOW_MUNION;
+	} else if (argi->intersection_flag) {
+		sh.mode = RSHOW_ISECT;
+	} else if (argi->pairs_flag) {
+		sh.mode = RSHOW_PAIRS;
+	} else {
+		sh.mode = RSHOW_EDGES;
 	}
 
 	for (size_t i = 0U; i < argi->nargs; i++) {
 		const char *const input = argi->args[i];
 
-		handle_one(ctx, argi, input);
+		rshow_push(&sh, input, strlen(input));
 	}
 	if (argi->nargs == 0U && !isatty(STDIN_FILENO)) {
 		/* read the guys from STDIN */
-		char *line = NULL;
-		size_t llen = 0U;
-		ssize_t nrd;
-
-		while ((nrd = getline(&line, &llen, stdin)) > 0) {
-			line[nrd - 1] = '\0';
-			handle_one(ctx, argi, line);
+		rinput_t rd = make_rinput(STDIN_FILENO);
+		char *line;
+		size_t llen;
+
+		if (UNLIKELY(rd == NULL)) {
+			fputs("Error: cannot read from stdin\n", stderr);
+			rc = 1;
+			goto fina;
 		}
-		free(line);
+		while ((line = rinput_line(rd, &llen)) != NULL) {
+			rshow_push(&sh, line, llen);
+		}
+		if (UNLIKELY(rinput_err(rd))) {
+			fputs("Error: cannot read from stdin\n", stderr);
+			rc = 1;
+		}
+		free_rinput(rd);
 	} else if (argi->nargs == 0U && argi->syms_flag) {
 		/* show all syms mode */
 		rotz_vtx_iter(ctx, iter_syms_cb, NULL);
@@ -227,18 +228,27 @@ rotz_cmd_show(const struct yuck_cmd_show_s argi[static 1U])
 		rotz_vtx_iter(ctx, iter_cb, NULL);
 		goto fina;
 	}
-	if (argi->union_flag || argi->intersection_flag) {
-		prnt_vtxlst(ctx, r.vl);
-	} else if (argi->munion_flag) {
+	/* process the remainder */
+	if (UNLIKELY(rshow_flush(&sh) < 0)) {
+		fputs("Error: cannot allocate query results\n", stderr);
+		rc = 1;
+	} else if (sh.mode == RSHOW_UNION || sh.mode == RSHOW_ISECT) {
+		prnt_vtxlst(ctx, (rtz_const_vtxlst_t){sh.r.vl.z, sh.r.vl.d},
+			    NULL, 0U);
+	} else if (sh.mode == RSHOW_MUNION) {
 		/* quick service, sort r.wl, could be an option */
-		sort_wtxlst(r.wl);
-		prnt_wtxlst(ctx, r.wl);
+		sort_wtxlst(sh.r.wl);
+		prnt_wtxlst(ctx, sh.r.wl);
 	}
 
 fina:
 	/* big rcource freeing */
+	free_routput(out);
+	rotz_free_arena(ar);
+	rotz_batch_free(in);
+	rotz_names_free(nm);
 	free_rotz(ctx);
-	return 0;
+	return rc;
 }
 #endif	/* STANDALONE */
 
@@ -41,7 +41,10 @@
 #include <stdint.h>
 #include <stdarg.h>
 #include <string.h>
+#include <limits.h>
+#include <stdbool.h>
 #include <fcntl.h>
+#include <pthread.h>
 #include <tcbdb.h>
 
 #include "rotz.h"
@@ -49,8 +52,28 @@
 
 struct rotz_s {
 	TCBDB *db;
+	struct rtz_log_s *log;
+	struct rtz_tmb_s *tmb;
+	/* set while a caller's transaction is open */
+	bool tran;
+	/* ids reserved but not yet handed out, [idlo, idhi) */
+	rtz_vtx_t idlo;
+	rtz_vtx_t idhi;
+	/* copy of the last get_meta() value, z is the allocated size */
+	size_t metaz;
+	char *meta;
+	/* set for handles made by rotz_clone(), DB isn't theirs */
+	bool clonep;
 };
 
+/* tokyocabinet hands out pointers into its caches, so readers that went
+ * through rotz_begin_read() and transactions of all handles take turns */
+static pthread_mutex_t rdmtx = PTHREAD_MUTEX_INITIALIZER;
+/* tokyocabinet's leaf cache can't take concurrent readers either, edge
+ * slices are iterated by several threads at once, so cursors are only
+ * moved under this lock */
+static pthread_mutex_t curmtx = PTHREAD_MUTEX_INITIALIZER;
+
 
 /* low level graph lib */
 rotz_t
@@ -77,11 +100,28 @@ make_rotz(const char *db, ...)
 	} else if (UNLIKELY(!tcbdbopen(res.db, db, omode))) {
 		goto out_free_db;
 	}
+	res.log = NULL;
+	res.tmb = NULL;
+	res.tran = false;
+	res.clonep = false;
+	res.idlo = res.idhi = 0U;
+	res.metaz = 0U;
+	res.meta = NULL;
 
 	/* clone the result */
 	{
 		struct rotz_s *resp = malloc(sizeof(*resp));
 		*resp = res;
+		/* learn the key format, ... */
+		if (UNLIKELY(open_fmt(resp, omode & BDBOWRITER) < 0)) {
+			free_rotz(resp);
+			return NULL;
+		}
+		/* ... writers append to the change log, if any */
+		if ((omode & BDBOWRITER) && UNLIKELY(open_log(resp) < 0)) {
+			free_rotz(resp);
+			return NULL;
+		}
 		return resp;
 	}
 
@@ -91,27 +131,149 @@ out:
 	return NULL;
 }
 
+rotz_t
+rotz_clone(rotz_t ctx)
+{
+	struct rotz_s *res;
+
+	if (UNLIKELY((res = calloc(1U, sizeof(*res))) == NULL)) {
+		return NULL;
+	}
+	res->db = ctx->db;
+	res->clonep = true;
+	return res;
+}
+
 void
 free_rotz(rotz_t ctx)
 {
-	tcbdbclose(ctx->db);
-	tcbdbdel(ctx->db);
+	unrsv_ids(ctx);
+	close_log(ctx);
+	free_tombs(ctx);
+	if (ctx->meta != NULL) {
+		free(ctx->meta);
+	}
+	if (!ctx->clonep) {
+		tcbdbclose(ctx->db);
+		tcbdbdel(ctx->db);
+	}
 	free(ctx);
 	return;
 }
 
 
+static int
+put_mark(rotz_t ctx)
+{
+/* commit the change log position along with the records' writes */
+	const_buf_t m = log_mark(ctx);
+
+	if (m.z == 0U) {
+		/* nothing's logged */
+		return 0;
+	}
+	return tcbdbput(ctx->db, seqkey, sizeof(seqkey), m.d, m.z) - 1;
+}
+
+static int
+autocommit(rotz_t ctx)
+{
+/* outside of transactions writes are final, and so are their records,
+ * the mark can only follow the write so a crash in between goes
+ * unnoticed, use transactions to close that window */
+	if (ctx->tran) {
+		return 0;
+	} else if (UNLIKELY(log_lock(ctx) < 0) ||
+		   UNLIKELY(put_mark(ctx) < 0)) {
+		log_drop(ctx);
+		return -1;
+	}
+	return log_write(ctx, 0);
+}
+
 static rtz_vtx_t
-next_id(rotz_t cp)
+next_ids(rotz_t cp, rtz_vtx_t n)
 {
+/* reserve N ids in one go and return the first one */
 	static const char nid[] = "\x1d";
 
-	int res;
+#if defined WITH_WIDE_IDS
+	/* tcbdbaddint() is for ints only */
+	const rtz_vtx_t *rp;
+	rtz_vtx_t res = 0U;
+	int rz[1];
+
+	if ((rp = tcbdbget3(cp->db, nid, sizeof(nid), rz)) != NULL &&
+	    LIKELY(*rz == sizeof(*rp))) {
+		res = *rp;
+	}
+	res += n;
+	if (UNLIKELY(!tcbdbput(cp->db, nid, sizeof(nid), &res, sizeof(res)))) {
+		return 0U;
+	}
+#else  /* !WITH_WIDE_IDS */
+	/* tcbdbaddint() is for ints only, don't let it go negative */
+	const int *rp;
+	int res = 0;
+	int rz[1];
+
+	if ((rp = tcbdbget3(cp->db, nid, sizeof(nid), rz)) != NULL &&
+	    LIKELY(*rz == sizeof(*rp))) {
+		res = *rp;
+	}
+	if (UNLIKELY(res < 0 || n > (rtz_vtx_t)(INT_MAX - res))) {
+		return 0U;
+	}
+	res = tcbdbaddint(cp->db, nid, sizeof(nid), n);
+	if (UNLIKELY(res <= 0)) {
+		return 0U;
+	}
+#endif	/* WITH_WIDE_IDS */
+	log_rec(cp, RTZ_LOG_NEXT_ID, NULL, 0U, &n, sizeof(n));
+	if (UNLIKELY(autocommit(cp) < 0)) {
+		return 0U;
+	}
+	return (rtz_vtx_t)res - n + 1U;
+}
+
+static int
+ret_ids(rotz_t cp, rtz_vtx_t from, rtz_vtx_t till)
+{
+/* give back the ids [FROM, TILL) unless others reserved ids after them */
+	static const char nid[] = "\x1d";
+	const rtz_vtx_t *rp;
+	const rtz_vtx_t x = from - 1U;
+	int rz[1];
+
+	if ((rp = tcbdbget3(cp->db, nid, sizeof(nid), rz)) == NULL ||
+	    UNLIKELY(*rz != sizeof(*rp)) ||
+	    *rp != till - 1U) {
+		/* abandon them then */
+		return 0;
+	} else if (UNLIKELY(!tcbdbput(cp->db, nid, sizeof(nid), &x, sizeof(x)))) {
+		return -1;
+	}
+	log_rec(cp, RTZ_LOG_RET_IDS,
+		NULL, 0U, (rtz_vtx_t[]){from, till}, 2U * sizeof(from));
+	if (UNLIKELY(autocommit(cp) < 0)) {
+		return -1;
+	}
+	return 1;
+}
+
+static rtz_vtx_t
+get_maxid(rotz_t cp)
+{
+	static const char nid[] = "\x1d";
+	const rtz_vtx_t *rp;
+	int rz[1];
 
-	if (UNLIKELY((res = tcbdbaddint(cp->db, nid, sizeof(nid), 1)) <= 0)) {
+	if (UNLIKELY((rp = tcbdbget3(cp->db, nid, sizeof(nid), rz)) == NULL)) {
+		return 0U;
+	} else if (UNLIKELY(*rz != sizeof(*rp))) {
 		return 0U;
 	}
-	return (rtz_vtx_t)res;
+	return *rp;
 }
 
 static rtz_vtx_t
@@ -119,7 +281,7 @@ get_vertex(rotz_t cp, const char *v, size_t z)
 {
 	rtz_vtx_t res;
 
-	const int *rp;
+	const rtz_vtx_t *rp;
 	int rz[1];
 
 	if (UNLIKELY((rp = tcbdbget3(cp->db, v, z, rz)) == NULL)) {
@@ -127,16 +289,61 @@ get_vertex(rotz_t cp, const char *v, size_t z)
 	} else if (UNLIKELY(*rz != sizeof(*rp))) {
 		return 0U;
 	}
-	res = (rtz_vtx_t)*rp;
+	res = *rp;
 	return res;
 }
 
+static size_t
+get_vertices(rotz_t cp, rtz_vtx_t *restrict r, const const_buf_t *v, size_t n)
+{
+/* V is assumed to be sorted */
+	BDBCUR *c = tcbdbcurnew(cp->db);
+	size_t i = 0U;
+	size_t nr = 0U;
+
+	for (; i < n; i++) {
+		const void *kp;
+		const rtz_vtx_t *rp;
+		int z[1];
+
+		r[i] = 0U;
+		if (!tcbdbcurjump(c, v[i].d, v[i].z)) {
+			/* we're past the last key */
+			break;
+		} else if (UNLIKELY((kp = tcbdbcurkey3(c, z)) == NULL) ||
+			   (size_t)*z != v[i].z || memcmp(kp, v[i].d, v[i].z)) {
+			/* not found */
+			continue;
+		} else if (UNLIKELY((rp = tcbdbcurval3(c, z)) == NULL) ||
+			   UNLIKELY(*z != sizeof(*rp))) {
+			continue;
+		}
+		r[i] = *rp;
+		nr++;
+	}
+	tcbdbcurdel(c);
+	/* everything we haven't seen is a miss */
+	for (; i < n; i++) {
+		r[i] = 0U;
+	}
+	return nr;
+}
+
 static int
 put_vertex(rotz_t cp, const char *a, size_t az, rtz_vtx_t v)
 {
 	int res = 0;
 
-	res = tcbdbaddint(cp->db, a, az, (int)v) - 1;
+#if defined WITH_WIDE_IDS
+	res = tcbdbput(cp->db, a, az, &v, sizeof(v)) - 1;
+#else  /* !WITH_WIDE_IDS */
+	/* tcbdbaddint() returns the new value, INT_MIN on failure */
+	res = -(tcbdbaddint(cp->db, a, az, (int)v) == INT_MIN);
+#endif	/* WITH_WIDE_IDS */
+	if (res == 0) {
+		log_rec(cp, RTZ_LOG_PUT_VERTEX, a, az, &v, sizeof(v));
+		res = autocommit(cp);
+	}
 	return res;
 }
 
@@ -149,6 +356,10 @@ rnm_vertex(rotz_t cp, rtz_vtxkey_t vkey, const char *v, size_t z)
 		tcbdbout(cp->db, v, z);
 		res = -1;
 	}
+	if (res == 0) {
+		log_rec(cp, RTZ_LOG_RNM_VERTEX, vkey, RTZ_VTXKEY_Z, v, z + 1);
+		res = autocommit(cp);
+	}
 	return res;
 }
 
@@ -158,6 +369,10 @@ unput_vertex(rotz_t cp, const char *v, size_t z)
 	int res = 0;
 
 	res = tcbdbout(cp->db, v, z) - 1;
+	if (res == 0) {
+		log_rec(cp, RTZ_LOG_UNPUT_VERTEX, v, z, NULL, 0U);
+		res = autocommit(cp);
+	}
 	return res;
 }
 
@@ -167,6 +382,10 @@ unrnm_vertex(rotz_t cp, rtz_vtxkey_t vkey)
 	int res = 0;
 
 	res = tcbdbout(cp->db, vkey, RTZ_VTXKEY_Z) - 1;
+	if (res == 0) {
+		log_rec(cp, RTZ_LOG_UNRNM_VERTEX, vkey, RTZ_VTXKEY_Z, NULL, 0U);
+		res = autocommit(cp);
+	}
 	return res;
 }
 
@@ -176,6 +395,10 @@ add_alias(rotz_t cp, rtz_vtxkey_t vkey, const char *a, size_t az)
 	int res = 0;
 
 	res = tcbdbputcat(cp->db, vkey, RTZ_VTXKEY_Z, a, az + 1) - 1;
+	if (res == 0) {
+		log_rec(cp, RTZ_LOG_ADD_ALIAS, vkey, RTZ_VTXKEY_Z, a, az + 1);
+		res = autocommit(cp);
+	}
 	return res;
 }
 
@@ -186,9 +409,14 @@ add_akalst(rotz_t ctx, rtz_vtxkey_t ak, const_buf_t al)
 	size_t z;
 
 	if (UNLIKELY((z = al.z * sizeof(*al.d)) == 0U)) {
-		return tcbdbout(ctx->db, ak, RTZ_VTXKEY_Z) - 1;
+		res = tcbdbout(ctx->db, ak, RTZ_VTXKEY_Z) - 1;
+	} else {
+		res = tcbdbput(ctx->db, ak, RTZ_VTXKEY_Z, al.d, z) - 1;
+	}
+	if (res == 0) {
+		log_rec(ctx, RTZ_LOG_ADD_AKALST, ak, RTZ_VTXKEY_Z, al.d, al.z);
+		res = autocommit(ctx);
 	}
-	res = tcbdbput(ctx->db, ak, RTZ_VTXKEY_Z, al.d, z) - 1;
 	return res;
 }
 
@@ -207,6 +435,40 @@ get_aliases(rotz_t cp, rtz_vtxkey_t svtx)
 	return res;
 }
 
+static size_t
+get_names(
+	rotz_t cp, const rtz_vtx_t *v, size_t n,
+	void(*cb)(size_t, const char*, void*), void *clo)
+{
+/* V is assumed to be sorted in key order */
+	BDBCUR *c = tcbdbcurnew(cp->db);
+	size_t nr = 0U;
+
+	for (size_t i = 0U; i < n; i++) {
+		rtz_vtxkey_t vkey = rtz_vtxkey(v[i]);
+		const void *kp;
+		const void *vp;
+		int z[1];
+
+		if (!tcbdbcurjump(c, vkey, RTZ_VTXKEY_Z)) {
+			/* past the last key, nothing to find */
+			continue;
+		} else if (UNLIKELY((kp = tcbdbcurkey3(c, z)) == NULL) ||
+			   (size_t)*z != RTZ_VTXKEY_Z ||
+			   memcmp(kp, vkey, RTZ_VTXKEY_Z)) {
+			/* not found */
+			continue;
+		} else if (UNLIKELY((vp = tcbdbcurval3(c, z)) == NULL)) {
+			continue;
+		}
+		/* we're interested in the first name only */
+		cb(i, vp, clo);
+		nr++;
+	}
+	tcbdbcurdel(c);
+	return nr;
+}
+
 static rtz_buf_t
 get_aliases_r(rotz_t cp, rtz_vtxkey_t svtx)
 {
@@ -243,6 +505,10 @@ add_edge(rotz_t ctx, rtz_edgkey_t src, rtz_vtx_t to)
 	int res = 0;
 
 	res = tcbdbputcat(ctx->db, src, RTZ_EDGKEY_Z, &to, sizeof(to)) - 1;
+	if (res == 0) {
+		log_rec(ctx, RTZ_LOG_ADD_EDGE, src, RTZ_EDGKEY_Z, &to, sizeof(to));
+		res = autocommit(ctx);
+	}
 	return res;
 }
 
@@ -253,9 +519,15 @@ add_vtxlst(rotz_t ctx, rtz_edgkey_t src, const_vtxlst_t el)
 	size_t z;
 
 	if (UNLIKELY((z = el.z * sizeof(*el.d)) == 0U)) {
-		return tcbdbout(ctx->db, src, RTZ_EDGKEY_Z) - 1;
+		res = tcbdbout(ctx->db, src, RTZ_EDGKEY_Z) - 1;
+	} else {
+		res = tcbdbput(ctx->db, src, RTZ_EDGKEY_Z, el.d, z) - 1;
+	}
+	if (res == 0) {
+		log_rec(ctx, RTZ_LOG_ADD_VTXLST,
+			src, RTZ_EDGKEY_Z, el.d, el.z * sizeof(*el.d));
+		res = autocommit(ctx);
 	}
-	res = tcbdbput(ctx->db, src, RTZ_EDGKEY_Z, el.d, z) - 1;
 	return res;
 }
 
@@ -265,9 +537,202 @@ rem_edges(rotz_t ctx, rtz_edgkey_t src)
 	int res = 0;
 
 	res = tcbdbout(ctx->db, src, RTZ_EDGKEY_Z) - 1;
+	if (res == 0) {
+		log_rec(ctx, RTZ_LOG_REM_EDGES, src, RTZ_EDGKEY_Z, NULL, 0U);
+		res = autocommit(ctx);
+	}
 	return res;
 }
 
+
+/* parent accessors */
+static const_vtxlst_t
+get_children(rotz_t ctx, rtz_parkey_t par)
+{
+	const void *sp;
+	int z[1];
+
+	if (UNLIKELY((sp = tcbdbget3(ctx->db, par.d, par.z, z)) == NULL)) {
+		return (const_vtxlst_t){0U};
+	}
+	return (const_vtxlst_t){.z = (size_t)*z / sizeof(rtz_vtx_t), .d = sp};
+}
+
+static int
+add_child(rotz_t ctx, rtz_parkey_t par, rtz_vtx_t chld)
+{
+	int res;
+
+	res = tcbdbputcat(ctx->db, par.d, par.z, &chld, sizeof(chld)) - 1;
+	if (res == 0) {
+		log_rec(ctx, RTZ_LOG_ADD_CHILD, par.d, par.z, &chld, sizeof(chld));
+		res = autocommit(ctx);
+	}
+	return res;
+}
+
+static int
+add_chldlst(rotz_t ctx, rtz_parkey_t par, const_vtxlst_t el)
+{
+	int res;
+	size_t z;
+
+	if (UNLIKELY((z = el.z * sizeof(*el.d)) == 0U)) {
+		res = tcbdbout(ctx->db, par.d, par.z) - 1;
+	} else {
+		res = tcbdbput(ctx->db, par.d, par.z, el.d, z) - 1;
+	}
+	if (res == 0) {
+		log_rec(ctx, RTZ_LOG_ADD_CHLDLST,
+			par.d, par.z, el.d, el.z * sizeof(*el.d));
+		res = autocommit(ctx);
+	}
+	return res;
+}
+
+
+/* bulk loading */
+static int
+put_sorted(rotz_t ctx, const const_buf_t *k, const const_buf_t *v, size_t n)
+{
+	/* keys come in order and keep filling the same leaf,
+	 * the transaction saves us from writing it out every time */
+	if (ctx->tran) {
+		/* part of a bigger transaction already */
+		;
+	} else if (UNLIKELY(!tcbdbtranbegin(ctx->db))) {
+		return -1;
+	}
+	for (size_t i = 0U; i < n; i++) {
+		if (UNLIKELY(!tcbdbput(ctx->db, k[i].d, k[i].z, v[i].d, v[i].z))) {
+			if (!ctx->tran) {
+				tcbdbtranabort(ctx->db);
+				log_drop(ctx);
+			}
+			return -1;
+		}
+		log_rec(ctx, RTZ_LOG_PUT_SORTED, k[i].d, k[i].z, v[i].d, v[i].z);
+	}
+	if (ctx->tran) {
+		return 0;
+	} else if (UNLIKELY(log_lock(ctx) < 0) ||
+		   UNLIKELY(put_mark(ctx) < 0)) {
+		tcbdbtranabort(ctx->db);
+		log_drop(ctx);
+		return -1;
+	} else if (UNLIKELY(!tcbdbtrancommit(ctx->db))) {
+		log_drop(ctx);
+		return -1;
+	}
+	return log_write(ctx, 0);
+}
+
+
+/* transactions and meta data */
+static int
+tx_begin(rotz_t ctx)
+{
+	pthread_mutex_lock(&rdmtx);
+	if (UNLIKELY(!tcbdbtranbegin(ctx->db))) {
+		pthread_mutex_unlock(&rdmtx);
+		return -1;
+	}
+	ctx->tran = true;
+	return 0;
+}
+
+static int
+tx_commit(rotz_t ctx)
+{
+	int res;
+
+	ctx->tran = false;
+	if (UNLIKELY(log_lock(ctx) < 0) ||
+	    UNLIKELY(put_mark(ctx) < 0)) {
+		/* we can't log it, so it mustn't happen */
+		tcbdbtranabort(ctx->db);
+		log_drop(ctx);
+		ctx->idlo = ctx->idhi = 0U;
+		res = -1;
+	} else if (UNLIKELY(!tcbdbtrancommit(ctx->db))) {
+		log_drop(ctx);
+		res = -1;
+	} else {
+		/* followers get the transaction's records, durably */
+		res = log_write(ctx, 1);
+	}
+	pthread_mutex_unlock(&rdmtx);
+	return res;
+}
+
+static void
+tx_abort(rotz_t ctx)
+{
+	ctx->tran = false;
+	tcbdbtranabort(ctx->db);
+	log_drop(ctx);
+	/* our reservation might have been rolled back */
+	ctx->idlo = ctx->idhi = 0U;
+	pthread_mutex_unlock(&rdmtx);
+	return;
+}
+
+static int
+tx_p(rotz_t ctx)
+{
+	return ctx->tran;
+}
+
+static int
+rd_begin(rotz_t UNUSED(ctx))
+{
+	pthread_mutex_lock(&rdmtx);
+	return 0;
+}
+
+static void
+rd_end(rotz_t UNUSED(ctx))
+{
+	pthread_mutex_unlock(&rdmtx);
+	return;
+}
+
+static const_buf_t
+get_meta(rotz_t ctx, const char *k, size_t kz)
+{
+/* the value is copied out of tokyocabinet's cache, it stays valid
+ * until the next get_meta() on CTX */
+	const void *sp;
+	int z[1];
+
+	if ((sp = tcbdbget3(ctx->db, k, kz, z)) == NULL || *z <= 0) {
+		return (const_buf_t){0U};
+	} else if ((size_t)*z > ctx->metaz) {
+		char *tmp = realloc(ctx->meta, *z);
+
+		if (UNLIKELY(tmp == NULL)) {
+			return (const_buf_t){0U};
+		}
+		ctx->meta = tmp;
+		ctx->metaz = *z;
+	}
+	memcpy(ctx->meta, sp, *z);
+	return (const_buf_t){.z = (size_t)*z, .d = ctx->meta};
+}
+
+static int
+put_meta(rotz_t ctx, const char *k, size_t kz, const_buf_t v)
+{
+	if (v.z > 0U) {
+		return tcbdbput(ctx->db, k, kz, v.d, v.z) - 1;
+	} else if (!tcbdbout(ctx->db, k, kz) &&
+		   UNLIKELY(tcbdbecode(ctx->db) != TCENOREC)) {
+		return -1;
+	}
+	/* it's fine if there was nothing to delete */
+	return 0;
+}
+
 
 /* iterators
  * we can't keep the promise here to separate keys and tokyocabinet guts */
@@ -301,24 +766,37 @@ rotz_vtx_iter(rotz_t ctx, int(*cb)(rtz_vtx_t, const char*, void*), void *clo)
 	return;
 }
 
-void
-rotz_edg_iter(rotz_t ctx, int(*cb)(rtz_vtx_t, const_vtxlst_t, void*), void *clo)
+static void
+edg_iter(
+	rotz_t ctx, rtz_edgkey_t from, rtz_edgkey_t till,
+	int(*cb)(rtz_vtx_t, const_vtxlst_t, void*), void *clo)
 {
+	/* the cursor is moved under CURMTX, the callback runs without */
 	rtz_vtxlst_t vl = {.z = 0U};
-	BDBCUR *c = tcbdbcurnew(ctx->db);
-
-	tcbdbcurjump(c, RTZ_EDGPRE, sizeof(RTZ_EDGPRE));
-	do {
+	BDBCUR *c;
+	bool more;
+
+	pthread_mutex_lock(&curmtx);
+	c = tcbdbcurnew(ctx->db);
+	if (from != NULL) {
+		more = tcbdbcurjump(c, from, RTZ_EDGKEY_Z);
+	} else {
+		more = tcbdbcurjump(c, RTZ_EDGPRE, sizeof(RTZ_EDGPRE));
+	}
+	for (; more; more = tcbdbcurnext(c)) {
 		int z[1];
 		const void *kp;
 		rtz_vtx_t vid;
 		const void *vp;
 		const_vtxlst_t cvl;
+		int rc;
 
 		if (UNLIKELY((kp = tcbdbcurkey3(c, z)) == NULL) ||
 		    UNLIKELY(*z != sizeof(RTZ_EDGPRE) + sizeof(vid)) ||
 		    UNLIKELY(!(vid = rtz_edg(kp)))) {
 			break;
+		} else if (till != NULL && memcmp(kp, till, RTZ_EDGKEY_Z) >= 0) {
+			break;
 		} else if (UNLIKELY((vp = tcbdbcurval3(c, z)) == NULL)) {
 			continue;
 		}
@@ -331,13 +809,16 @@ rotz_edg_iter(rotz_t ctx, int(*cb)(rtz_vtx_t, const_vtxlst_t, void*), void *clo)
 		memcpy(vl.d, vp, cvl.z * sizeof(*cvl.d));
 		cvl.d = vl.d;
 		/* otherwise just call the callback */
-		if (UNLIKELY(cb(vid, cvl, clo) < 0)) {
+		pthread_mutex_unlock(&curmtx);
+		rc = cb(vid, cvl, clo);
+		pthread_mutex_lock(&curmtx);
+		if (UNLIKELY(rc < 0)) {
 			break;
 		}
-
-	} while (tcbdbcurnext(c));
+	}
 
 	tcbdbcurdel(c);
+	pthread_mutex_unlock(&curmtx);
 	rotz_free_vtxlst(vl);
 	return;
 }
@@ -347,8 +828,12 @@ rotz_iter(
 	rotz_t ctx, rtz_const_buf_t prfx_match,
 	int(*cb)(rtz_const_buf_t key, rtz_const_buf_t val, void*), void *clo)
 {
-	BDBCUR *c = tcbdbcurnew(ctx->db);
+/* the callback sees pointers into the cache, so it runs under CURMTX
+ * too and mustn't iterate itself */
+	BDBCUR *c;
 
+	pthread_mutex_lock(&curmtx);
+	c = tcbdbcurnew(ctx->db);
 #define B	(const_buf_t)
 	tcbdbcurjump(c, prfx_match.d, prfx_match.z);
 	do {
@@ -357,6 +842,7 @@ rotz_iter(
 		const void *vp;
 
 		if (UNLIKELY((kp = tcbdbcurkey3(c, z + 0)) == NULL) ||
+		    UNLIKELY((size_t)z[0] < prfx_match.z) ||
 		    UNLIKELY(memcmp(kp, prfx_match.d, prfx_match.z))) {
 			break;
 		} else if (UNLIKELY((vp = tcbdbcurval3(c, z + 1)) == NULL)) {
@@ -371,6 +857,7 @@ rotz_iter(
 #undef B
 
 	tcbdbcurdel(c);
+	pthread_mutex_unlock(&curmtx);
 	return;
 }
 
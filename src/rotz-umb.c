@@ -68,6 +68,24 @@ main(int argc, char *argv[])
 	if (argi->database_arg) {
 		db = argi->database_arg;
 	}
+	if (argi->changelog_arg) {
+		/* this is sticky, it's kept in the database */
+		const char *fn = *argi->changelog_arg ? argi->changelog_arg : NULL;
+		rotz_t ctx;
+
+		if (UNLIKELY((ctx = make_rotz(db, O_CREAT | O_RDWR)) == NULL)) {
+			fputs("Error opening rotz datastore\n", stderr);
+			rc = 1;
+			goto out;
+		} else if (UNLIKELY(rotz_set_changelog(ctx, fn) < 0)) {
+			fputs("Error: cannot set up change log\n", stderr);
+			rc = 1;
+		}
+		free_rotz(ctx);
+		if (rc || argi->cmd == ROTZ_CMD_NONE) {
+			goto out;
+		}
+	}
 
 	switch (argi->cmd) {
 	default:
@@ -84,30 +102,54 @@ See rotz --help for a list of commands.\n", stderr);
 	case ROTZ_CMD_ALIAS:
 		rc = rotz_cmd_alias((const void*)argi);
 		break;
+	case ROTZ_CMD_BATCH:
+		rc = rotz_cmd_batch((const void*)argi);
+		break;
 	case ROTZ_CMD_CLOUD:
 		rc = rotz_cmd_cloud((const void*)argi);
 		break;
 	case ROTZ_CMD_COMBINE:
 		rc = rotz_cmd_combine((const void*)argi);
 		break;
+	case ROTZ_CMD_COMPACT:
+		rc = rotz_cmd_compact((const void*)argi);
+		break;
+	case ROTZ_CMD_COMPONENTS:
+		rc = rotz_cmd_components((const void*)argi);
+		break;
 	case ROTZ_CMD_DEL:
 		rc = rotz_cmd_del((const void*)argi);
 		break;
 	case ROTZ_CMD_EXPORT:
 		rc = rotz_cmd_export((const void*)argi);
 		break;
+	case ROTZ_CMD_FOLLOW:
+		rc = rotz_cmd_follow((const void*)argi);
+		break;
 	case ROTZ_CMD_FSCK:
 		rc = rotz_cmd_fsck((const void*)argi);
 		break;
+	case ROTZ_CMD_GC:
+		rc = rotz_cmd_gc((const void*)argi);
+		break;
 	case ROTZ_CMD_GREP:
 		rc = rotz_cmd_grep((const void*)argi);
 		break;
+	case ROTZ_CMD_IMPORT:
+		rc = rotz_cmd_import((const void*)argi);
+		break;
+	case ROTZ_CMD_REACH:
+		rc = rotz_cmd_reach((const void*)argi);
+		break;
 	case ROTZ_CMD_RENAME:
 		rc = rotz_cmd_rename((const void*)argi);
 		break;
 	case ROTZ_CMD_SEARCH:
 		rc = rotz_cmd_search((const void*)argi);
 		break;
+	case ROTZ_CMD_SERVE:
+		rc = rotz_cmd_serve((const void*)argi);
+		break;
 	case ROTZ_CMD_SHOW:
 		rc = rotz_cmd_show((const void*)argi);
 		break;
@@ -45,14 +45,22 @@ extern const char *db;
 
 extern int rotz_cmd_add(const struct yuck_cmd_add_s*);
 extern int rotz_cmd_alias(const struct yuck_cmd_alias_s*);
+extern int rotz_cmd_batch(const struct yuck_cmd_batch_s*);
 extern int rotz_cmd_cloud(const struct yuck_cmd_cloud_s*);
 extern int rotz_cmd_combine(const struct yuck_cmd_combine_s*);
+extern int rotz_cmd_compact(const struct yuck_cmd_compact_s*);
+extern int rotz_cmd_components(const struct yuck_cmd_components_s*);
 extern int rotz_cmd_del(const struct yuck_cmd_del_s*);
 extern int rotz_cmd_export(const struct yuck_cmd_export_s*);
+extern int rotz_cmd_follow(const struct yuck_cmd_follow_s*);
 extern int rotz_cmd_fsck(const struct yuck_cmd_fsck_s*);
+extern int rotz_cmd_gc(const struct yuck_cmd_gc_s*);
 extern int rotz_cmd_grep(const struct yuck_cmd_grep_s*);
+extern int rotz_cmd_import(const struct yuck_cmd_import_s*);
+extern int rotz_cmd_reach(const struct yuck_cmd_reach_s*);
 extern int rotz_cmd_rename(const struct yuck_cmd_rename_s*);
 extern int rotz_cmd_search(const struct yuck_cmd_search_s*);
+extern int rotz_cmd_serve(const struct yuck_cmd_serve_s*);
 extern int rotz_cmd_show(const struct yuck_cmd_show_s*);
 
 #endif	/* INCLUDED_rotz_umb_h_ */
@@ -41,9 +41,16 @@
 #include <stdint.h>
 #include <stdarg.h>
 #include <string.h>
+#include <unistd.h>
 #include <fcntl.h>
+#include <errno.h>
+#include <endian.h>
+#include <limits.h>
+#include <stddef.h>
+#include <sys/file.h>
 
 #include "rotz.h"
+#include "rkern.h"
 #include "nifty.h"
 
 #define const_buf_t	rtz_const_buf_t
@@ -58,13 +65,26 @@ typedef const unsigned char *rtz_edgkey_t;
 #define RTZ_EDGPRE	"edg"
 #define RTZ_EDGKEY_Z	(sizeof(RTZ_EDGPRE) + sizeof(rtz_vtx_t))
 
+typedef const_buf_t rtz_parkey_t;
+#define RTZ_PARPRE	"par"
+/* tombstoned vertices, tmb\0 followed by the big-endian handle holds
+ * the vertex' tombstone, tmb itself the generation counter */
+#define RTZ_TMBKEY	"tmb"
+#define RTZ_TMBKEY_Z	(sizeof(RTZ_TMBKEY) + sizeof(rtz_vtx_t))
+/* the tag namespace, plain tags are not considered parameterised */
+#define RTZ_TAGPRE	"tag"
+
 #define const_vtxlst_t	rtz_const_vtxlst_t
 
 static rtz_vtxkey_t rtz_vtxkey(rtz_vtx_t vid);
 static rtz_vtx_t rtz_vtx(rtz_vtxkey_t x);
 
-static rtz_vtx_t next_id(rotz_t cp);
+static rtz_vtx_t next_ids(rotz_t cp, rtz_vtx_t n);
+static int ret_ids(rotz_t cp, rtz_vtx_t from, rtz_vtx_t till);
+static rtz_vtx_t get_maxid(rotz_t cp);
 static rtz_vtx_t get_vertex(rotz_t cp, const char *v, size_t z);
+static size_t
+get_vertices(rotz_t cp, rtz_vtx_t *restrict r, const const_buf_t *v, size_t n);
 static int put_vertex(rotz_t cp, const char *a, size_t az, rtz_vtx_t v);
 static int rnm_vertex(rotz_t cp, rtz_vtxkey_t vkey, const char *v, size_t z);
 static int unput_vertex(rotz_t cp, const char *v, size_t z);
@@ -73,6 +93,10 @@ static int unrnm_vertex(rotz_t cp, rtz_vtxkey_t vkey);
 static int add_alias(rotz_t cp, rtz_vtxkey_t vkey, const char *a, size_t az);
 static int add_akalst(rotz_t ctx, rtz_vtxkey_t ak, const_buf_t al);
 static const_buf_t get_aliases(rotz_t cp, rtz_vtxkey_t svtx);
+static size_t
+get_names(
+	rotz_t cp, const rtz_vtx_t *v, size_t n,
+	void(*cb)(size_t, const char*, void*), void *clo);
 static rtz_buf_t get_aliases_r(rotz_t cp, rtz_vtxkey_t svtx);
 
 static rtz_edgkey_t rtz_edgkey(rtz_vtx_t vid);
@@ -82,6 +106,70 @@ static const_vtxlst_t get_edges(rotz_t ctx, rtz_edgkey_t src);
 static int add_edge(rotz_t ctx, rtz_edgkey_t src, rtz_vtx_t to);
 static int add_vtxlst(rotz_t ctx, rtz_edgkey_t src, const_vtxlst_t el);
 static int rem_edges(rotz_t ctx, rtz_edgkey_t src);
+static void
+edg_iter(
+	rotz_t ctx, rtz_edgkey_t from, rtz_edgkey_t till,
+	int(*cb)(rtz_vtx_t, const_vtxlst_t, void*), void *clo);
+
+static const_vtxlst_t get_children(rotz_t ctx, rtz_parkey_t par);
+static int add_child(rotz_t ctx, rtz_parkey_t par, rtz_vtx_t chld);
+static int add_chldlst(rotz_t ctx, rtz_parkey_t par, const_vtxlst_t el);
+
+static int
+put_sorted(rotz_t ctx, const const_buf_t *k, const const_buf_t *v, size_t n);
+
+static int add_parent(rotz_t cp, const char *v, size_t z, rtz_vtx_t vid);
+static int rem_parent(rotz_t cp, const char *v, size_t z, rtz_vtx_t vid);
+
+static int tx_begin(rotz_t ctx);
+static int tx_commit(rotz_t ctx);
+static void tx_abort(rotz_t ctx);
+static int tx_p(rotz_t ctx);
+static int rd_begin(rotz_t ctx);
+static void rd_end(rotz_t ctx);
+static const_buf_t get_meta(rotz_t ctx, const char *k, size_t kz);
+static int put_meta(rotz_t ctx, const char *k, size_t kz, const_buf_t v);
+
+/* change log records, one kind per write primitive */
+enum {
+	RTZ_LOG_NONE,
+	RTZ_LOG_NEXT_ID,
+	RTZ_LOG_PUT_VERTEX,
+	RTZ_LOG_RNM_VERTEX,
+	RTZ_LOG_UNPUT_VERTEX,
+	RTZ_LOG_UNRNM_VERTEX,
+	RTZ_LOG_ADD_ALIAS,
+	RTZ_LOG_ADD_AKALST,
+	RTZ_LOG_ADD_EDGE,
+	RTZ_LOG_ADD_VTXLST,
+	RTZ_LOG_REM_EDGES,
+	RTZ_LOG_ADD_CHILD,
+	RTZ_LOG_ADD_CHLDLST,
+	RTZ_LOG_PUT_SORTED,
+	RTZ_LOG_RET_IDS,
+	/* not a primitive, the key format of the records that follow */
+	RTZ_LOG_FMT,
+};
+
+struct rtz_tmb_s;
+static void free_tombs(rotz_t ctx);
+
+struct rtz_log_s;
+static int open_log(rotz_t ctx);
+static void close_log(rotz_t ctx);
+static void unrsv_ids(rotz_t ctx);
+static int open_fmt(rotz_t ctx, int rdwr);
+static void
+log_rec(
+	rotz_t ctx, unsigned int op,
+	const void *a, size_t az, const void *b, size_t bz);
+static int log_lock(rotz_t ctx);
+static const_buf_t log_mark(rotz_t ctx);
+static int log_write(rotz_t ctx, int syncp);
+static void log_drop(rotz_t ctx);
+/* the sequence number of the last logged write in the database,
+ * backends store log_mark() under it along with every commit */
+static const char seqkey[] = "\x1dseq";
 
 #if defined USE_LMDB
 # include "rotz-lmdb.c"
@@ -91,6 +179,95 @@ static int rem_edges(rotz_t ctx, rtz_edgkey_t src);
 # error need a database backend
 #endif	/* USE_*DB */
 
+
+/* key format
+ * Handles in vertex and edge keys used to be stored in native byte
+ * order, they're stored big-endian now so that key order is handle
+ * order.  Databases are stamped with their format under FMTKEY, ones
+ * without a stamp that aren't empty are of the old kind and can be
+ * converted with rotz_upgrade().
+ * Like the key buffers the format is per process. */
+#define RTZ_FMT_NATIVE	(1U)
+#define RTZ_FMT_BE	(2U)
+/* like RTZ_FMT_BE but handles are 64 bits wide */
+#define RTZ_FMT_WIDE	(3U)
+
+#if defined WITH_WIDE_IDS
+# define RTZ_FMT	RTZ_FMT_WIDE
+# define htobe_vtx	htobe64
+# define betoh_vtx	be64toh
+#else  /* !WITH_WIDE_IDS */
+# define RTZ_FMT	RTZ_FMT_BE
+# define htobe_vtx	htobe32
+# define betoh_vtx	be32toh
+#endif	/* WITH_WIDE_IDS */
+
+static const char fmtkey[] = "\x1d" "fmt";
+static const char fmtstamp[] = {RTZ_FMT};
+static unsigned int rtz_fmt = RTZ_FMT;
+
+static inline void
+rtz_putid(unsigned char *k, rtz_vtx_t v)
+{
+	if (LIKELY(rtz_fmt == RTZ_FMT)) {
+		v = htobe_vtx(v);
+	}
+	memcpy(k, &v, sizeof(v));
+	return;
+}
+
+static inline rtz_vtx_t
+rtz_getid(const unsigned char *k)
+{
+	rtz_vtx_t v;
+
+	memcpy(&v, k, sizeof(v));
+	if (LIKELY(rtz_fmt == RTZ_FMT)) {
+		v = betoh_vtx(v);
+	}
+	return v;
+}
+
+static int
+open_fmt(rotz_t ctx, int rdwr)
+{
+/* find out about the key format, stamp new databases */
+	static const char nid[] = "\x1d";
+	const_buf_t f = get_meta(ctx, fmtkey, sizeof(fmtkey));
+	unsigned int fmt;
+
+	if (f.z == 1U) {
+		fmt = (unsigned char)*f.d;
+	} else if (UNLIKELY(f.z > 1U)) {
+		return -1;
+	} else if (get_meta(ctx, nid, sizeof(nid)).z > 0U) {
+		/* the id counter is there, whatever its width */
+		fmt = RTZ_FMT_NATIVE;
+	} else if (!rdwr) {
+		fmt = RTZ_FMT;
+	} else if (UNLIKELY(put_meta(
+				    ctx, fmtkey, sizeof(fmtkey),
+				    (const_buf_t){sizeof(fmtstamp), fmtstamp}) < 0)) {
+		return -1;
+	} else {
+		fmt = RTZ_FMT;
+	}
+	switch (fmt) {
+	case RTZ_FMT:
+		break;
+#if !defined WITH_WIDE_IDS
+	case RTZ_FMT_NATIVE:
+		/* see rotz_upgrade() */
+		break;
+#endif	/* !WITH_WIDE_IDS */
+	default:
+		/* not for us, narrow and wide handles don't mix */
+		return -1;
+	}
+	rtz_fmt = fmt;
+	return 0;
+}
+
 
 /* vertex accessors
  * Our policy is that routines that know about tokyocabinet must not
@@ -108,22 +285,20 @@ static rtz_vtxkey_t
 rtz_vtxkey(rtz_vtx_t vid)
 {
 /* return the key for the incidence list */
-	static unsigned char vtx[RTZ_VTXKEY_Z] = RTZ_VTXPRE;
-	unsigned int *vi = (void*)(vtx + sizeof(RTZ_VTXPRE));
+	static __thread unsigned char vtx[RTZ_VTXKEY_Z] = RTZ_VTXPRE;
 
-	*vi = vid;
+	rtz_putid(vtx + sizeof(RTZ_VTXPRE), vid);
 	return vtx;
 }
 
 static rtz_vtx_t
 rtz_vtx(rtz_vtxkey_t x)
 {
-	const unsigned int *vi = (const void*)(x + sizeof(RTZ_VTXPRE));
-	return *vi;
+	return rtz_getid(x + sizeof(RTZ_VTXPRE));
 }
 
-static const char*
-find_in_buf(const_buf_t b, const char *s, size_t z)
+const char*
+rtz_find_in_buf(const_buf_t b, const char *s, size_t z)
 {
 	/* include the final \nul in the needle search */
 	z++;
@@ -142,8 +317,8 @@ find_in_buf(const_buf_t b, const char *s, size_t z)
 static const_buf_t
 rem_from_buf(const_buf_t b, const char *s, size_t z)
 {
-	static char *akaspc;
-	static size_t akaspz;
+	static __thread char *akaspc;
+	static __thread size_t akaspz;
 	char *ap;
 
 	if (UNLIKELY(s < b.d || s + z > b.d + b.z)) {
@@ -169,6 +344,42 @@ rem_from_buf(const_buf_t b, const char *s, size_t z)
 	return (const_buf_t){.z = ap - akaspc, .d = akaspc};
 }
 
+static size_t
+parent_z(const char *v, size_t z)
+{
+/* return the length of the parent portion of V, or 0 if V is not
+ * a parameterised name like `sector:energy' */
+	const char *p;
+
+	if ((p = memchr(v, ':', z)) == NULL || p == v) {
+		return 0U;
+	} else if ((size_t)(p - v) == sizeof(RTZ_TAGPRE) - 1U &&
+		   !memcmp(v, RTZ_TAGPRE, sizeof(RTZ_TAGPRE) - 1U)) {
+		return 0U;
+	}
+	return p - v;
+}
+
+static int
+find_sibling(const_buf_t b, const char *s, size_t z)
+{
+/* return non-0 if there's a name in B with the same parent as S */
+	size_t pz;
+
+	if (b.d == NULL || !(pz = parent_z(s, z))) {
+		return 0;
+	}
+	/* include the colon */
+	pz++;
+	for (const char *x = b.d, *const ex = b.d + b.z; x < ex;
+	     x += strlen(x) + 1U) {
+		if (!strncmp(x, s, pz)) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
 static rtz_buf_t
 get_name_r(rotz_t cp, rtz_vtxkey_t svtx)
 {
@@ -188,6 +399,8 @@ add_vertex(rotz_t cp, const char *v, size_t z, rtz_vtx_t i)
 	if (UNLIKELY(put_vertex(cp, v, z, i) < 0)) {
 		return -1;
 	}
+	/* keep the parent index up to date */
+	add_parent(cp, v, z, i);
 	/* act as though we're renaming the vertex */
 	return rnm_vertex(cp, rtz_vtxkey(i), v, z);
 }
@@ -195,26 +408,103 @@ add_vertex(rotz_t cp, const char *v, size_t z, rtz_vtx_t i)
 static int
 rem_vertex(rotz_t cp, rtz_vtx_t i, const char *v, size_t z)
 {
-	rtz_vtxkey_t vkey = rtz_vtxkey(i);
-	const_buf_t al;
+	rtz_buf_t al;
 	int res = 0;
 
-	/* get all them aliases */
-	if (LIKELY((al = get_aliases(cp, vkey)).d != NULL)) {
+	/* get all them aliases, as a copy because we're about to
+	 * modify the database in the loop below */
+	if (LIKELY((al = get_aliases_r(cp, rtz_vtxkey(i))).z > 0U)) {
 		/* go through all names in the alias list */
 		for (const char *x = al.d, *const ex = al.d + al.z;
 		     x < ex; x += z + 1) {
 			z = strlen(x);
 			res += unput_vertex(cp, x, z);
+			res += rem_parent(cp, x, z, i);
 		}
 	} else {
 		/* just to be sure */
 		res += unput_vertex(cp, v, z);
+		res += rem_parent(cp, v, z, i);
 	}
+	rotz_free_r(al);
 	res += unrnm_vertex(cp, rtz_vtxkey(i));
 	return res;
 }
 
+struct kidx_s {
+	const_buf_t k;
+	size_t i;
+};
+
+static int
+kidx_cmp(const void *x, const void *y)
+{
+/* compare keys like the database does, lexicographically with
+ * shorter keys going first */
+	const struct kidx_s *kx = x;
+	const struct kidx_s *ky = y;
+	size_t z = kx->k.z < ky->k.z ? kx->k.z : ky->k.z;
+	int res;
+
+	if ((res = memcmp(kx->k.d, ky->k.d, z))) {
+		return res;
+	}
+	return (kx->k.z > ky->k.z) - (kx->k.z < ky->k.z);
+}
+
+struct vidx_s {
+	rtz_vtx_t v;
+	size_t i;
+};
+
+static int
+vidx_cmp(const void *x, const void *y)
+{
+/* compare vertices in the order of their vertex keys, that's handle
+ * order for big-endian keys and byte order for native ones */
+	const struct vidx_s *vx = x;
+	const struct vidx_s *vy = y;
+
+	if (LIKELY(rtz_fmt == RTZ_FMT)) {
+		return (vx->v > vy->v) - (vx->v < vy->v);
+	}
+	return memcmp(&vx->v, &vy->v, sizeof(vx->v));
+}
+
+struct names_clo_s {
+	rtz_buf_t *arena;
+	size_t ai;
+	size_t *off;
+	const struct vidx_s *vi;
+	/* names dropped for want of memory */
+	size_t oom;
+};
+
+static void
+names_cb(size_t i, const char *nm, void *clo)
+{
+	struct names_clo_s *cp = clo;
+	size_t z = strlen(nm) + 1U/*\nul*/;
+
+	if (UNLIKELY(cp->ai + z > cp->arena->z)) {
+		const size_t nz = ((cp->ai + z) / 4096U + 1U) * 4096U;
+		char *nd = realloc(cp->arena->d, nz);
+
+		if (UNLIKELY(nd == NULL)) {
+			/* leave this one unresolved */
+			cp->oom++;
+			return;
+		}
+		*cp->arena = (rtz_buf_t){nz, nd};
+	}
+	memcpy(cp->arena->d + cp->ai, nm, z);
+	/* keep track of the offset, pointers into the arena can't be
+	 * handed out before all the reallocing is done */
+	cp->off[cp->vi[i].i] = cp->ai + 1U;
+	cp->ai += z;
+	return;
+}
+
 /* API */
 rtz_vtx_t
 rotz_get_vertex(rotz_t ctx, const char *v)
@@ -222,6 +512,119 @@ rotz_get_vertex(rotz_t ctx, const char *v)
 	return get_vertex(ctx, v, strlen(v));
 }
 
+size_t
+rotz_get_vertices(rotz_t ctx, const char *const v[], size_t n, rtz_vtx_t res[])
+{
+	struct kidx_s *ki;
+	const_buf_t *k;
+	rtz_vtx_t *r;
+	size_t nres;
+
+	if (UNLIKELY(n == 0U)) {
+		return 0U;
+	} else if (UNLIKELY((ki = malloc(
+				     n * (sizeof(*ki) +
+					  sizeof(*k) + sizeof(*r)))) == NULL)) {
+		/* as if none were found */
+		memset(res, 0, n * sizeof(*res));
+		return 0U;
+	}
+	/* the backend wants the bare keys and a result vector */
+	k = (void*)(ki + n);
+	r = (void*)(k + n);
+
+	for (size_t i = 0U; i < n; i++) {
+		ki[i] = (struct kidx_s){{strlen(v[i]), v[i]}, i};
+	}
+	/* sort them keys so the backend can sweep the key space once */
+	qsort(ki, n, sizeof(*ki), kidx_cmp);
+	for (size_t i = 0U; i < n; i++) {
+		k[i] = ki[i].k;
+	}
+	nres = get_vertices(ctx, r, k, n);
+	/* scatter results back */
+	for (size_t i = 0U; i < n; i++) {
+		res[ki[i].i] = r[i];
+	}
+	free(ki);
+	return nres;
+}
+
+
+/* id reservation */
+#define RTZ_RSV_Z	(4096U)
+
+static rtz_vtx_t
+next_id(rotz_t ctx)
+{
+/* hand out the next id of our block, reserve a new block if need be */
+	if (UNLIKELY(ctx->idlo >= ctx->idhi)) {
+		rtz_vtx_t n = RTZ_RSV_Z;
+		rtz_vtx_t lo;
+
+		if (UNLIKELY(get_maxid(ctx) > (rtz_vtx_t)-1 - RTZ_RSV_Z)) {
+			/* close to running out, go one by one */
+			n = 1U;
+		}
+		/* the backend's counter may be narrower still */
+		if (UNLIKELY(!(lo = next_ids(ctx, n))) &&
+		    (n == 1U || !(lo = next_ids(ctx, n = 1U)))) {
+			return 0U;
+		}
+		ctx->idlo = lo;
+		ctx->idhi = lo + n;
+	}
+	return ctx->idlo++;
+}
+
+static void
+unrsv_ids(rotz_t ctx)
+{
+/* give back what's left of our block, if someone reserved ids
+ * after us the tail is simply abandoned */
+	if (ctx->idlo < ctx->idhi) {
+		ret_ids(ctx, ctx->idlo, ctx->idhi);
+	}
+	ctx->idlo = ctx->idhi = 0U;
+	return;
+}
+
+rtz_vtx_t
+rotz_reserve_ids(rotz_t ctx, size_t n)
+{
+	rtz_vtx_t lo;
+
+	if (UNLIKELY(n == 0U || n >= (rtz_vtx_t)-1)) {
+		return 0U;
+	} else if (UNLIKELY(n > (rtz_vtx_t)-1 - get_maxid(ctx))) {
+		/* the handle space would wrap around */
+		return 0U;
+	} else if (ctx->idhi - ctx->idlo >= n) {
+		/* got enough in stock */
+		return ctx->idlo;
+	}
+	/* swap our block for one of exactly N ids */
+	unrsv_ids(ctx);
+	if (UNLIKELY(!(lo = next_ids(ctx, (rtz_vtx_t)n)))) {
+		return 0U;
+	}
+	ctx->idlo = lo;
+	ctx->idhi = lo + (rtz_vtx_t)n;
+	return lo;
+}
+
+rtz_vtx_t
+rotz_get_maxid(rotz_t ctx)
+{
+	rtz_vtx_t res = get_maxid(ctx);
+
+	/* don't count what's still in our block */
+	if (ctx->idlo < ctx->idhi && res == ctx->idhi - 1U) {
+		res = ctx->idlo - 1U;
+	}
+	return res;
+}
+
 rtz_vtx_t
 rotz_add_vertex(rotz_t ctx, const char *v)
 {
@@ -257,8 +660,8 @@ rotz_rem_vertex(rotz_t ctx, const char *v)
 const char*
 rotz_get_name(rotz_t ctx, rtz_vtx_t v)
 {
-	static char *nmspc;
-	static size_t nmspcz;
+	static __thread char *nmspc;
+	static __thread size_t nmspcz;
 	rtz_vtxkey_t vkey = rtz_vtxkey(v);
 	const_buf_t buf;
 
@@ -282,6 +685,52 @@ rotz_get_name_r(rotz_t ctx, rtz_vtx_t v)
 	return get_name_r(ctx, rtz_vtxkey(v));
 }
 
+size_t
+rotz_get_names(
+	rotz_t ctx, const rtz_vtx_t v[], size_t n,
+	const char *res[], rtz_buf_t *arena)
+{
+	struct vidx_s *vi;
+	rtz_vtx_t *sv;
+	size_t *off;
+	size_t nres;
+
+	if (UNLIKELY(n == 0U)) {
+		return 0U;
+	} else if (UNLIKELY((vi = malloc(
+				     n * (sizeof(*vi) +
+					  sizeof(*off) + sizeof(*sv)))) == NULL)) {
+		/* as if none were found */
+		for (size_t i = 0U; i < n; i++) {
+			res[i] = NULL;
+		}
+		return 0U;
+	}
+	/* the backend wants the bare vertices */
+	off = (void*)(vi + n);
+	sv = (void*)(off + n);
+
+	for (size_t i = 0U; i < n; i++) {
+		vi[i] = (struct vidx_s){v[i], i};
+		off[i] = 0U;
+	}
+	/* sort them so the backend can sweep the key space once */
+	qsort(vi, n, sizeof(*vi), vidx_cmp);
+	for (size_t i = 0U; i < n; i++) {
+		sv[i] = vi[i].v;
+	}
+	with (struct names_clo_s clo = {arena, 0U, off, vi, 0U}) {
+		nres = get_names(ctx, sv, n, names_cb, &clo);
+		nres -= clo.oom;
+	}
+	/* now that the arena has settled, hand out pointers */
+	for (size_t i = 0U; i < n; i++) {
+		res[i] = off[i] ? arena->d + off[i] - 1U : NULL;
+	}
+	free(vi);
+	return nres;
+}
+
 void
 rotz_free_r(rtz_buf_t buf)
 {
@@ -310,10 +759,13 @@ rotz_add_alias(rotz_t ctx, rtz_vtx_t v, const char *alias)
 		;
 	} else if (UNLIKELY(put_vertex(ctx, alias, aliaz, v) < 0)) {
 		return -1;
+	} else {
+		/* new name, maybe with a new parent */
+		add_parent(ctx, alias, aliaz, v);
 	}
 	/* check aliases */
 	if ((al = get_aliases(ctx, akey = rtz_vtxkey(v))).d != NULL &&
-	    UNLIKELY(find_in_buf(al, alias, aliaz) != NULL)) {
+	    UNLIKELY(rtz_find_in_buf(al, alias, aliaz) != NULL)) {
 		/* alias is already in the list */
 		return 0;
 	} else if (UNLIKELY(add_alias(ctx, akey, alias, aliaz) < 0)) {
@@ -338,7 +790,7 @@ rotz_rem_alias(rotz_t ctx, const char *alias)
 	}
 	/* now remove that alias from the alias list */
 	if ((al = get_aliases(ctx, akey = rtz_vtxkey(aid))).d == NULL ||
-	    UNLIKELY((ap = find_in_buf(al, alias, aliaz)) == NULL)) {
+	    UNLIKELY((ap = rtz_find_in_buf(al, alias, aliaz)) == NULL)) {
 		/* alias is already removed innit? */
 		;
 	} else if (UNLIKELY((al = rem_from_buf(al, ap, aliaz + 1)).d == NULL)) {
@@ -348,6 +800,10 @@ rotz_rem_alias(rotz_t ctx, const char *alias)
 		/* just reassing the list with the tag removed */
 		add_akalst(ctx, akey, al);
 	}
+	if (!find_sibling(al, alias, aliaz)) {
+		/* no other name of AID under the same parent */
+		rem_parent(ctx, alias, aliaz, aid);
+	}
 	unput_vertex(ctx, alias, aliaz);
 	return 0;
 }
@@ -364,10 +820,9 @@ static rtz_edgkey_t
 rtz_edgkey(rtz_vtx_t vid)
 {
 /* return the key for the incidence list */
-	static unsigned char edg[RTZ_EDGKEY_Z] = RTZ_EDGPRE;
-	unsigned int *vi = (void*)(edg + sizeof(RTZ_EDGPRE));
+	static __thread unsigned char edg[RTZ_EDGKEY_Z] = RTZ_EDGPRE;
 
-	*vi = vid;
+	rtz_putid(edg + sizeof(RTZ_EDGPRE), vid);
 	return edg;
 }
 
@@ -375,12 +830,11 @@ static rtz_vtx_t
 rtz_edg(rtz_edgkey_t edg)
 {
 /* return the key for the incidence list */
-	const unsigned int *vi = (const void*)(edg + sizeof(RTZ_EDGPRE));
-	return *vi;
+	return rtz_getid(edg + sizeof(RTZ_EDGPRE));
 }
 
-static size_t
-find_in_vtxlst(const_vtxlst_t el, rtz_vtx_t to)
+size_t
+rtz_find_in_vtxlst(const_vtxlst_t el, rtz_vtx_t to)
 {
 	for (size_t i = 0; i < el.z; i++) {
 		if (el.d[i] == to) {
@@ -393,8 +847,8 @@ find_in_vtxlst(const_vtxlst_t el, rtz_vtx_t to)
 static const_vtxlst_t
 rem_from_vtxlst(const_vtxlst_t el, size_t idx)
 {
-	static rtz_vtx_t *edgspc;
-	static size_t edgspz;
+	static __thread rtz_vtx_t *edgspc;
+	static __thread size_t edgspz;
 	rtz_vtx_t *ep;
 
 	if (UNLIKELY(el.z * sizeof(*edgspc) > edgspz)) {
@@ -418,170 +872,2724 @@ rem_from_vtxlst(const_vtxlst_t el, size_t idx)
 	return (const_vtxlst_t){.z = ep - edgspc, .d = edgspc};
 }
 
-/* API */
-int
-rotz_get_edge(rotz_t ctx, rtz_vtx_t from, rtz_vtx_t to)
+static int
+vtx_cmp(const void *x, const void *y)
 {
-	rtz_edgkey_t sfrom = rtz_edgkey(from);
-	const_vtxlst_t el;
+	const rtz_vtx_t *vx = x;
+	const rtz_vtx_t *vy = y;
 
-	/* get edges under */
-	if (LIKELY((el = get_edges(ctx, sfrom)).d != NULL) &&
-	    LIKELY(find_in_vtxlst(el, to) > 0U)) {
-		/* to is already there */
-		return 1;
-	}
-	return 0;
+	return (*vx > *vy) - (*vx < *vy);
 }
 
-rtz_vtxlst_t
-rotz_get_edges(rotz_t ctx, rtz_vtx_t from)
+static size_t
+sort_vtxlst(rtz_vtx_t *restrict v, size_t n)
 {
-	rtz_edgkey_t sfrom = rtz_edgkey(from);
-	const_vtxlst_t el;
-	rtz_vtx_t *d;
+/* sort V in place and squeeze out duplicates and 0s, return the new size */
+	size_t m = 0U;
 
-	/* get edges under */
-	if (UNLIKELY((el = get_edges(ctx, sfrom)).d == NULL)) {
-		return (rtz_vtxlst_t){0U};
-	}
-	/* otherwise make a copy */
-	{
-		size_t mz = el.z * sizeof(*d);
-		d = malloc(mz);
-		memcpy(d, el.d, mz);
+	qsort(v, n, sizeof(*v), vtx_cmp);
+	for (size_t i = 0U; i < n; i++) {
+		if (v[i] && (m == 0U || v[i] != v[m - 1U])) {
+			v[m++] = v[i];
+		}
 	}
-	return (rtz_vtxlst_t){.z = el.z, .d = d};
-}
-
-size_t
-rotz_get_nedges(rotz_t ctx, rtz_vtx_t from)
-{
-	rtz_edgkey_t sfrom = rtz_edgkey(from);
-
-	return get_edges(ctx, sfrom).z;
+	return m;
 }
 
-int
-rotz_rem_edges(rotz_t ctx, rtz_vtx_t from)
+static const_vtxlst_t
+merge_vtxlst(const_vtxlst_t el, const rtz_vtx_t *to, size_t n)
 {
-	rtz_edgkey_t sfrom = rtz_edgkey(from);
-
-	return rem_edges(ctx, sfrom);
-}
+/* append the vertices in TO that aren't in EL yet, in the order of TO,
+ * the result resides in static space */
+	static __thread rtz_vtx_t *edgspc;
+	static __thread size_t edgspz;
+	static __thread unsigned char *tkn;
+	static __thread size_t tknz;
+	rtz_vtx_t *ep;
+	rtz_vtx_t *srt;
+	rtz_vtx_t *old;
+	size_t m;
+	size_t k = 0U;
 
-void
-rotz_free_vtxlst(rtz_vtxlst_t el)
-{
-	if (LIKELY(el.d != NULL)) {
-		free(el.d);
+	if (UNLIKELY(2U * (el.z + n) * sizeof(*edgspc) > edgspz)) {
+		edgspz = ((2U * (el.z + n) * sizeof(*edgspc) - 1) / 64U + 1U) * 64U;
+		edgspc = realloc(edgspc, edgspz);
 	}
-	return;
-}
+	if (UNLIKELY(n > tknz)) {
+		tknz = ((n - 1U) / 64U + 1U) * 64U;
+		tkn = realloc(tkn, tknz);
+	}
+	/* layout is: result | sorted TO | sorted EL */
+	ep = edgspc;
+	srt = ep + el.z + n;
+	old = srt + n;
 
-void
-rotz_free_wtxlst(rtz_wtxlst_t wl)
-{
-	if (LIKELY(wl.d != NULL)) {
-		free(wl.d);
+	if (n) {
+		memcpy(srt, to, n * sizeof(*to));
 	}
-	if (LIKELY(wl.w != NULL)) {
-		free(wl.w);
+	m = sort_vtxlst(srt, n);
+	if (el.z) {
+		memcpy(old, el.d, el.z * sizeof(*el.d));
+		qsort(old, el.z, sizeof(*old), vtx_cmp);
 	}
-	return;
-}
-
-int
-rotz_add_edge(rotz_t ctx, rtz_vtx_t from, rtz_vtx_t to)
-{
-	rtz_edgkey_t sfrom = rtz_edgkey(from);
-	const_vtxlst_t el;
+	/* merge, keeping only the newcomers */
+	for (size_t i = 0U, j = 0U; i < m; i++) {
+		while (j < el.z && old[j] < srt[i]) {
+			j++;
+		}
+		if (j >= el.z || old[j] != srt[i]) {
+			srt[k++] = srt[i];
+		}
+	}
+	memset(tkn, 0, k);
 
-	/* get edges under */
-	if ((el = get_edges(ctx, sfrom)).d != NULL &&
-	    UNLIKELY(find_in_vtxlst(el, to) > 0U)) {
-		/* to is already there */
-		return 0;
+	/* incumbents first, newcomers in the order of TO */
+	if (el.z) {
+		memcpy(ep, el.d, el.z * sizeof(*el.d));
+		ep += el.z;
 	}
-	if (UNLIKELY(add_edge(ctx, sfrom, to) < 0)) {
-		return -1;
+	for (size_t i = 0U; i < n && k; i++) {
+		const rtz_vtx_t *x = bsearch(to + i, srt, k, sizeof(*srt), vtx_cmp);
+
+		if (x != NULL && !tkn[x - srt]) {
+			tkn[x - srt] = 1U;
+			*ep++ = to[i];
+		}
 	}
-	return 1;
+	return (const_vtxlst_t){.z = ep - edgspc, .d = edgspc};
 }
 
-int
-rotz_rem_edge(rotz_t ctx, rtz_vtx_t from, rtz_vtx_t to)
+static const_vtxlst_t
+sieve_vtxlst(const_vtxlst_t el, const rtz_vtx_t *srt, size_t n)
 {
-	rtz_edgkey_t sfrom = rtz_edgkey(from);
-	const_vtxlst_t el;
-	size_t idx;
+/* return EL without the vertices in the sorted array SRT of size N,
+ * the result resides in static space */
+	static __thread rtz_vtx_t *edgspc;
+	static __thread size_t edgspz;
+	rtz_vtx_t *ep;
 
-	/* get edges under */
-	if (UNLIKELY((el = get_edges(ctx, sfrom)).d == NULL) ||
-	    UNLIKELY((idx = find_in_vtxlst(el, to)) == 0U)) {
-		/* TO isn't in there */
-		return 0;
+	if (UNLIKELY(el.z * sizeof(*edgspc) > edgspz)) {
+		edgspz = ((el.z * sizeof(*edgspc) - 1) / 64U + 1U) * 64U;
+		edgspc = realloc(edgspc, edgspz);
 	}
-	if (UNLIKELY((el = rem_from_vtxlst(el, idx)).d == NULL)) {
-		/* huh? */
-		return -1;
+	ep = edgspc;
+	for (size_t i = 0U; i < el.z; i++) {
+		if (bsearch(el.d + i, srt, n, sizeof(*srt), vtx_cmp) == NULL) {
+			*ep++ = el.d[i];
+		}
 	}
-	add_vtxlst(ctx, sfrom, el);
-	return 1;
+	return (const_vtxlst_t){.z = ep - edgspc, .d = edgspc};
 }
 
-
-/* set opers */
-static rtz_vtxlst_t
-add_to_vtxlst(rtz_vtxlst_t el, rtz_vtx_t v)
+static const_vtxlst_t
+prune_vtxlst(const_vtxlst_t el, const rtz_vtx_t *to, size_t n)
 {
-	if (UNLIKELY(!(el.z % 64U))) {
-		size_t nu = (el.z + 64U) * sizeof(*el.d);
+/* return EL without the vertices in TO, the result resides in static space */
+	static __thread rtz_vtx_t *srt;
+	static __thread size_t srtz;
 
-		el.d = realloc(el.d, nu);
-		memset(el.d + el.z, 0, 64U * sizeof(*el.d));
+	if (UNLIKELY(n * sizeof(*srt) > srtz)) {
+		srtz = ((n * sizeof(*srt) - 1) / 64U + 1U) * 64U;
+		srt = realloc(srt, srtz);
 	}
-	el.d[el.z++] = v;
-	return el;
+	if (n) {
+		memcpy(srt, to, n * sizeof(*to));
+	}
+	return sieve_vtxlst(el, srt, sort_vtxlst(srt, n));
 }
 
-static rtz_wtxlst_t
-add_to_wtxlst(rtz_wtxlst_t wl, rtz_vtx_t v)
+static const_vtxlst_t
+swap_in_vtxlst(const_vtxlst_t el, rtz_vtx_t old, rtz_vtx_t new)
 {
-	if (UNLIKELY(!(wl.z % 64U))) {
-		size_t nu;
-
-		nu = (wl.z + 64U) * sizeof(*wl.d);
-		wl.d = realloc(wl.d, nu);
-		memset(wl.d + wl.z, 0, 64U * sizeof(*wl.d));
+/* replace OLD by NEW in EL or, if NEW is in EL already, just drop OLD,
+ * the result resides in static space */
+	static __thread rtz_vtx_t *edgspc;
+	static __thread size_t edgspz;
+	const int dupp = rtz_find_in_vtxlst(el, new) > 0U;
+	rtz_vtx_t *ep;
 
-		nu = (wl.z + 64U) * sizeof(*wl.w);
-		wl.w = realloc(wl.w, nu);
-		memset(wl.w + wl.z, 0, 64U * sizeof(*wl.w));
+	if (UNLIKELY(el.z * sizeof(*edgspc) > edgspz)) {
+		edgspz = ((el.z * sizeof(*edgspc) - 1) / 64U + 1U) * 64U;
+		edgspc = realloc(edgspc, edgspz);
 	}
-	wl.d[wl.z++] = v;
-	return wl;
+	ep = edgspc;
+	for (size_t i = 0U; i < el.z; i++) {
+		if (el.d[i] != old) {
+			*ep++ = el.d[i];
+		} else if (!dupp) {
+			*ep++ = new;
+		}
+	}
+	return (const_vtxlst_t){.z = ep - edgspc, .d = edgspc};
 }
 
-static rtz_vtxlst_t
-vtxlst_union(rtz_vtxlst_t tgt, const_vtxlst_t el)
+static int
+merge_vertices(rotz_t ctx, rtz_vtx_t into, rtz_vtx_t from)
 {
-	const size_t tgtz = tgt.z;
+	rtz_vtxlst_t el = rotz_get_edges(ctx, from);
+	rtz_buf_t al;
+	size_t m = 0U;
+	int res = 0;
 
-	for (size_t i = 0; i < el.z; i++) {
-		rtz_vtx_t item = el.d[i];
+	/* FROM's neighbours, bar INTO and FROM themselves, go to INTO */
+	for (size_t i = 0U; i < el.z; i++) {
+		if (el.d[i] != into && el.d[i] != from) {
+			el.d[m++] = el.d[i];
+		}
+	}
+	with (rtz_edgkey_t sinto = rtz_edgkey(into)) {
+		const_vtxlst_t il = get_edges(ctx, sinto);
+		const_vtxlst_t nu = merge_vtxlst(il, el.d, m);
+		int dirtp = nu.z != il.z;
+
+		if (rtz_find_in_vtxlst(nu, from) > 0U) {
+			/* INTO was adjacent to FROM */
+			nu = prune_vtxlst(nu, &from, 1U);
+			dirtp = 1;
+		}
+		if (dirtp && UNLIKELY(add_vtxlst(ctx, sinto, nu) < 0)) {
+			res = -1;
+		}
+	}
+	/* rewrite the neighbours' lists, each of them once */
+	for (size_t i = 0U; i < m; i++) {
+		rtz_edgkey_t sn = rtz_edgkey(el.d[i]);
+		const_vtxlst_t nl = get_edges(ctx, sn);
 
-		/* got this one? */
-		if (find_in_vtxlst((const_vtxlst_t){tgtz, tgt.d}, item)) {
+		if (rtz_find_in_vtxlst(nl, from) == 0U) {
 			continue;
 		}
-		tgt = add_to_vtxlst(tgt, item);
+		nl = swap_in_vtxlst(nl, from, into);
+		if (UNLIKELY(add_vtxlst(ctx, sn, nl) < 0)) {
+			res = -1;
+		}
 	}
-	return tgt;
-}
+	if (el.d != NULL && UNLIKELY(rem_edges(ctx, rtz_edgkey(from)) < 0)) {
+		res = -1;
+	}
+	rotz_free_vtxlst(el);
+
+	/* move FROM's names over to INTO */
+	if ((al = get_aliases_r(ctx, rtz_vtxkey(from))).z > 0U) {
+		if (UNLIKELY(rem_vertex(ctx, from, al.d, strlen(al.d)) < 0)) {
+			res = -1;
+		}
+		for (const char *x = al.d, *const ex = al.d + al.z;
+		     x < ex; x += strlen(x) + 1U) {
+			if (UNLIKELY(rotz_add_alias(ctx, into, x) < 0)) {
+				res = -1;
+			}
+		}
+	}
+	rotz_free_r(al);
+	return res;
+}
+
+/* Tombstones change seldom, handles keep the list around until the
+ * generation counter under TMBGEN moves on. */
+static const const_buf_t tmbgen = {sizeof(RTZ_TMBKEY) - 1U, RTZ_TMBKEY};
+
+struct rtz_tmb_s {
+	rtz_vtx_t gen;
+	rtz_vtxlst_t tl;
+};
+
+static rtz_vtx_t
+get_tmbgen(rotz_t ctx)
+{
+	const_vtxlst_t g = get_children(ctx, tmbgen);
+	return g.z > 0U ? *g.d : 0U;
+}
+
+static int
+bump_tmbgen(rotz_t ctx)
+{
+	const rtz_vtx_t g = get_tmbgen(ctx) + 1U;
+	return add_chldlst(ctx, tmbgen, (const_vtxlst_t){1U, &g});
+}
+
+static const_buf_t
+rtz_tmbkey(unsigned char k[static RTZ_TMBKEY_Z], rtz_vtx_t v)
+{
+/* handles in tombstone keys are big-endian whatever the key format */
+	v = htobe_vtx(v);
+	memcpy(k, RTZ_TMBKEY, sizeof(RTZ_TMBKEY));
+	memcpy(k + sizeof(RTZ_TMBKEY), &v, sizeof(v));
+	return (const_buf_t){RTZ_TMBKEY_Z, (const char*)k};
+}
+
+struct tomb_clo_s {
+	rtz_vtxlst_t tl;
+	size_t tz;
+	int oom;
+};
+
+static int
+tomb_cb(rtz_const_buf_t k, rtz_const_buf_t v, void *clo)
+{
+	struct tomb_clo_s *c = clo;
+	const size_t n = v.z / sizeof(*c->tl.d);
+
+	if (UNLIKELY(k.z != RTZ_TMBKEY_Z)) {
+		return 0;
+	} else if (UNLIKELY(c->tl.z + n > c->tz)) {
+		size_t nz = c->tz * 2U ?: 256U;
+		rtz_vtx_t *nu;
+
+		while (nz < c->tl.z + n) {
+			nz *= 2U;
+		}
+		if (UNLIKELY((nu = realloc(c->tl.d, nz * sizeof(*nu))) == NULL)) {
+			c->oom = 1;
+			return -1;
+		}
+		c->tl.d = nu;
+		c->tz = nz;
+	}
+	memcpy(c->tl.d + c->tl.z, v.d, n * sizeof(*c->tl.d));
+	c->tl.z += n;
+	return 0;
+}
+
+static int
+get_tombs_r(rotz_t ctx, rtz_vtxlst_t *res)
+{
+/* collect the tombstoned vertices, big-endian handles in the keys
+ * make sure they come sorted */
+	static const const_buf_t tk = {sizeof(RTZ_TMBKEY), RTZ_TMBKEY};
+	struct tomb_clo_s c = {.tl = {0U}};
+
+	rotz_iter(ctx, tk, tomb_cb, &c);
+	if (UNLIKELY(c.oom)) {
+		rotz_free_vtxlst(c.tl);
+		*res = (rtz_vtxlst_t){0U};
+		return -1;
+	}
+	*res = c.tl;
+	return 0;
+}
+
+static void
+free_tombs(rotz_t ctx)
+{
+	if (ctx->tmb != NULL) {
+		rotz_free_vtxlst(ctx->tmb->tl);
+		free(ctx->tmb);
+		ctx->tmb = NULL;
+	}
+	return;
+}
+
+static const_vtxlst_t
+get_live_edges(rotz_t ctx, rtz_edgkey_t src)
+{
+/* like get_edges() but without tombstoned vertices, if there are any
+ * the result resides in static space */
+	const rtz_vtx_t g = get_tmbgen(ctx);
+	struct rtz_tmb_s *t = ctx->tmb;
+	const_vtxlst_t el;
+
+	if (t == NULL || t->gen != g) {
+		rtz_vtxlst_t tl;
+
+		if (t == NULL &&
+		    UNLIKELY((t = ctx->tmb = calloc(1U, sizeof(*t))) == NULL)) {
+			return (const_vtxlst_t){0U};
+		} else if (UNLIKELY(get_tombs_r(ctx, &tl) < 0)) {
+			return (const_vtxlst_t){0U};
+		}
+		rotz_free_vtxlst(t->tl);
+		t->tl = tl;
+		t->gen = g;
+	}
+	if (LIKELY(t->tl.z == 0U)) {
+		return get_edges(ctx, src);
+	} else if ((el = get_edges(ctx, src)).d == NULL) {
+		return el;
+	}
+	return sieve_vtxlst(el, t->tl.d, t->tl.z);
+}
+
+struct live_clo_s {
+	int(*cb)(rtz_vtx_t, const_vtxlst_t, void*);
+	void *clo;
+	rtz_vtxlst_t tl;
+	rtz_vtx_t *d;
+	size_t dz;
+	int oom;
+};
+
+static int
+live_edg_cb(rtz_vtx_t v, const_vtxlst_t el, void *clo)
+{
+/* filter EL before passing it on, we can't use sieve_vtxlst()'s static
+ * space as slices may be iterated concurrently */
+	struct live_clo_s *lc = clo;
+	size_t z = 0U;
+
+	if (UNLIKELY(el.z > lc->dz)) {
+		const size_t nz = (el.z / 64U + 1U) * 64U;
+		rtz_vtx_t *nd = realloc(lc->d, nz * sizeof(*nd));
+
+		if (UNLIKELY(nd == NULL)) {
+			lc->oom = -1;
+			return -1;
+		}
+		lc->d = nd;
+		lc->dz = nz;
+	}
+	for (size_t i = 0U; i < el.z; i++) {
+		if (bsearch(el.d + i, lc->tl.d, lc->tl.z,
+			    sizeof(*lc->tl.d), vtx_cmp) == NULL) {
+			lc->d[z++] = el.d[i];
+		}
+	}
+	if (UNLIKELY(z == 0U)) {
+		/* only tombstoned neighbours */
+		return 0;
+	}
+	return lc->cb(v, (const_vtxlst_t){.z = z, .d = lc->d}, lc->clo);
+}
+
+static int
+live_edg_iter(
+	rotz_t ctx, rtz_edgkey_t from, rtz_edgkey_t till,
+	int(*cb)(rtz_vtx_t, const_vtxlst_t, void*), void *clo)
+{
+/* like edg_iter() but without tombstoned vertices, slices run in
+ * several threads at once so each call collects the tombstones for
+ * itself rather than going through the handle's cache */
+	struct live_clo_s lc = {.cb = cb, .clo = clo};
+
+	if (UNLIKELY(get_tombs_r(ctx, &lc.tl) < 0)) {
+		return -1;
+	} else if (LIKELY(lc.tl.z == 0U)) {
+		edg_iter(ctx, from, till, cb, clo);
+	} else {
+		edg_iter(ctx, from, till, live_edg_cb, &lc);
+	}
+	free(lc.d);
+	rotz_free_vtxlst(lc.tl);
+	return lc.oom;
+}
+
+/* vertices without edges are garbage, they may be collected as soon
+ * as their last edge goes if so configured */
+static const char gckey[] = "\x1dgc";
+
+static int
+autogc_p(rotz_t ctx)
+{
+	const_buf_t v = get_meta(ctx, gckey, sizeof(gckey));
+	return v.z > 0U && *v.d == '1';
+}
+
+static int
+gc_vertex(rotz_t ctx, rtz_vtx_t v)
+{
+/* remove V's names, V's edges must be gone already */
+	rtz_buf_t al = get_aliases_r(ctx, rtz_vtxkey(v));
+	int res = 0;
+
+	if (al.z > 0U) {
+		res = rem_vertex(ctx, v, al.d, strlen(al.d));
+	}
+	rotz_free_r(al);
+	return res;
+}
+
+/* API */
+int
+rotz_get_edge(rotz_t ctx, rtz_vtx_t from, rtz_vtx_t to)
+{
+	rtz_edgkey_t sfrom = rtz_edgkey(from);
+	const_vtxlst_t el;
+
+	/* get edges under */
+	if (LIKELY((el = get_live_edges(ctx, sfrom)).d != NULL) &&
+	    LIKELY(rtz_find_in_vtxlst(el, to) > 0U)) {
+		/* to is already there */
+		return 1;
+	}
+	return 0;
+}
+
+rtz_vtxlst_t
+rotz_get_edges_a(rotz_t ctx, rtz_arena_t a, rtz_vtx_t from)
+{
+	rtz_edgkey_t sfrom = rtz_edgkey(from);
+	const_vtxlst_t el;
+	rtz_vtx_t *d;
+
+	/* get edges under */
+	if (UNLIKELY((el = get_live_edges(ctx, sfrom)).d == NULL)) {
+		return (rtz_vtxlst_t){0U};
+	}
+	/* otherwise make a copy */
+	{
+		size_t mz = el.z * sizeof(*d);
+		d = a != NULL ? rotz_arena_alloc(a, mz) : malloc(mz);
+		memcpy(d, el.d, mz);
+	}
+	return (rtz_vtxlst_t){.z = el.z, .d = d};
+}
+
+rtz_vtxlst_t
+rotz_get_edges(rotz_t ctx, rtz_vtx_t from)
+{
+	return rotz_get_edges_a(ctx, NULL, from);
+}
+
+size_t
+rotz_get_nedges(rotz_t ctx, rtz_vtx_t from)
+{
+	rtz_edgkey_t sfrom = rtz_edgkey(from);
+
+	return get_live_edges(ctx, sfrom).z;
+}
+
+int
+rotz_rem_edges(rotz_t ctx, rtz_vtx_t from)
+{
+	rtz_edgkey_t sfrom = rtz_edgkey(from);
+
+	return rem_edges(ctx, sfrom);
+}
+
+void
+rotz_free_vtxlst(rtz_vtxlst_t el)
+{
+	if (LIKELY(el.d != NULL)) {
+		free(el.d);
+	}
+	return;
+}
+
+void
+rotz_free_wtxlst(rtz_wtxlst_t wl)
+{
+	if (LIKELY(wl.d != NULL)) {
+		free(wl.d);
+	}
+	if (LIKELY(wl.w != NULL)) {
+		free(wl.w);
+	}
+	return;
+}
+
+int
+rotz_add_edge(rotz_t ctx, rtz_vtx_t from, rtz_vtx_t to)
+{
+	rtz_edgkey_t sfrom = rtz_edgkey(from);
+	const_vtxlst_t el;
+
+	/* get edges under */
+	if ((el = get_edges(ctx, sfrom)).d != NULL &&
+	    UNLIKELY(rtz_find_in_vtxlst(el, to) > 0U)) {
+		/* to is already there */
+		return 0;
+	}
+	if (UNLIKELY(add_edge(ctx, sfrom, to) < 0)) {
+		return -1;
+	}
+	return 1;
+}
+
+int
+rotz_rem_edge(rotz_t ctx, rtz_vtx_t from, rtz_vtx_t to)
+{
+	rtz_edgkey_t sfrom = rtz_edgkey(from);
+	const_vtxlst_t el;
+	size_t idx;
+
+	/* get edges under */
+	if (UNLIKELY((el = get_edges(ctx, sfrom)).d == NULL) ||
+	    UNLIKELY((idx = rtz_find_in_vtxlst(el, to)) == 0U)) {
+		/* TO isn't in there */
+		return 0;
+	}
+	if (UNLIKELY((el = rem_from_vtxlst(el, idx)).d == NULL)) {
+		/* huh? */
+		return -1;
+	}
+	add_vtxlst(ctx, sfrom, el);
+	if (el.z == 0U && autogc_p(ctx)) {
+		/* FROM has become garbage */
+		gc_vertex(ctx, from);
+	}
+	return 1;
+}
+
+int
+rotz_add_edges(rotz_t ctx, rtz_vtx_t from, const rtz_vtx_t to[], size_t n)
+{
+	rtz_edgkey_t sfrom = rtz_edgkey(from);
+	const_vtxlst_t el;
+	const_vtxlst_t nu;
+
+	if (UNLIKELY(n == 0U)) {
+		return 0;
+	}
+	/* get edges under, merge and write back in one go */
+	el = get_edges(ctx, sfrom);
+	if ((nu = merge_vtxlst(el, to, n)).z == el.z) {
+		/* all of them are there already */
+		return 0;
+	} else if (UNLIKELY(add_vtxlst(ctx, sfrom, nu) < 0)) {
+		return -1;
+	}
+	return (int)(nu.z - el.z);
+}
+
+int
+rotz_rem_edges_bulk(rotz_t ctx, rtz_vtx_t from, const rtz_vtx_t to[], size_t n)
+{
+	rtz_edgkey_t sfrom = rtz_edgkey(from);
+	const_vtxlst_t el;
+	const_vtxlst_t nu;
+
+	/* get edges under */
+	if (UNLIKELY(n == 0U) ||
+	    UNLIKELY((el = get_edges(ctx, sfrom)).d == NULL)) {
+		/* nothing to remove */
+		return 0;
+	} else if ((nu = prune_vtxlst(el, to, n)).z == el.z) {
+		/* none of them are in there */
+		return 0;
+	} else if (UNLIKELY(add_vtxlst(ctx, sfrom, nu) < 0)) {
+		return -1;
+	} else if (nu.z == 0U && autogc_p(ctx)) {
+		/* FROM has become garbage */
+		gc_vertex(ctx, from);
+	}
+	return (int)(el.z - nu.z);
+}
+
+int
+rotz_merge_vertices(rotz_t ctx, rtz_vtx_t into, rtz_vtx_t from)
+{
+	/* only commit what we began */
+	const int ownp = !tx_p(ctx);
+	int res;
+
+	if (UNLIKELY(!into || !from)) {
+		return -1;
+	} else if (UNLIKELY(into == from)) {
+		return 0;
+	} else if (ownp && UNLIKELY(tx_begin(ctx) < 0)) {
+		return -1;
+	}
+	if ((res = merge_vertices(ctx, into, from)) < 0 && ownp) {
+		tx_abort(ctx);
+	} else if (ownp && UNLIKELY(tx_commit(ctx) < 0)) {
+		res = -1;
+	}
+	return res;
+}
+
+static void
+rtz_edgslice(
+	unsigned char k[static RTZ_EDGKEY_Z], rtz_vtx_t maxid,
+	unsigned int i, unsigned int n)
+{
+/* put the key at which slice I of N begins into K, handles 1 to MAXID
+ * are divided evenly, in old databases the key space is divided evenly
+ * on the bytes of the vertex portion instead */
+	uint32_t x = (uint32_t)(((uint_least64_t)i << 32U) / n);
+
+	memcpy(k, RTZ_EDGPRE, sizeof(RTZ_EDGPRE));
+	k += sizeof(RTZ_EDGPRE);
+	if (LIKELY(rtz_fmt == RTZ_FMT)) {
+		/* MAXID * I / N without overflowing wide handles */
+		rtz_putid(k, 1U + maxid / n * i + maxid % n * i / n);
+		return;
+	}
+	k[0U] = (unsigned char)(x >> 24U);
+	k[1U] = (unsigned char)(x >> 16U);
+	k[2U] = (unsigned char)(x >> 8U);
+	k[3U] = (unsigned char)(x >> 0U);
+	return;
+}
+
+void
+rotz_edg_iter(rotz_t ctx, int(*cb)(rtz_vtx_t, const_vtxlst_t, void*), void *clo)
+{
+	live_edg_iter(ctx, NULL, NULL, cb, clo);
+	return;
+}
+
+void
+rotz_edg_iter_slice(
+	rotz_t ctx, unsigned int i, unsigned int n,
+	int(*cb)(rtz_vtx_t, const_vtxlst_t, void*), void *clo)
+{
+	unsigned char from[RTZ_EDGKEY_Z];
+	unsigned char till[RTZ_EDGKEY_Z];
+	rtz_vtx_t maxid;
+
+	if (UNLIKELY(i >= n)) {
+		return;
+	}
+	maxid = get_maxid(ctx);
+	rtz_edgslice(from, maxid, i, n);
+	rtz_edgslice(till, maxid, i + 1U, n);
+	live_edg_iter(ctx, i > 0U ? from : NULL, i + 1U < n ? till : NULL, cb, clo);
+	return;
+}
+
+struct range_clo_s {
+	rtz_vtx_t lo;
+	rtz_vtx_t hi;
+	int(*cb)(rtz_vtx_t, const_vtxlst_t, void*);
+	void *clo;
+};
+
+static int
+range_cb(rtz_vtx_t v, const_vtxlst_t el, void *clo)
+{
+/* old databases aren't in handle order, filter */
+	const struct range_clo_s *c = clo;
+
+	if (v < c->lo || (c->hi && v >= c->hi)) {
+		return 0;
+	}
+	return c->cb(v, el, c->clo);
+}
+
+void
+rotz_edg_iter_range(
+	rotz_t ctx, rtz_vtx_t lo, rtz_vtx_t hi,
+	int(*cb)(rtz_vtx_t, const_vtxlst_t, void*), void *clo)
+{
+	unsigned char from[RTZ_EDGKEY_Z] = RTZ_EDGPRE;
+	unsigned char till[RTZ_EDGKEY_Z] = RTZ_EDGPRE;
+
+	if (UNLIKELY(hi && hi <= lo)) {
+		return;
+	} else if (UNLIKELY(rtz_fmt != RTZ_FMT)) {
+		struct range_clo_s c = {lo, hi, cb, clo};
+
+		live_edg_iter(ctx, NULL, NULL, range_cb, &c);
+		return;
+	}
+	rtz_putid(from + sizeof(RTZ_EDGPRE), lo);
+	rtz_putid(till + sizeof(RTZ_EDGPRE), hi);
+	live_edg_iter(ctx, lo ? from : NULL, hi ? till : NULL, cb, clo);
+	return;
+}
+
+
+/* tombstones
+ * Dropping a vertex removes its names and its own edge list right away
+ * but leaves it in the edge lists of its neighbours, it gets a
+ * tombstone instead and readers filter it out.  Compaction purges
+ * tombstoned vertices from all edge lists eventually.  Object handles
+ * aren't reused so a tombstone never affects a new vertex. */
+#define RTZ_CPCT_Z	(4096U)
+
+static int
+add_tomb(rotz_t ctx, rtz_vtx_t v)
+{
+/* give V a tombstone of its own and tell readers */
+	unsigned char k[RTZ_TMBKEY_Z];
+	const_buf_t tk = rtz_tmbkey(k, v);
+
+	if (get_children(ctx, tk).z > 0U) {
+		/* already buried */
+		return 0;
+	} else if (UNLIKELY(add_chldlst(ctx, tk, (const_vtxlst_t){1U, &v}) < 0)) {
+		return -1;
+	}
+	return bump_tmbgen(ctx);
+}
+
+static int
+drop_vertex(rotz_t ctx, rtz_vtx_t vid, const char *v, size_t z)
+{
+	rtz_edgkey_t svid = rtz_edgkey(vid);
+	int res = 0;
+
+	if (get_edges(ctx, svid).d != NULL &&
+	    UNLIKELY(rem_edges(ctx, svid) < 0)) {
+		res = -1;
+	}
+	if (UNLIKELY(add_tomb(ctx, vid) < 0)) {
+		res = -1;
+	}
+	if (UNLIKELY(rem_vertex(ctx, vid, v, z) < 0)) {
+		res = -1;
+	}
+	return res;
+}
+
+struct cpct_clo_s {
+	rtz_vtxlst_t tl;
+	rtz_vtxlst_t v;
+	size_t vz;
+};
+
+static int
+cpct_cb(rtz_vtx_t v, const_vtxlst_t el, void *clo)
+{
+/* collect vertices whose edge lists contain tombstoned ones */
+	struct cpct_clo_s *c = clo;
+
+	for (size_t i = 0U; i < el.z; i++) {
+		if (bsearch(el.d + i, c->tl.d, c->tl.z,
+			    sizeof(*c->tl.d), vtx_cmp) == NULL) {
+			continue;
+		}
+		if (UNLIKELY(c->v.z >= c->vz)) {
+			c->vz = (c->vz * 2U) ?: 256U;
+			c->v.d = realloc(c->v.d, c->vz * sizeof(*c->v.d));
+		}
+		c->v.d[c->v.z++] = v;
+		break;
+	}
+	return 0;
+}
+
+/* API */
+rtz_vtx_t
+rotz_drop_vertex(rotz_t ctx, const char *v)
+{
+	/* only commit what we began */
+	const int ownp = !tx_p(ctx);
+	size_t z = strlen(v);
+	rtz_vtx_t res;
+
+	if (UNLIKELY(!(res = get_vertex(ctx, v, z)))) {
+		return 0U;
+	} else if (ownp && UNLIKELY(tx_begin(ctx) < 0)) {
+		return 0U;
+	}
+	if (UNLIKELY(drop_vertex(ctx, res, v, z) < 0)) {
+		res = 0U;
+		if (ownp) {
+			tx_abort(ctx);
+		}
+	} else if (ownp && UNLIKELY(tx_commit(ctx) < 0)) {
+		res = 0U;
+	}
+	return res;
+}
+
+int
+rotz_compact(rotz_t ctx)
+{
+	const int ownp = !tx_p(ctx);
+	struct cpct_clo_s c = {.tl = {0U}};
+	int res = 0;
+
+	if (UNLIKELY(get_tombs_r(ctx, &c.tl) < 0)) {
+		return -1;
+	} else if (c.tl.z == 0U) {
+		/* nothing to do */
+		return 0;
+	}
+	/* find the lists to rewrite, they come in key order */
+	edg_iter(ctx, NULL, NULL, cpct_cb, &c);
+
+	/* rewrite them, in batches if it's up to us */
+	for (size_t i = 0U, n; i < c.v.z && res >= 0; i += n) {
+		n = c.v.z - i < RTZ_CPCT_Z ? c.v.z - i : RTZ_CPCT_Z;
+
+		if (ownp && UNLIKELY(tx_begin(ctx) < 0)) {
+			res = -1;
+			break;
+		}
+		for (size_t j = i; j < i + n; j++) {
+			rtz_edgkey_t sk = rtz_edgkey(c.v.d[j]);
+			const_vtxlst_t el;
+
+			if (UNLIKELY((el = get_edges(ctx, sk)).d == NULL)) {
+				continue;
+			}
+			el = sieve_vtxlst(el, c.tl.d, c.tl.z);
+			if (UNLIKELY(add_vtxlst(ctx, sk, el) < 0)) {
+				res = -1;
+			}
+		}
+		if (ownp && UNLIKELY(tx_commit(ctx) < 0)) {
+			res = -1;
+		}
+	}
+	if (res < 0) {
+		;
+	} else if (ownp && UNLIKELY(tx_begin(ctx) < 0)) {
+		res = -1;
+	} else {
+		/* lay the purged tombstones to rest, others may have been
+		 * added in the meantime but they've got keys of their own */
+		for (size_t i = 0U; i < c.tl.z; i++) {
+			unsigned char k[RTZ_TMBKEY_Z];
+			const_buf_t tmb = rtz_tmbkey(k, c.tl.d[i]);
+
+			if (get_children(ctx, tmb).z > 0U &&
+			    UNLIKELY(add_chldlst(
+					     ctx, tmb, (const_vtxlst_t){0U}) < 0)) {
+				res = -1;
+			}
+		}
+		if (UNLIKELY(bump_tmbgen(ctx) < 0)) {
+			res = -1;
+		}
+		if (ownp && UNLIKELY(tx_commit(ctx) < 0)) {
+			res = -1;
+		}
+	}
+	rotz_free_vtxlst(c.tl);
+	rotz_free_vtxlst(c.v);
+	return res < 0 ? -1 : (int)c.v.z;
+}
+
+
+/* garbage collection
+ * A vertex is garbage if it has no edges other than to tombstoned
+ * vertices.  We mark all vertices that occur in edge lists, as source
+ * or target, and sweep the rest in batches of transactions. */
+#define RTZ_GC_Z	(4096U)
+
+struct gc_clo_s {
+	rtz_vtx_t maxid;
+	unsigned char *live;
+	rtz_vtxlst_t v;
+	size_t vz;
+};
+
+static inline void
+gc_mark(struct gc_clo_s *c, rtz_vtx_t v)
+{
+	if (LIKELY(v <= c->maxid)) {
+		c->live[v / CHAR_BIT] |= (unsigned char)(1U << (v % CHAR_BIT));
+	}
+	return;
+}
+
+static int
+gc_edg_cb(rtz_vtx_t v, const_vtxlst_t el, void *clo)
+{
+	struct gc_clo_s *c = clo;
+
+	gc_mark(c, v);
+	for (size_t i = 0U; i < el.z; i++) {
+		gc_mark(c, el.d[i]);
+	}
+	return 0;
+}
+
+static int
+gc_vtx_cb(rtz_vtx_t v, const char *UNUSED(nm), void *clo)
+{
+	struct gc_clo_s *c = clo;
+
+	if (v > c->maxid ||
+	    c->live[v / CHAR_BIT] & (unsigned char)(1U << (v % CHAR_BIT))) {
+		/* alive and kicking */
+		return 0;
+	}
+	if (UNLIKELY(c->v.z >= c->vz)) {
+		c->vz = (c->vz * 2U) ?: 256U;
+		c->v.d = realloc(c->v.d, c->vz * sizeof(*c->v.d));
+	}
+	c->v.d[c->v.z++] = v;
+	return 0;
+}
+
+/* API */
+int
+rotz_gc(rotz_t ctx)
+{
+	const int ownp = !tx_p(ctx);
+	struct gc_clo_s c = {.maxid = get_maxid(ctx)};
+	size_t ngc = 0U;
+	int res = 0;
+
+	if (UNLIKELY((c.live = calloc(
+			      c.maxid / CHAR_BIT + 1U, sizeof(*c.live))) == NULL)) {
+		return -1;
+	}
+	/* mark, ... */
+	live_edg_iter(ctx, NULL, NULL, gc_edg_cb, &c);
+	/* ... and find the unmarked */
+	rotz_vtx_iter(ctx, gc_vtx_cb, &c);
+	free(c.live);
+
+	/* sweep, in batches if it's up to us */
+	for (size_t i = 0U, n; i < c.v.z && res >= 0; i += n) {
+		n = c.v.z - i < RTZ_GC_Z ? c.v.z - i : RTZ_GC_Z;
+
+		if (ownp && UNLIKELY(tx_begin(ctx) < 0)) {
+			res = -1;
+			break;
+		}
+		for (size_t j = i; j < i + n; j++) {
+			rtz_edgkey_t sk = rtz_edgkey(c.v.d[j]);
+			const_vtxlst_t el;
+
+			if ((el = get_live_edges(ctx, sk)).z > 0U) {
+				/* someone's been quicker */
+				continue;
+			} else if (el.d != NULL &&
+				   UNLIKELY(rem_edges(ctx, sk) < 0)) {
+				/* couldn't drop the tombstones in there */
+				res = -1;
+			} else if (UNLIKELY(gc_vertex(ctx, c.v.d[j]) < 0)) {
+				res = -1;
+			} else {
+				ngc++;
+			}
+		}
+		if (ownp && UNLIKELY(tx_commit(ctx) < 0)) {
+			res = -1;
+		}
+	}
+	rotz_free_vtxlst(c.v);
+	return res < 0 ? -1 : (int)ngc;
+}
+
+int
+rotz_set_autogc(rotz_t ctx, int on)
+{
+	return put_meta(
+		ctx, gckey, sizeof(gckey), (const_buf_t){on ? 1U : 0U, "1"});
+}
+
+
+/* renumbering
+ * Records are moved along the cycles of the permutation, every record
+ * is read before its key is overwritten and only the first record of
+ * a cycle is held back.  Handles not in use are mapped onto the handles
+ * that become free, so that the permutation is complete. */
+struct rnum_rec_s {
+	rtz_vtx_t *e;
+	size_t ez;
+	size_t ecap;
+	char *a;
+	size_t az;
+	size_t acap;
+};
+
+static void
+rnum_load(
+	rotz_t ctx, struct rnum_rec_s *r, rtz_vtx_t v,
+	const rtz_vtx_t *perm, size_t n)
+{
+/* copy V's edges, under their new handles if PERM is given, and names
+ * into R */
+	const_vtxlst_t el = get_edges(ctx, rtz_edgkey(v));
+	const_buf_t al = get_aliases(ctx, rtz_vtxkey(v));
+
+	if (UNLIKELY(el.z > r->ecap)) {
+		r->ecap = ((el.z * sizeof(*el.d) - 1U) / 64U + 1U) * 64U;
+		r->e = realloc(r->e, r->ecap);
+		r->ecap /= sizeof(*el.d);
+	}
+	r->ez = 0U;
+	for (size_t i = 0U; i < el.z; i++) {
+		if (perm == NULL) {
+			r->e[r->ez++] = el.d[i];
+		} else if (LIKELY(el.d[i] < n && perm[el.d[i]])) {
+			/* handles without a new one are dead */
+			r->e[r->ez++] = perm[el.d[i]];
+		}
+	}
+	if (UNLIKELY(al.z > r->acap)) {
+		r->acap = ((al.z - 1U) / 64U + 1U) * 64U;
+		r->a = realloc(r->a, r->acap);
+	}
+	if ((r->az = al.z)) {
+		memcpy(r->a, al.d, al.z);
+	}
+	return;
+}
+
+static int
+rnum_store(rotz_t ctx, const struct rnum_rec_s *r, rtz_vtx_t v, int namesp)
+{
+/* put R under handle V and, if NAMESP, point its names to V */
+	int res = 0;
+
+	if ((r->ez || get_edges(ctx, rtz_edgkey(v)).d != NULL) &&
+	    UNLIKELY(add_vtxlst(
+			     ctx, rtz_edgkey(v),
+			     (const_vtxlst_t){r->ez, r->e}) < 0)) {
+		res = -1;
+	}
+	if ((r->az || get_aliases(ctx, rtz_vtxkey(v)).d != NULL) &&
+	    UNLIKELY(add_akalst(
+			     ctx, rtz_vtxkey(v),
+			     (const_buf_t){r->az, r->a}) < 0)) {
+		res = -1;
+	}
+	for (const char *x = r->a, *const ex = r->a + r->az;
+	     namesp && x < ex;) {
+		size_t z = strlen(x);
+
+		/* put_vertex() won't overwrite everywhere */
+		unput_vertex(ctx, x, z);
+		if (UNLIKELY(put_vertex(ctx, x, z, v) < 0)) {
+			res = -1;
+		}
+		x += z + 1U;
+	}
+	return res;
+}
+
+/* API */
+int
+rotz_renumber(rotz_t ctx, const rtz_vtx_t perm[], size_t n)
+{
+	const int ownp = !tx_p(ctx);
+	struct rnum_rec_s hold = {NULL}, cur = {NULL};
+	rtz_vtx_t maxid;
+	rtz_vtx_t *inv;
+	rtz_vtx_t nlive = 0U;
+	int res = 0;
+
+	/* tombstones would have to be renumbered too, get rid of them */
+	unrsv_ids(ctx);
+	if (UNLIKELY(rotz_compact(ctx) < 0)) {
+		return -1;
+	} else if (!(maxid = get_maxid(ctx))) {
+		return 0;
+	} else if (UNLIKELY((inv = calloc(maxid + 1U, sizeof(*inv))) == NULL)) {
+		return -1;
+	}
+	/* invert PERM, new handles must be unique and in range */
+	for (rtz_vtx_t v = 1U; v < n && v <= maxid; v++) {
+		const rtz_vtx_t w = perm[v];
+
+		if (!w) {
+			continue;
+		} else if (UNLIKELY(w > maxid || inv[w])) {
+			goto out;
+		}
+		inv[w] = v;
+		nlive++;
+	}
+	/* complete the permutation */
+	for (rtz_vtx_t v = 1U, w = 1U; v <= maxid; v++) {
+		if (v < n && perm[v]) {
+			continue;
+		}
+		for (; inv[w]; w++);
+		inv[w] = v;
+	}
+
+	if (ownp && UNLIKELY(tx_begin(ctx) < 0)) {
+		goto out;
+	}
+	/* key K receives the record of old handle INV[K] */
+	for (rtz_vtx_t k = 1U; k <= maxid; k++) {
+		rtz_vtx_t c = k;
+
+		if (!inv[k]) {
+			/* moved already */
+			continue;
+		}
+		rnum_load(ctx, &hold, k, perm, n);
+		for (rtz_vtx_t src; (src = inv[c]) != k; c = src) {
+			rnum_load(ctx, &cur, src, perm, n);
+			res |= rnum_store(ctx, &cur, c, 1);
+			inv[c] = 0U;
+		}
+		res |= rnum_store(ctx, &hold, c, 1);
+		inv[c] = 0U;
+	}
+	/* hand out handles after the live ones from now on */
+	if (nlive < maxid && UNLIKELY(ret_ids(ctx, nlive + 1U, maxid + 1U) < 0)) {
+		res = -1;
+	}
+	/* parents refer to the old handles still */
+	if (UNLIKELY(rotz_reindex(ctx) < 0)) {
+		res = -1;
+	}
+
+	if (!ownp) {
+		;
+	} else if (UNLIKELY(res < 0)) {
+		tx_abort(ctx);
+	} else if (UNLIKELY(tx_commit(ctx) < 0)) {
+		res = -1;
+	}
+	free(hold.e);
+	free(hold.a);
+	free(cur.e);
+	free(cur.a);
+	free(inv);
+	return res < 0 ? -1 : (int)nlive;
+out:
+	free(inv);
+	return -1;
+}
+
+int
+rotz_upgrade(rotz_t ctx)
+{
+/* the old key of handle Y is the new key of handle X and vice versa,
+ * so records are swapped pairwise */
+	const int ownp = !tx_p(ctx);
+	struct rnum_rec_s rx = {NULL}, ry = {NULL};
+	struct rtz_log_s *log = ctx->log;
+	rtz_vtx_t maxid;
+	int res = 0;
+
+	if (rtz_fmt == RTZ_FMT) {
+		/* nothing to do */
+		return 0;
+	} else if (ownp && UNLIKELY(tx_begin(ctx) < 0)) {
+		return -1;
+	}
+	/* keys are different on replicas, they have to upgrade themselves */
+	ctx->log = NULL;
+	maxid = get_maxid(ctx);
+	for (rtz_vtx_t x = 1U; x <= maxid; x++) {
+		const rtz_vtx_t y = htobe_vtx(x);
+
+		if (y == x || y < x) {
+			/* same key or swapped already */
+			continue;
+		}
+		rnum_load(ctx, &rx, x, NULL, 0U);
+		rnum_load(ctx, &ry, y, NULL, 0U);
+		res |= rnum_store(ctx, &rx, y, 0);
+		res |= rnum_store(ctx, &ry, x, 0);
+	}
+	if (UNLIKELY(put_meta(
+			     ctx, fmtkey, sizeof(fmtkey),
+			     (const_buf_t){sizeof(fmtstamp), fmtstamp}) < 0)) {
+		res = -1;
+	}
+	ctx->log = log;
+	/* followers must have upgraded before they go on */
+	log_rec(ctx, RTZ_LOG_FMT, NULL, 0U, fmtstamp, sizeof(fmtstamp));
+
+	if (!ownp) {
+		;
+	} else if (UNLIKELY(res < 0)) {
+		tx_abort(ctx);
+	} else if (UNLIKELY(tx_commit(ctx) < 0)) {
+		res = -1;
+	}
+	if (res >= 0) {
+		rtz_fmt = RTZ_FMT;
+	}
+	free(rx.e);
+	free(rx.a);
+	free(ry.e);
+	free(ry.a);
+	return res < 0 ? -1 : 1;
+}
+
+
+/* parent accessors
+ * We maintain PARKEY -> CHILD(ren) where PARKEY is the parent portion
+ * of a parameterised name, i.e. `sector' for `sector:energy', prefixed
+ * by RTZ_PARPRE and CHILD(ren) is the list of vertices with a name
+ * (or alias) under that parent. */
+static rtz_parkey_t
+rtz_parkey(const char *par, size_t pz)
+{
+	static __thread char *pk;
+	static __thread size_t pkz;
+
+	if (UNLIKELY(sizeof(RTZ_PARPRE) + pz > pkz)) {
+		pkz = ((sizeof(RTZ_PARPRE) + pz) / 64U + 1U) * 64U;
+		pk = realloc(pk, pkz);
+	}
+	memcpy(pk, RTZ_PARPRE, sizeof(RTZ_PARPRE));
+	memcpy(pk + sizeof(RTZ_PARPRE), par, pz);
+	return (rtz_parkey_t){.z = sizeof(RTZ_PARPRE) + pz, .d = pk};
+}
+
+static int
+add_parent(rotz_t cp, const char *v, size_t z, rtz_vtx_t vid)
+{
+	rtz_parkey_t pk;
+	const_vtxlst_t el;
+
+	if (!(z = parent_z(v, z))) {
+		/* not parameterised */
+		return 0;
+	}
+	pk = rtz_parkey(v, z);
+	if ((el = get_children(cp, pk)).d != NULL &&
+	    rtz_find_in_vtxlst(el, vid) > 0U) {
+		/* already in there */
+		return 0;
+	}
+	return add_child(cp, pk, vid);
+}
+
+static int
+rem_parent(rotz_t cp, const char *v, size_t z, rtz_vtx_t vid)
+{
+	rtz_parkey_t pk;
+	const_vtxlst_t el;
+	size_t idx;
+
+	if (!(z = parent_z(v, z))) {
+		/* not parameterised */
+		return 0;
+	}
+	pk = rtz_parkey(v, z);
+	if ((el = get_children(cp, pk)).d == NULL ||
+	    (idx = rtz_find_in_vtxlst(el, vid)) == 0U) {
+		/* not in there */
+		return 0;
+	}
+	el = rem_from_vtxlst(el, idx);
+	return add_chldlst(cp, pk, el);
+}
+
+struct kcur_s {
+	const rtz_vtx_t *p;
+	const rtz_vtx_t *ep;
+};
+
+static void
+kcur_sift(struct kcur_s *h, size_t n, size_t i)
+{
+/* restore the min-heap property of H below I */
+	for (size_t c; (c = 2U * i + 1U) < n; i = c) {
+		if (c + 1U < n && *h[c + 1U].p < *h[c].p) {
+			c++;
+		}
+		if (*h[i].p <= *h[c].p) {
+			break;
+		}
+		with (struct kcur_s tmp = h[i]) {
+			h[i] = h[c];
+			h[c] = tmp;
+		}
+	}
+	return;
+}
+
+/* API */
+rtz_vtxlst_t
+rotz_get_children(rotz_t ctx, const char *parent)
+{
+	rtz_parkey_t pk = rtz_parkey(parent, strlen(parent));
+	const_vtxlst_t el;
+	rtz_vtx_t *d;
+
+	if (UNLIKELY((el = get_children(ctx, pk)).d == NULL)) {
+		return (rtz_vtxlst_t){0U};
+	}
+	/* otherwise make a copy */
+	{
+		size_t mz = el.z * sizeof(*d);
+		d = malloc(mz);
+		memcpy(d, el.d, mz);
+	}
+	return (rtz_vtxlst_t){.z = el.z, .d = d};
+}
+
+rtz_vtxlst_t
+rotz_rollup(rotz_t ctx, const char *parent)
+{
+	rtz_vtxlst_t ch;
+	rtz_vtxlst_t all = {0U};
+	rtz_vtxlst_t res = {0U};
+	size_t allz = 0U;
+	size_t *o;
+	struct kcur_s *h;
+	size_t nh = 0U;
+
+	if ((ch = rotz_get_children(ctx, parent)).d == NULL) {
+		return res;
+	} else if (UNLIKELY((o = malloc((ch.z + 1U) * sizeof(*o))) == NULL)) {
+		goto out;
+	}
+	/* collect all edge lists back to back, each one sorted */
+	o[0U] = 0U;
+	for (size_t i = 0U; i < ch.z; i++) {
+		const_vtxlst_t el = get_live_edges(ctx, rtz_edgkey(ch.d[i]));
+
+		if (UNLIKELY(all.z + el.z > allz)) {
+			allz = ((all.z + el.z) / 64U + 1U) * 64U;
+			all.d = realloc(all.d, allz * sizeof(*all.d));
+		}
+		if (el.z) {
+			memcpy(all.d + all.z, el.d, el.z * sizeof(*el.d));
+			qsort(all.d + all.z, el.z, sizeof(*all.d), vtx_cmp);
+		}
+		o[i + 1U] = all.z += el.z;
+	}
+	if (UNLIKELY(all.z == 0U)) {
+		goto out;
+	}
+	/* k-way merge them, dropping duplicates */
+	h = malloc(ch.z * sizeof(*h));
+	for (size_t i = 0U; i < ch.z; i++) {
+		if (o[i] < o[i + 1U]) {
+			h[nh++] = (struct kcur_s){all.d + o[i], all.d + o[i + 1U]};
+		}
+	}
+	for (size_t i = nh / 2U; i-- > 0U;) {
+		kcur_sift(h, nh, i);
+	}
+	res.d = malloc(all.z * sizeof(*res.d));
+	res.z = 0U;
+	while (nh > 0U) {
+		rtz_vtx_t v = *h->p;
+
+		if (!res.z || res.d[res.z - 1U] != v) {
+			res.d[res.z++] = v;
+		}
+		if (++h->p >= h->ep) {
+			/* cursor exhausted */
+			*h = h[--nh];
+		}
+		kcur_sift(h, nh, 0U);
+	}
+	free(h);
+out:
+	free(o);
+	rotz_free_vtxlst(all);
+	rotz_free_vtxlst(ch);
+	return res;
+}
+
+static int
+reidx_par_cb(const_buf_t key, const_buf_t UNUSED(val), void *clo)
+{
+	rtz_buf_t *b = clo;
+
+	/* remember the key, length-prefixed */
+	with (size_t nu = b->z + sizeof(key.z) + key.z) {
+		b->d = realloc(b->d, (nu / 4096U + 1U) * 4096U);
+		memcpy(b->d + b->z, &key.z, sizeof(key.z));
+		memcpy(b->d + b->z + sizeof(key.z), key.d, key.z);
+		b->z = nu;
+	}
+	return 0;
+}
+
+static int
+reidx_vtx_cb(const_buf_t key, const_buf_t val, void *clo)
+{
+	rtz_buf_t *b = clo;
+
+	if (UNLIKELY(key.z != RTZ_VTXKEY_Z)) {
+		return 0;
+	}
+	/* remember the vertex and its alias list */
+	with (rtz_vtx_t v = rtz_vtx((rtz_vtxkey_t)key.d)) {
+		size_t nu = b->z + sizeof(v) + sizeof(val.z) + val.z;
+
+		b->d = realloc(b->d, (nu / 4096U + 1U) * 4096U);
+		memcpy(b->d + b->z, &v, sizeof(v));
+		memcpy(b->d + b->z + sizeof(v), &val.z, sizeof(val.z));
+		memcpy(b->d + b->z + sizeof(v) + sizeof(val.z), val.d, val.z);
+		b->z = nu;
+	}
+	return 0;
+}
+
+int
+rotz_reindex(rotz_t ctx)
+{
+	static const char parpre[] = RTZ_PARPRE;
+	static const char vtxpre[] = RTZ_VTXPRE;
+	rtz_buf_t b = {0U};
+	int res = 0;
+
+	/* collect and wipe all children lists */
+	rotz_iter(ctx, (const_buf_t){sizeof(parpre), parpre}, reidx_par_cb, &b);
+	for (const char *x = b.d, *const ex = b.d + b.z; x < ex;) {
+		rtz_parkey_t pk;
+
+		memcpy(&pk.z, x, sizeof(pk.z));
+		pk.d = x + sizeof(pk.z);
+		res += add_chldlst(ctx, pk, (const_vtxlst_t){0U});
+		x = pk.d + pk.z;
+	}
+	rotz_free_r(b);
+
+	/* now go through all vertices and their names */
+	b = (rtz_buf_t){0U};
+	rotz_iter(ctx, (const_buf_t){sizeof(vtxpre), vtxpre}, reidx_vtx_cb, &b);
+	for (const char *x = b.d, *const ex = b.d + b.z; x < ex;) {
+		rtz_vtx_t v;
+		const_buf_t al;
+
+		memcpy(&v, x, sizeof(v));
+		memcpy(&al.z, x + sizeof(v), sizeof(al.z));
+		al.d = x + sizeof(v) + sizeof(al.z);
+		for (const char *y = al.d, *const ey = al.d + al.z; y < ey;) {
+			size_t z = strlen(y);
+
+			res += add_parent(ctx, y, z, v);
+			y += z + 1U;
+		}
+		x = al.d + al.z;
+	}
+	rotz_free_r(b);
+	return res;
+}
+
+
+/* binary exchange
+ * The stream starts with the magic string and two integers, the format
+ * version and the largest object handle handed out so far.
+ * Then come the vertices, each one as its handle, the size of its name
+ * list and the name list itself, i.e. \nul-terminated names with the
+ * canonical name first.
+ * Then come the adjacency lists, each one as a handle, the number of
+ * edges and the edges themselves.
+ * Both sections are terminated by a handle of 0 and all integers are
+ * little-endian.  The format version is 32 bits, sizes and counts are
+ * 32 bits, handles are 32 bits in version 1 and 64 bits in version 2,
+ * which is what builds with wide handles write.  Both versions can be
+ * read by either kind of build. */
+#define RTZ_XCHG_MAGIC	"rotz"
+#if defined WITH_WIDE_IDS
+# define RTZ_XCHG_VER	(2U)
+#else  /* !WITH_WIDE_IDS */
+# define RTZ_XCHG_VER	(1U)
+#endif	/* WITH_WIDE_IDS */
+#define RTZ_XCHG_Z	(1U << 18U)
+
+struct xout_s {
+	int fd;
+	int err;
+	size_t n;
+	char *d;
+};
+
+static void
+xout_flush(struct xout_s *o)
+{
+	for (const char *p = o->d, *const ep = o->d + o->n;
+	     p < ep && !o->err;) {
+		ssize_t nwr = write(o->fd, p, ep - p);
+
+		if (UNLIKELY(nwr < 0 && errno == EINTR)) {
+			continue;
+		} else if (UNLIKELY(nwr <= 0)) {
+			o->err = 1;
+			break;
+		}
+		p += nwr;
+	}
+	o->n = 0U;
+	return;
+}
+
+static void
+xout_buf(struct xout_s *o, const void *s, size_t z)
+{
+	while (UNLIKELY(o->n + z > RTZ_XCHG_Z)) {
+		size_t k = RTZ_XCHG_Z - o->n;
+
+		memcpy(o->d + o->n, s, k);
+		o->n += k;
+		xout_flush(o);
+		s = (const char*)s + k;
+		z -= k;
+	}
+	memcpy(o->d + o->n, s, z);
+	o->n += z;
+	return;
+}
+
+static void
+xout_u32(struct xout_s *o, uint32_t x)
+{
+	x = htole32(x);
+	xout_buf(o, &x, sizeof(x));
+	return;
+}
+
+static void
+xout_id(struct xout_s *o, rtz_vtx_t x)
+{
+#if defined WITH_WIDE_IDS
+	x = htole64(x);
+#else  /* !WITH_WIDE_IDS */
+	x = htole32(x);
+#endif	/* WITH_WIDE_IDS */
+	xout_buf(o, &x, sizeof(x));
+	return;
+}
+
+static int
+xprt_vtx_cb(const_buf_t k, const_buf_t v, void *clo)
+{
+	if (UNLIKELY(k.z != RTZ_VTXKEY_Z)) {
+		return 0;
+	}
+	xout_id(clo, rtz_vtx((rtz_vtxkey_t)k.d));
+	xout_u32(clo, v.z);
+	xout_buf(clo, v.d, v.z);
+	return 0;
+}
+
+static int
+xprt_edg_cb(rtz_vtx_t v, const_vtxlst_t el, void *clo)
+{
+	if (UNLIKELY(el.z == 0U)) {
+		return 0;
+	}
+	xout_id(clo, v);
+	xout_u32(clo, el.z);
+#if BYTE_ORDER == LITTLE_ENDIAN
+	xout_buf(clo, el.d, el.z * sizeof(*el.d));
+#else  /* !LITTLE_ENDIAN */
+	for (size_t i = 0U; i < el.z; i++) {
+		xout_id(clo, el.d[i]);
+	}
+#endif	/* LITTLE_ENDIAN */
+	return 0;
+}
+
+int
+rotz_export_binary(rotz_t ctx, int fd)
+{
+	static const char vtxpre[] = RTZ_VTXPRE;
+	struct xout_s o = {.fd = fd};
+
+	if (UNLIKELY((o.d = malloc(RTZ_XCHG_Z)) == NULL)) {
+		return -1;
+	}
+	xout_buf(&o, RTZ_XCHG_MAGIC, sizeof(RTZ_XCHG_MAGIC) - 1U);
+	xout_u32(&o, RTZ_XCHG_VER);
+	xout_id(&o, rotz_get_maxid(ctx));
+
+	rotz_iter(ctx, (const_buf_t){sizeof(vtxpre), vtxpre}, xprt_vtx_cb, &o);
+	xout_id(&o, 0U);
+	/* tombstoned vertices are gone from the names, leave them out of
+	 * the edge lists too */
+	if (UNLIKELY(live_edg_iter(ctx, NULL, NULL, xprt_edg_cb, &o) < 0)) {
+		o.err = 1;
+	}
+	xout_id(&o, 0U);
+
+	xout_flush(&o);
+	free(o.d);
+	return -o.err;
+}
+
+static const char*
+xin_u32(const char *p, const char *ep, uint32_t *x)
+{
+	if (UNLIKELY(p == NULL || p + sizeof(*x) > ep)) {
+		return NULL;
+	}
+	memcpy(x, p, sizeof(*x));
+	*x = le32toh(*x);
+	return p + sizeof(*x);
+}
+
+static inline uint32_t
+xget_u32(const char **p)
+{
+/* like xin_u32() but for streams that have been checked already */
+	uint32_t x;
+
+	memcpy(&x, *p, sizeof(x));
+	*p += sizeof(x);
+	return le32toh(x);
+}
+
+static inline uint64_t
+xget_id(const char **p, size_t iw)
+{
+/* like xget_u32() but for handles of IW bytes */
+	if (iw == sizeof(uint64_t)) {
+		uint64_t x;
+
+		memcpy(&x, *p, sizeof(x));
+		*p += sizeof(x);
+		return le64toh(x);
+	}
+	return xget_u32(p);
+}
+
+static const char*
+xin_id(const char *p, const char *ep, size_t iw, uint64_t *x)
+{
+	if (UNLIKELY(p == NULL || p + iw > ep)) {
+		return NULL;
+	}
+	*x = xget_id(&p, iw);
+	return p;
+}
+
+struct xpar_s {
+	const_buf_t p;
+	rtz_vtx_t v;
+};
+
+static int
+xpar_cmp_p(const struct xpar_s *px, const struct xpar_s *py)
+{
+	size_t z = px->p.z < py->p.z ? px->p.z : py->p.z;
+	int res;
+
+	if ((res = memcmp(px->p.d, py->p.d, z))) {
+		return res;
+	}
+	return (px->p.z > py->p.z) - (px->p.z < py->p.z);
+}
+
+static int
+xpar_cmp(const void *x, const void *y)
+{
+/* order by parent name, then by vertex */
+	const struct xpar_s *px = x;
+	const struct xpar_s *py = y;
+	int res;
+
+	if ((res = xpar_cmp_p(px, py))) {
+		return res;
+	}
+	return (px->v > py->v) - (px->v < py->v);
+}
+
+int
+rotz_import_binary(rotz_t ctx, const void *buf, size_t bsz)
+{
+	static const char nid[] = "\x1d";
+	const char *const ep = (const char*)buf + bsz;
+	const char *bp = buf;
+	const char *sp;
+	const char *xp;
+	uint32_t ver;
+	uint64_t maxid;
+	/* width of the handles in BUF, and whether edges can be used in place */
+	size_t iw;
+	int inplace = 0;
+	/* number of vertices, names, adjacency lists, edges, parents */
+	size_t nv = 0U, nn = 0U, nl = 0U, ne = 0U, np = 0U;
+	/* bytes needed for the keys not in BUF */
+	size_t kz;
+	/* the key/value pairs, K is sorted and indexes V */
+	struct kidx_s *k = NULL;
+	const_buf_t *v = NULL;
+	size_t nkv;
+	/* storage for keys and values that aren't in BUF */
+	unsigned char *ka = NULL;
+	rtz_vtx_t *va = NULL;
+	struct xpar_s *pa = NULL;
+	int res = -1;
+
+	if (UNLIKELY(bsz < sizeof(RTZ_XCHG_MAGIC) - 1U) ||
+	    UNLIKELY(memcmp(bp, RTZ_XCHG_MAGIC, sizeof(RTZ_XCHG_MAGIC) - 1U))) {
+		return -1;
+	}
+	bp += sizeof(RTZ_XCHG_MAGIC) - 1U;
+	if (UNLIKELY((bp = xin_u32(bp, ep, &ver)) == NULL)) {
+		return -1;
+	}
+	switch (ver) {
+	case 1U:
+		iw = sizeof(uint32_t);
+		break;
+	case 2U:
+		iw = sizeof(uint64_t);
+		break;
+	default:
+		return -1;
+	}
+	bp = xin_id(bp, ep, iw, &maxid);
+	if (UNLIKELY(bp == NULL || (rtz_vtx_t)maxid != maxid)) {
+		/* or too many handles for us */
+		return -1;
+	} else if (UNLIKELY(get_maxid(ctx) > 0U)) {
+		/* only load into empty databases */
+		return -1;
+	}
+
+	/* first pass, count things and check the bounds */
+	sp = bp;
+	kz = 0U;
+	for (uint64_t id;;) {
+		uint32_t z;
+
+		if (UNLIKELY((bp = xin_id(bp, ep, iw, &id)) == NULL)) {
+			return -1;
+		} else if (id == 0U) {
+			break;
+		} else if (UNLIKELY(id > maxid) ||
+			   UNLIKELY((bp = xin_u32(bp, ep, &z)) == NULL) ||
+			   UNLIKELY(z == 0U || z > (size_t)(ep - bp)) ||
+			   UNLIKELY(bp[z - 1U] != '\0')) {
+			return -1;
+		}
+		for (const char *x = bp, *const ex = bp + z; x < ex; nn++) {
+			size_t xz = strlen(x);
+			size_t pz;
+
+			if (UNLIKELY(xz == 0U)) {
+				return -1;
+			} else if ((pz = parent_z(x, xz))) {
+				kz += sizeof(RTZ_PARPRE) + pz;
+				np++;
+			}
+			x += xz + 1U;
+		}
+		bp += z;
+		nv++;
+	}
+	for (xp = bp;;) {
+		uint64_t id;
+		uint32_t z;
+
+		if (UNLIKELY((bp = xin_id(bp, ep, iw, &id)) == NULL)) {
+			return -1;
+		} else if (id == 0U) {
+			break;
+		} else if (UNLIKELY(id > maxid) ||
+			   UNLIKELY((bp = xin_u32(bp, ep, &z)) == NULL) ||
+			   UNLIKELY(z > (size_t)(ep - bp) / iw)) {
+			return -1;
+		}
+		for (const char *const ex = bp + z * iw; bp < ex;) {
+			/* targets must be handles we know, checked at full
+			 * width before narrow builds get to truncate them */
+			const uint64_t to = xget_id(&bp, iw);
+
+			if (UNLIKELY(to == 0U || to > maxid)) {
+				return -1;
+			}
+		}
+		ne += z;
+		nl += z > 0U;
+	}
+	kz += nv * RTZ_VTXKEY_Z + nl * RTZ_EDGKEY_Z;
+
+	/* one key per vertex, name, list and parent, plus the counter */
+	nkv = nv + nn + nl + np + 1U;
+	k = malloc(nkv * sizeof(*k));
+	v = malloc(nkv * sizeof(*v));
+	ka = malloc(kz + 1U);
+#if BYTE_ORDER == LITTLE_ENDIAN
+	/* edges are used in place if they're as wide as ours */
+	if ((inplace = iw == sizeof(rtz_vtx_t))) {
+		ne = 0U;
+	}
+#endif	/* LITTLE_ENDIAN */
+	va = malloc((nv + ne + np + 1U) * sizeof(*va));
+	pa = malloc((np + 1U) * sizeof(*pa));
+	if (UNLIKELY(k == NULL || v == NULL || ka == NULL ||
+		     va == NULL || pa == NULL)) {
+		goto out;
+	}
+
+#define KV(key, val)	(k[nkv] = (struct kidx_s){key, nkv}, v[nkv++] = val)
+	/* second pass, generate the keys and values */
+	nkv = 0U;
+	np = 0U;
+	{
+		unsigned char *kp = ka;
+		rtz_vtx_t *vap = va;
+
+		for (rtz_vtx_t id; (id = xget_id(&sp, iw));) {
+			const size_t z = xget_u32(&sp);
+			const char *lp = sp;
+
+			sp += z;
+
+			/* VTXKEY -> NAME(s) */
+			memcpy(kp, rtz_vtxkey(id), RTZ_VTXKEY_Z);
+			KV(((const_buf_t){RTZ_VTXKEY_Z, (void*)kp}),
+			   ((const_buf_t){z, lp}));
+			kp += RTZ_VTXKEY_Z;
+
+			/* NAME -> ID, for every name */
+			*vap = id;
+			for (const char *x = lp, *const ex = lp + z; x < ex;) {
+				size_t xz = strlen(x);
+				size_t pz;
+
+				KV(((const_buf_t){xz, x}),
+				   ((const_buf_t){sizeof(*vap), (void*)vap}));
+				if ((pz = parent_z(x, xz))) {
+					pa[np++] = (struct xpar_s){{pz, x}, id};
+				}
+				x += xz + 1U;
+			}
+			vap++;
+		}
+		for (rtz_vtx_t id; (id = xget_id(&xp, iw));) {
+			const size_t z = xget_u32(&xp);
+			const char *lp = xp;
+			const_buf_t el;
+
+			xp += z * iw;
+			if (UNLIKELY(z == 0U)) {
+				continue;
+			} else if (inplace) {
+				el = (const_buf_t){z * sizeof(*vap), lp};
+			} else {
+				el = (const_buf_t){z * sizeof(*vap), (void*)vap};
+				for (const char *x = lp; x < xp;) {
+					*vap++ = xget_id(&x, iw);
+				}
+			}
+			/* EDGKEY -> LIST */
+			memcpy(kp, rtz_edgkey(id), RTZ_EDGKEY_Z);
+			KV(((const_buf_t){RTZ_EDGKEY_Z, (void*)kp}), el);
+			kp += RTZ_EDGKEY_Z;
+		}
+
+		/* PARKEY -> CHILDREN, group the names by parent */
+		qsort(pa, np, sizeof(*pa), xpar_cmp);
+		for (size_t i = 0U, j; i < np; i = j) {
+			rtz_parkey_t pk = rtz_parkey(pa[i].p.d, pa[i].p.z);
+			rtz_vtx_t *el = vap;
+
+			for (j = i; j < np && !xpar_cmp_p(pa + i, pa + j); j++) {
+				if (vap == el || vap[-1] != pa[j].v) {
+					*vap++ = pa[j].v;
+				}
+			}
+			memcpy(kp, pk.d, pk.z);
+			KV(((const_buf_t){pk.z, (void*)kp}),
+			   ((const_buf_t){(vap - el) * sizeof(*el), (void*)el}));
+			kp += pk.z;
+		}
+
+		/* and the id counter */
+		*vap = maxid;
+		KV(((const_buf_t){sizeof(nid), nid}),
+		   ((const_buf_t){sizeof(*vap), (void*)vap}));
+	}
+#undef KV
+
+	/* sort the keys like the database does */
+	qsort(k, nkv, sizeof(*k), kidx_cmp);
+	for (size_t i = 1U; i < nkv; i++) {
+		if (UNLIKELY(!kidx_cmp(k + i - 1U, k + i))) {
+			/* a name is used twice */
+			goto out;
+		}
+	}
+	/* line up keys and values in key order */
+	with (const_buf_t *sk = malloc(2U * nkv * sizeof(*sk))) {
+		const_buf_t *sv = sk + nkv;
+
+		if (UNLIKELY(sk == NULL)) {
+			goto out;
+		}
+		for (size_t i = 0U; i < nkv; i++) {
+			sk[i] = k[i].k;
+			sv[i] = v[k[i].i];
+		}
+		res = put_sorted(ctx, sk, sv, nkv);
+		free(sk);
+	}
+out:
+	free(k);
+	free(v);
+	free(ka);
+	free(va);
+	free(pa);
+	return res;
+}
+
+
+/* transactions */
+int
+rotz_begin(rotz_t ctx)
+{
+	return tx_begin(ctx);
+}
+
+int
+rotz_commit(rotz_t ctx)
+{
+	return tx_commit(ctx);
+}
+
+void
+rotz_abort(rotz_t ctx)
+{
+	tx_abort(ctx);
+	return;
+}
+
+int
+rotz_begin_read(rotz_t ctx)
+{
+	return rd_begin(ctx);
+}
+
+void
+rotz_end_read(rotz_t ctx)
+{
+	rd_end(ctx);
+	return;
+}
+
+
+
+/* change log
+ * Writers append one record per call to a write primitive, i.e.
+ *
+ *   Z OP SEQ AZ A B Z
+ *
+ * where Z is the size of the whole record, OP the primitive, SEQ the
+ * record's sequence number and A and B the key and value passed to the
+ * primitive, AZ being the size of A.  SEQ is 64-bit, the other integers
+ * are 32-bit, all of them little-endian.  Repeating Z at the end allows
+ * to find the last sequence number from the end of the file.
+ * Followers replay the records against the same primitives.
+ * Keys are passed on as they are, so a log starts with a record that
+ * carries the key format, as does every switch to the new format.
+ * The sequence number of the last record is committed to the database
+ * along with the writes, a log whose last record doesn't match the
+ * database lost records to a crash or a failed append, writers then
+ * refuse to add to it until the change log is set anew. */
+#define RTZ_LOG_HDR_Z	(20U)
+#define RTZ_LOG_REC_Z	(RTZ_LOG_HDR_Z + 4U)
+#define RTZ_LOG_BUF_Z	(1U << 16U)
+
+/* Records are queued until the writes they describe are committed and
+ * dropped if those are rolled back.  Outside of transactions that's
+ * after every write primitive, otherwise upon commit.  Sequence numbers
+ * are assigned when the queue is appended, under the log's lock, which
+ * is held only across the database commit and the append. */
+struct rtz_log_s {
+	int fd;
+	int lckd;
+	/* set when a record couldn't be queued */
+	int oom;
+	/* set when the log and the database are out of step */
+	int broken;
+	/* what the last queued record's sequence number will be, LE */
+	uint64_t mark;
+	size_t n;
+	size_t z;
+	char *buf;
+};
+
+/* the change log's file name and a follower's position */
+static const char logkey[] = "\x1dlog";
+static const char poskey[] = "\x1dpos";
+
+static int
+log_put(int fd, const char *p, size_t z)
+{
+	while (z > 0U) {
+		ssize_t nwr = write(fd, p, z);
+
+		if (UNLIKELY(nwr < 0 && errno == EINTR)) {
+			continue;
+		} else if (UNLIKELY(nwr <= 0)) {
+			return -1;
+		}
+		p += nwr;
+		z -= nwr;
+	}
+	return 0;
+}
+
+static int
+log_last_seq(int fd, off_t sz, uint64_t *seq)
+{
+/* find the sequence number of the last record in a log of SZ bytes */
+	uint32_t z;
+	uint64_t x;
+
+	if (sz == 0) {
+		*seq = 0U;
+		return 0;
+	} else if (UNLIKELY(sz < (off_t)RTZ_LOG_REC_Z) ||
+		   UNLIKELY(pread(fd, &z, sizeof(z), sz - 4) < 4) ||
+		   UNLIKELY((z = le32toh(z)) < RTZ_LOG_REC_Z) ||
+		   UNLIKELY(z > sz) ||
+		   UNLIKELY(pread(fd, &x, sizeof(x), sz - z + 8) < 8)) {
+		/* torn log */
+		return -1;
+	}
+	*seq = le64toh(x);
+	return 0;
+}
+
+static void
+log_rec(
+	rotz_t ctx, unsigned int op,
+	const void *a, size_t az, const void *b, size_t bz)
+{
+/* queue a record, sequence numbers are filled in by log_write() */
+	struct rtz_log_s *l = ctx->log;
+	const uint32_t z = htole32(RTZ_LOG_REC_Z + az + bz);
+	char hdr[RTZ_LOG_HDR_Z] = {0};
+
+	if (LIKELY(l == NULL) || UNLIKELY(l->oom)) {
+		return;
+	}
+	with (uint32_t x = htole32(op)) {
+		memcpy(hdr + 0U, &z, sizeof(z));
+		memcpy(hdr + 4U, &x, sizeof(x));
+	}
+	with (uint32_t x = htole32(az)) {
+		memcpy(hdr + 16U, &x, sizeof(x));
+	}
+
+	if (UNLIKELY(l->n + RTZ_LOG_REC_Z + az + bz > l->z)) {
+		size_t nz = l->z ?: RTZ_LOG_BUF_Z;
+		char *nu;
+
+		while (nz < l->n + RTZ_LOG_REC_Z + az + bz) {
+			nz *= 2U;
+		}
+		if (UNLIKELY((nu = realloc(l->buf, nz)) == NULL)) {
+			/* the log is out of step now, make log_write() fail */
+			l->oom = 1;
+			return;
+		}
+		l->buf = nu;
+		l->z = nz;
+	}
+	memcpy(l->buf + l->n, hdr, sizeof(hdr));
+	l->n += sizeof(hdr);
+	if (az) {
+		memcpy(l->buf + l->n, a, az);
+		l->n += az;
+	}
+	if (bz) {
+		memcpy(l->buf + l->n, b, bz);
+		l->n += bz;
+	}
+	memcpy(l->buf + l->n, &z, sizeof(z));
+	l->n += sizeof(z);
+	return;
+}
+
+static int
+log_tail(const struct rtz_log_s *l, off_t *sz, uint64_t *seq)
+{
+/* find the size of L's file and the sequence number of its last record */
+	if (UNLIKELY((*sz = lseek(l->fd, 0, SEEK_END)) < 0) ||
+	    UNLIKELY(log_last_seq(l->fd, *sz, seq) < 0)) {
+		return -1;
+	}
+	return 0;
+}
+
+static int
+log_lock(rotz_t ctx)
+{
+/* to be held across the database commit and log_write(),
+ * also works out the mark to be committed with the database */
+	struct rtz_log_s *l = ctx->log;
+	uint64_t seq;
+	off_t sz;
+
+	if (LIKELY(l == NULL) || l->lckd) {
+		return 0;
+	} else if (UNLIKELY(l->broken || l->oom)) {
+		/* records would go missing */
+		return -1;
+	} else if (UNLIKELY(flock(l->fd, LOCK_EX) < 0)) {
+		return -1;
+	}
+	l->lckd = 1;
+	if (l->n == 0U) {
+		/* nothing to mark */
+		return 0;
+	} else if (UNLIKELY(log_tail(l, &sz, &seq) < 0)) {
+		return -1;
+	}
+	/* new logs start with the key format */
+	seq += sz == 0;
+	for (const char *p = l->buf, *const ep = p + l->n; p < ep; seq++) {
+		uint32_t z;
+
+		memcpy(&z, p, sizeof(z));
+		p += le32toh(z);
+	}
+	l->mark = htole64(seq);
+	return 0;
+}
+
+static const_buf_t
+log_mark(rotz_t ctx)
+{
+/* the value for SEQKEY, if anything is to be logged */
+	const struct rtz_log_s *l = ctx->log;
+
+	if (LIKELY(l == NULL) || !l->lckd || l->n == 0U) {
+		return (const_buf_t){0U};
+	}
+	return (const_buf_t){sizeof(l->mark), (const void*)&l->mark};
+}
+
+static void
+log_drop(rotz_t ctx)
+{
+/* forget about the queued records, they've been rolled back */
+	struct rtz_log_s *l = ctx->log;
+
+	if (LIKELY(l == NULL)) {
+		return;
+	}
+	l->n = 0U;
+	l->oom = 0;
+	if (l->lckd) {
+		flock(l->fd, LOCK_UN);
+		l->lckd = 0;
+	}
+	return;
+}
+
+static int
+log_write(rotz_t ctx, int syncp)
+{
+/* append the queued records, their writes are committed */
+	struct rtz_log_s *l = ctx->log;
+	uint64_t seq;
+	off_t sz;
+	int res = 0;
+
+	if (LIKELY(l == NULL)) {
+		return 0;
+	} else if (UNLIKELY(l->oom)) {
+		res = -1;
+		goto out;
+	} else if (l->n == 0U) {
+		/* nothing to add, make earlier records durable though */
+		if (syncp && UNLIKELY(fdatasync(l->fd) < 0)) {
+			res = -1;
+		}
+		goto out;
+	} else if (UNLIKELY(!l->lckd && log_lock(ctx) < 0)) {
+		res = -1;
+		goto out;
+	} else if (UNLIKELY(log_tail(l, &sz, &seq) < 0)) {
+		res = -1;
+		goto out;
+	}
+	if (sz == 0) {
+		/* new log, state the key format first */
+		const unsigned char f = (unsigned char)rtz_fmt;
+		const uint32_t z = htole32(RTZ_LOG_REC_Z + sizeof(f));
+		char fr[RTZ_LOG_REC_Z + sizeof(f)] = {0};
+
+		with (uint32_t x = htole32(RTZ_LOG_FMT)) {
+			memcpy(fr + 0U, &z, sizeof(z));
+			memcpy(fr + 4U, &x, sizeof(x));
+		}
+		with (uint64_t x = htole64(++seq)) {
+			memcpy(fr + 8U, &x, sizeof(x));
+		}
+		fr[RTZ_LOG_HDR_Z] = f;
+		memcpy(fr + RTZ_LOG_HDR_Z + sizeof(f), &z, sizeof(z));
+		if (UNLIKELY(log_put(l->fd, fr, sizeof(fr)) < 0)) {
+			(void)ftruncate(l->fd, sz);
+			res = -1;
+			goto out;
+		}
+	}
+	/* number the records */
+	for (char *p = l->buf, *const ep = p + l->n; p < ep;) {
+		uint32_t z;
+
+		memcpy(&z, p, sizeof(z));
+		with (uint64_t x = htole64(++seq)) {
+			memcpy(p + 8U, &x, sizeof(x));
+		}
+		p += le32toh(z);
+	}
+	if (UNLIKELY(log_put(l->fd, l->buf, l->n) < 0)) {
+		/* don't leave a torn record behind */
+		(void)ftruncate(l->fd, sz);
+		res = -1;
+	} else if (syncp && UNLIKELY(fdatasync(l->fd) < 0)) {
+		res = -1;
+	}
+out:
+	if (UNLIKELY(res < 0) && (l->n > 0U || l->oom)) {
+		/* committed writes went unlogged */
+		l->broken = 1;
+	}
+	log_drop(ctx);
+	return res;
+}
+
+static int
+open_log(rotz_t ctx)
+{
+	const_buf_t fn = get_meta(ctx, logkey, sizeof(logkey));
+	struct rtz_log_s *l;
+	uint64_t seq;
+	off_t sz;
+	int fd;
+
+	ctx->log = NULL;
+	if (fn.z == 0U) {
+		/* no change log, fine */
+		return 0;
+	} else if (UNLIKELY(fn.d[fn.z - 1U] != '\0')) {
+		return -1;
+	} else if (UNLIKELY((fd = open(
+				    fn.d, O_RDWR | O_APPEND | O_CREAT,
+				    0666)) < 0)) {
+		return -1;
+	}
+	/* refuse to add to a torn log */
+	if (UNLIKELY(flock(fd, LOCK_SH) < 0)) {
+		goto clo;
+	} else if (UNLIKELY((sz = lseek(fd, 0, SEEK_END)) < 0) ||
+		   UNLIKELY(log_last_seq(fd, sz, &seq) < 0)) {
+		goto unl;
+	} else if (UNLIKELY((l = calloc(1U, sizeof(*l))) == NULL)) {
+		goto unl;
+	}
+	flock(fd, LOCK_UN);
+	l->fd = fd;
+	/* or to one that's out of step with us, unmarked databases
+	 * haven't committed anything with this log yet */
+	with (const_buf_t m = get_meta(ctx, seqkey, sizeof(seqkey))) {
+		uint64_t x;
+
+		if (m.z == sizeof(x)) {
+			memcpy(&x, m.d, sizeof(x));
+			l->broken = le64toh(x) != seq;
+		}
+	}
+	ctx->log = l;
+	return 0;
+
+unl:
+	flock(fd, LOCK_UN);
+clo:
+	close(fd);
+	return -1;
+}
+
+static void
+close_log(rotz_t ctx)
+{
+	struct rtz_log_s *l = ctx->log;
+
+	if (l == NULL) {
+		return;
+	}
+	/* whatever is queued belongs to an unfinished transaction */
+	log_drop(ctx);
+	fdatasync(l->fd);
+	close(l->fd);
+	free(l->buf);
+	free(l);
+	ctx->log = NULL;
+	return;
+}
+
+static int
+log_apply(rotz_t ctx, unsigned int op, const_buf_t a, const_buf_t b)
+{
+/* replay a record against the primitive that wrote it, records are
+ * only written for writes that went through so a failure here means
+ * the replica has diverged */
+	rtz_vtx_t v = 0U;
+	int res;
+
+	if (b.z == sizeof(v)) {
+		memcpy(&v, b.d, sizeof(v));
+	}
+	switch (op) {
+	case RTZ_LOG_RNM_VERTEX:
+	case RTZ_LOG_UNRNM_VERTEX:
+	case RTZ_LOG_ADD_ALIAS:
+	case RTZ_LOG_ADD_AKALST:
+		if (UNLIKELY(a.z != RTZ_VTXKEY_Z)) {
+			return -1;
+		}
+		break;
+	case RTZ_LOG_ADD_EDGE:
+	case RTZ_LOG_ADD_VTXLST:
+	case RTZ_LOG_REM_EDGES:
+		if (UNLIKELY(a.z != RTZ_EDGKEY_Z)) {
+			return -1;
+		}
+		break;
+	default:
+		break;
+	}
+
+	switch (op) {
+	case RTZ_LOG_NEXT_ID:
+		/* older logs carry no count */
+		res = -(next_ids(ctx, v ?: 1U) == 0U);
+		break;
+	case RTZ_LOG_PUT_VERTEX:
+		res = put_vertex(ctx, a.d, a.z, v);
+		break;
+	case RTZ_LOG_RNM_VERTEX:
+		if (UNLIKELY(b.z == 0U)) {
+			return -1;
+		}
+		res = rnm_vertex(ctx, (rtz_vtxkey_t)a.d, b.d, b.z - 1U);
+		break;
+	case RTZ_LOG_UNPUT_VERTEX:
+		res = unput_vertex(ctx, a.d, a.z);
+		break;
+	case RTZ_LOG_UNRNM_VERTEX:
+		res = unrnm_vertex(ctx, (rtz_vtxkey_t)a.d);
+		break;
+	case RTZ_LOG_ADD_ALIAS:
+		if (UNLIKELY(b.z == 0U)) {
+			return -1;
+		}
+		res = add_alias(ctx, (rtz_vtxkey_t)a.d, b.d, b.z - 1U);
+		break;
+	case RTZ_LOG_ADD_AKALST:
+		res = add_akalst(ctx, (rtz_vtxkey_t)a.d, b);
+		break;
+	case RTZ_LOG_ADD_EDGE:
+		res = add_edge(ctx, (rtz_edgkey_t)a.d, v);
+		break;
+	case RTZ_LOG_ADD_VTXLST:
+		res = add_vtxlst(
+			ctx, (rtz_edgkey_t)a.d,
+			(const_vtxlst_t){b.z / sizeof(v), (const void*)b.d});
+		break;
+	case RTZ_LOG_REM_EDGES:
+		res = rem_edges(ctx, (rtz_edgkey_t)a.d);
+		break;
+	case RTZ_LOG_ADD_CHILD:
+		res = add_child(ctx, a, v);
+		break;
+	case RTZ_LOG_ADD_CHLDLST:
+		res = add_chldlst(
+			ctx, a, (const_vtxlst_t){b.z / sizeof(v), (const void*)b.d});
+		break;
+	case RTZ_LOG_PUT_SORTED:
+		res = put_sorted(ctx, &a, &b, 1U);
+		break;
+	case RTZ_LOG_FMT:
+		/* keys from a primary of another format are no good to us */
+		if (UNLIKELY(b.z != 1U) ||
+		    UNLIKELY((unsigned char)*b.d != rtz_fmt)) {
+			return -1;
+		}
+		res = 0;
+		break;
+	case RTZ_LOG_RET_IDS: {
+		rtz_vtx_t r[2U];
+
+		if (UNLIKELY(b.z != sizeof(r))) {
+			return -1;
+		}
+		memcpy(r, b.d, sizeof(r));
+		res = ret_ids(ctx, r[0U], r[1U]);
+		break;
+	}
+	default:
+		return -1;
+	}
+	return res;
+}
+
+int
+rotz_set_changelog(rotz_t ctx, const char *file)
+{
+	char *fn = NULL;
+	int res;
+
+	if (file != NULL) {
+		int fd;
+
+		/* the log must exist for its name to be canonicalised */
+		if (UNLIKELY((fd = open(file, O_WRONLY | O_CREAT, 0666)) < 0)) {
+			return -1;
+		}
+		close(fd);
+		if (UNLIKELY((fn = realpath(file, NULL)) == NULL)) {
+			return -1;
+		}
+	}
+	close_log(ctx);
+	res = put_meta(
+		ctx, logkey, sizeof(logkey),
+		(const_buf_t){fn != NULL ? strlen(fn) + 1U : 0U, fn});
+	free(fn);
+	if (UNLIKELY(res < 0)) {
+		return -1;
+	} else if (UNLIKELY(put_meta(
+				    ctx, seqkey, sizeof(seqkey),
+				    (const_buf_t){0U}) < 0)) {
+		/* the new log starts from scratch */
+		return -1;
+	}
+	return open_log(ctx);
+}
+
+rtz_logpos_t
+rotz_get_logpos(rotz_t ctx)
+{
+	const_buf_t v = get_meta(ctx, poskey, sizeof(poskey));
+	rtz_logpos_t res = {0U};
+	uint64_t x[2U];
+
+	if (v.z == sizeof(x)) {
+		memcpy(x, v.d, sizeof(x));
+		res.seq = le64toh(x[0U]);
+		res.off = le64toh(x[1U]);
+	}
+	return res;
+}
+
+int
+rotz_apply_changelog(
+	rotz_t ctx, rtz_logpos_t *pos, const void *buf, size_t bsz)
+{
+	const char *bp = buf;
+	const char *const ep = bp + bsz;
+	rtz_logpos_t p = *pos;
+	int n = 0;
+
+	if (UNLIKELY(tx_begin(ctx) < 0)) {
+		return -1;
+	}
+	while (ep - bp >= (ptrdiff_t)RTZ_LOG_REC_Z) {
+		const char *rp = bp;
+		const uint32_t z = xget_u32(&rp);
+		const uint32_t op = xget_u32(&rp);
+		uint64_t seq;
+		uint32_t az;
+
+		if (UNLIKELY(z < RTZ_LOG_REC_Z)) {
+			goto bad;
+		} else if ((size_t)(ep - bp) < z) {
+			/* the rest is still being written */
+			break;
+		}
+		memcpy(&seq, rp, sizeof(seq));
+		seq = le64toh(seq);
+		rp += sizeof(seq);
+		az = xget_u32(&rp);
+
+		with (const char *tp = bp + z - 4U) {
+			if (UNLIKELY(xget_u32(&tp) != z)) {
+				goto bad;
+			}
+		}
+		if (UNLIKELY(az > z - RTZ_LOG_REC_Z)) {
+			goto bad;
+		} else if (UNLIKELY(seq != p.seq + 1U)) {
+			/* we're out of step with the log */
+			goto bad;
+		} else if (UNLIKELY(log_apply(
+					    ctx, op, (const_buf_t){az, rp},
+					    (const_buf_t){
+						    z - RTZ_LOG_REC_Z - az,
+						    rp + az}) < 0)) {
+			goto bad;
+		}
+		p.seq = seq;
+		p.off += z;
+		bp += z;
+		n++;
+	}
+	if (n > 0) {
+		/* the position goes in along with the changes */
+		const uint64_t x[2U] = {htole64(p.seq), htole64(p.off)};
+		const_buf_t v = {sizeof(x), (const void*)x};
+
+		if (UNLIKELY(put_meta(ctx, poskey, sizeof(poskey), v) < 0)) {
+			goto bad;
+		}
+	}
+	if (UNLIKELY(tx_commit(ctx) < 0)) {
+		return -1;
+	}
+	*pos = p;
+	return n;
+
+bad:
+	tx_abort(ctx);
+	return -1;
+}
+
+
+/* arenas
+ * Blocks are chained, each one at least twice the size of its
+ * predecessor, so clearing an arena frees a logarithmic number of
+ * blocks and keeps the largest one for reuse.  The most recent
+ * allocation can grow in place. */
+#define RTZ_ARENA_Z	(65536U)
+#define RTZ_ARENA_ALIGN	(sizeof(max_align_t))
+
+struct rtz_blk_s {
+	struct rtz_blk_s *prev;
+	size_t z;
+	size_t n;
+	max_align_t d[];
+};
+
+struct rtz_arena_s {
+	struct rtz_blk_s *b;
+	void *last;
+};
+
+static inline size_t
+arena_align(size_t z)
+{
+	return (z + RTZ_ARENA_ALIGN - 1U) & ~(RTZ_ARENA_ALIGN - 1U);
+}
+
+static void*
+arena_realloc(rtz_arena_t a, void *p, size_t oz, size_t nz)
+{
+/* grow P, of which OZ bytes are in use, to NZ bytes */
+	struct rtz_blk_s *b = a->b;
+	unsigned char *q;
+
+	nz = arena_align(nz);
+	if (p != NULL && p == a->last) {
+		/* P is at the top of the current block */
+		const size_t o = (unsigned char*)p - (unsigned char*)b->d;
+
+		if (o + nz <= b->z) {
+			b->n = o + nz;
+			return p;
+		}
+	} else if (LIKELY(b != NULL && b->n + nz <= b->z)) {
+		q = (unsigned char*)b->d + b->n;
+		goto cpy;
+	}
+	with (size_t bz = b != NULL ? 2U * b->z : RTZ_ARENA_Z) {
+		while (bz < nz) {
+			bz *= 2U;
+		}
+		if (UNLIKELY((b = malloc(sizeof(*b) + bz)) == NULL)) {
+			return NULL;
+		}
+		b->prev = a->b;
+		b->z = bz;
+		a->b = b;
+	}
+	q = (unsigned char*)b->d;
+cpy:
+	if (oz) {
+		memcpy(q, p, oz);
+	}
+	b->n = q - (unsigned char*)b->d + nz;
+	return a->last = q;
+}
+
+rtz_arena_t
+rotz_make_arena(void)
+{
+	return calloc(1U, sizeof(struct rtz_arena_s));
+}
+
+void
+rotz_free_arena(rtz_arena_t a)
+{
+	for (struct rtz_blk_s *b = a->b, *prev; b != NULL; b = prev) {
+		prev = b->prev;
+		free(b);
+	}
+	free(a);
+	return;
+}
+
+void
+rotz_clear_arena(rtz_arena_t a)
+{
+	if (UNLIKELY(a->b == NULL)) {
+		return;
+	}
+	for (struct rtz_blk_s *b = a->b->prev, *prev; b != NULL; b = prev) {
+		prev = b->prev;
+		free(b);
+	}
+	a->b->prev = NULL;
+	a->b->n = 0U;
+	a->last = NULL;
+	return;
+}
+
+void*
+rotz_arena_alloc(rtz_arena_t a, size_t z)
+{
+	return arena_realloc(a, NULL, 0U, z);
+}
+
+
+
+/* set opers
+ * Result lists don't carry their capacity, it's implied by their size:
+ * lists are grown to 64 elements first and then doubled whenever their
+ * size reaches a power of 2.  Lists live in arena A or, if A is NULL,
+ * on the heap. */
+static void*
+lst_realloc(rtz_arena_t a, void *p, size_t oz, size_t nz)
+{
+	if (a == NULL) {
+		return realloc(p, nz);
+	}
+	return arena_realloc(a, p, oz, nz);
+}
+
+static inline size_t
+lst_grow(size_t z)
+{
+/* return the new capacity if a list of Z elements is full, 0 otherwise */
+	if (z < 64U) {
+		return z ? 0U : 64U;
+	}
+	return z & (z - 1U) ? 0U : 2U * z;
+}
+
+static rtz_vtxlst_t
+add_to_vtxlst(rtz_arena_t a, rtz_vtxlst_t el, rtz_vtx_t v)
+{
+	size_t nu;
+
+	if (UNLIKELY(nu = lst_grow(el.z))) {
+		el.d = lst_realloc(
+			a, el.d, el.z * sizeof(*el.d), nu * sizeof(*el.d));
+	}
+	el.d[el.z++] = v;
+	return el;
+}
 
 static rtz_wtxlst_t
-wtxlst_union(rtz_wtxlst_t tgt, const_vtxlst_t el)
+add_to_wtxlst(rtz_arena_t a, rtz_wtxlst_t wl, rtz_vtx_t v)
+{
+	size_t nu;
+
+	if (UNLIKELY(nu = lst_grow(wl.z))) {
+		wl.d = lst_realloc(
+			a, wl.d, wl.z * sizeof(*wl.d), nu * sizeof(*wl.d));
+		wl.w = lst_realloc(
+			a, wl.w, wl.z * sizeof(*wl.w), nu * sizeof(*wl.w));
+	}
+	wl.d[wl.z] = v;
+	wl.w[wl.z] = 0U;
+	wl.z++;
+	return wl;
+}
+
+rtz_vtxlst_t
+rtz_vtxlst_union(rtz_arena_t a, rtz_vtxlst_t tgt, const_vtxlst_t el)
+{
+	const size_t tgtz = tgt.z;
+
+	for (size_t i = 0; i < el.z; i++) {
+		rtz_vtx_t item = el.d[i];
+
+		/* got this one? */
+		if (rtz_find_in_vtxlst((const_vtxlst_t){tgtz, tgt.d}, item)) {
+			continue;
+		}
+		tgt = add_to_vtxlst(a, tgt, item);
+	}
+	return tgt;
+}
+
+rtz_wtxlst_t
+rtz_wtxlst_union(rtz_arena_t a, rtz_wtxlst_t tgt, const_vtxlst_t el)
 {
 	const size_t tgtz = tgt.z;
 
@@ -590,22 +3598,23 @@ wtxlst_union(rtz_wtxlst_t tgt, const_vtxlst_t el)
 		size_t p;
 
 		/* got this one? */
-		if ((p = find_in_vtxlst((const_vtxlst_t){tgtz, tgt.d}, item))) {
+		p = rtz_find_in_vtxlst((const_vtxlst_t){tgtz, tgt.d}, item);
+		if (p) {
 			/* add 1 in the weight vector then */
 			tgt.w[p - 1]++;
 			continue;
 		}
-		tgt = add_to_wtxlst(tgt, item);
+		tgt = add_to_wtxlst(a, tgt, item);
 	}
 	return tgt;
 }
 
-static rtz_vtxlst_t
-vtxlst_intersection(rtz_vtxlst_t tgt, const_vtxlst_t el)
+rtz_vtxlst_t
+rtz_vtxlst_intersection(rtz_vtxlst_t tgt, const_vtxlst_t el)
 {
 	for (size_t i = 0; i < tgt.z; i++) {
 		/* got this one? */
-		if (find_in_vtxlst(el, tgt.d[i])) {
+		if (rtz_find_in_vtxlst(el, tgt.d[i])) {
 			/* item can stay in tgt */
 			continue;
 		}
@@ -628,16 +3637,22 @@ vtxlst_intersection(rtz_vtxlst_t tgt, const_vtxlst_t el)
 }
 
 rtz_vtxlst_t
-rotz_union(rotz_t cp, rtz_vtxlst_t x, rtz_vtx_t v)
+rotz_union_a(rotz_t cp, rtz_arena_t a, rtz_vtxlst_t x, rtz_vtx_t v)
 {
 	rtz_edgkey_t vkey = rtz_edgkey(v);
 	const_vtxlst_t el;
 
-	if (UNLIKELY((el = get_edges(cp, vkey)).d == NULL)) {
+	if (UNLIKELY((el = get_live_edges(cp, vkey)).d == NULL)) {
 		return x;
 	}
 	/* just add them one by one */
-	return vtxlst_union(x, el);
+	return rtz_vtxlst_union(a, x, el);
+}
+
+rtz_vtxlst_t
+rotz_union(rotz_t cp, rtz_vtxlst_t x, rtz_vtx_t v)
+{
+	return rotz_union_a(cp, NULL, x, v);
 }
 
 rtz_vtxlst_t
@@ -646,24 +3661,30 @@ rotz_intersection(rotz_t cp, rtz_vtxlst_t x, rtz_vtx_t v)
 	rtz_edgkey_t vkey = rtz_edgkey(v);
 	const_vtxlst_t el;
 
-	if (UNLIKELY((el = get_edges(cp, vkey)).d == NULL)) {
+	if (UNLIKELY((el = get_live_edges(cp, vkey)).d == NULL)) {
 		return x;
 	}
 	/* just add them one by one */
-	return vtxlst_intersection(x, el);
+	return rtz_vtxlst_intersection(x, el);
 }
 
 rtz_wtxlst_t
-rotz_munion(rotz_t cp, rtz_wtxlst_t x, rtz_vtx_t v)
+rotz_munion_a(rotz_t cp, rtz_arena_t a, rtz_wtxlst_t x, rtz_vtx_t v)
 {
 	rtz_edgkey_t vkey = rtz_edgkey(v);
 	const_vtxlst_t el;
 
-	if (UNLIKELY((el = get_edges(cp, vkey)).d == NULL)) {
+	if (UNLIKELY((el = get_live_edges(cp, vkey)).d == NULL)) {
 		return x;
 	}
 	/* just add them one by one */
-	return wtxlst_union(x, el);
+	return rtz_wtxlst_union(a, x, el);
+}
+
+rtz_wtxlst_t
+rotz_munion(rotz_t cp, rtz_wtxlst_t x, rtz_vtx_t v)
+{
+	return rotz_munion_a(cp, NULL, x, v);
 }
 
 /* rotz.c ends here */
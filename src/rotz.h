@@ -41,7 +41,16 @@
 #include <stdint.h>
 
 typedef struct rotz_s *restrict rotz_t;
+typedef struct rtz_arena_s *rtz_arena_t;
+/**
+ * Vertex handles.  Builds configured with --enable-wide-ids use 64-bit
+ * handles, databases of one kind cannot be opened by the other kind
+ * but can be carried over with rotz_export_binary()/rotz_import_binary(). */
+#if defined WITH_WIDE_IDS
+typedef uint64_t rtz_vtx_t;
+#else  /* !WITH_WIDE_IDS */
 typedef unsigned int rtz_vtx_t;
+#endif	/* WITH_WIDE_IDS */
 
 typedef struct {
 	size_t z;
@@ -80,10 +89,39 @@ typedef struct {
 extern rotz_t make_rotz(const char *dbfile, ...);
 extern void free_rotz(rotz_t);
 
+/**
+ * Return another handle on the database of CTX, for reads by a thread
+ * of its own, see `rotz_begin_read()'.  Clones don't write to the change
+ * log and must be freed before CTX. */
+extern rotz_t rotz_clone(rotz_t ctx);
+
 /**
  * Return object handle for vertex V. */
 extern rtz_vtx_t rotz_get_vertex(rotz_t, const char *v);
 
+/**
+ * Return object handles for the N vertices in V in one go, i.e.
+ * RES[i] is set to the handle of V[i] or 0 if there's no such vertex.
+ * Lookups are carried out in key order using a single cursor.
+ * The number of vertices found is returned, should memory run out
+ * that is 0 and RES is all zeroes. */
+extern size_t
+rotz_get_vertices(rotz_t, const char *const v[], size_t n, rtz_vtx_t res[]);
+
+/**
+ * Return the largest object handle handed out so far. */
+extern rtz_vtx_t rotz_get_maxid(rotz_t);
+
+/**
+ * Reserve N consecutive object handles for subsequent vertex additions.
+ * Handles are normally reserved in blocks of 4096 and handed out from
+ * memory, bulk loaders can use this to reserve exactly as many as they
+ * need.  Whatever is left unused is given back by `free_rotz()' unless
+ * other handles have reserved ids meanwhile, in which case they are
+ * abandoned.
+ * Return the first handle of the reservation, or 0 on failure. */
+extern rtz_vtx_t rotz_reserve_ids(rotz_t, size_t n);
+
 /**
  * Add vertex V to rotz database file and return its object handle. */
 extern rtz_vtx_t rotz_add_vertex(rotz_t, const char *v);
@@ -105,6 +143,20 @@ extern const char *rotz_get_name(rotz_t, rtz_vtx_t v);
  * The buffer can be freed with `rotz_free_r()'. */
 extern rtz_buf_t rotz_get_name_r(rotz_t, rtz_vtx_t v);
 
+/**
+ * Retrieve the names of the N vertices in V in one go, i.e.
+ * RES[i] is set to the name of V[i] or NULL if there's no such vertex.
+ * The names are copied into the caller-provided buffer ARENA which is
+ * grown as needed and whose previous contents are overwritten.
+ * Lookups are carried out in key order using a single cursor.
+ * The arena can be freed with `rotz_free_r()'.
+ * The number of names found is returned, names that don't fit for
+ * want of memory are NULL in RES and don't count. */
+extern size_t
+rotz_get_names(
+	rotz_t, const rtz_vtx_t v[], size_t n,
+	const char *res[], rtz_buf_t *arena);
+
 /**
  * Releases resources for buffers generically. */
 extern void rotz_free_r(rtz_buf_t);
@@ -130,6 +182,10 @@ extern int rotz_get_edge(rotz_t, rtz_vtx_t from, rtz_vtx_t to);
  * Return (outgoing) edges from a vertex VID. */
 extern rtz_vtxlst_t rotz_get_edges(rotz_t, rtz_vtx_t vid);
 
+/**
+ * Like `rotz_get_edges()' but allocate the list from arena A. */
+extern rtz_vtxlst_t rotz_get_edges_a(rotz_t, rtz_arena_t a, rtz_vtx_t vid);
+
 /**
  * Return the number of (outgoing) edges from a vertex VID. */
 extern size_t rotz_get_nedges(rotz_t, rtz_vtx_t vid);
@@ -154,6 +210,185 @@ extern int rotz_add_edge(rotz_t, rtz_vtx_t from, rtz_vtx_t to);
  * Remove an edge from vertex FROM to vertex TO. */
 extern int rotz_rem_edge(rotz_t, rtz_vtx_t from, rtz_vtx_t to);
 
+/**
+ * Add edges from vertex FROM to each of the N vertices in TO.
+ * TO need not be sorted and may contain duplicates, vertices already
+ * adjacent to FROM are skipped and the others are appended to FROM's
+ * edge list in the order of TO.  The list is written only once.
+ * Return the number of edges added or -1 on failure. */
+extern int
+rotz_add_edges(rotz_t, rtz_vtx_t from, const rtz_vtx_t to[], size_t n);
+
+/**
+ * Remove the edges from vertex FROM to each of the N vertices in TO.
+ * The edge list of FROM is written only once.
+ * Return the number of edges removed or -1 on failure. */
+extern int
+rotz_rem_edges_bulk(rotz_t, rtz_vtx_t from, const rtz_vtx_t to[], size_t n);
+
+/**
+ * Merge vertex FROM into vertex INTO, i.e. move FROM's edges over to INTO
+ * and make all names of FROM aliases of INTO, then remove FROM.
+ * Every affected edge list is rewritten at most once.
+ * Unless a transaction is open already (see `rotz_begin()') the merge
+ * is carried out in a transaction of its own, i.e. atomically.
+ * Return 0 on success and -1 on failure. */
+extern int rotz_merge_vertices(rotz_t, rtz_vtx_t into, rtz_vtx_t from);
+
+
+/**
+ * Remove vertex V along with its names and edges.
+ * V's own edge list is removed right away but in the edge lists of its
+ * neighbours V is merely tombstoned, the accessors above and the edge
+ * iterators filter tombstoned vertices until `rotz_compact()' purges
+ * them.  So dropping a vertex costs the same regardless of its degree.
+ * Unless a transaction is open already (see `rotz_begin()') V is dropped
+ * in a transaction of its own.
+ * Return V's former object handle or 0 if there's no such vertex. */
+extern rtz_vtx_t rotz_drop_vertex(rotz_t, const char *v);
+
+/**
+ * Purge tombstoned vertices from all edge lists and lay their tombstones
+ * to rest, see `rotz_drop_vertex()'.
+ * Edge lists are rewritten in key order, in batches of transactions
+ * unless a transaction is open already.
+ * Return the number of edge lists rewritten or -1 on failure. */
+extern int rotz_compact(rotz_t);
+
+/**
+ * Remove vertices without edges along with all their names.
+ * Vertices are removed in batches of transactions unless a transaction
+ * is open already.
+ * Return the number of vertices removed or -1 on failure. */
+extern int rotz_gc(rotz_t);
+
+/**
+ * Remove vertices along with their names as soon as their last edge is
+ * removed through `rotz_rem_edge()' or `rotz_rem_edges_bulk()' if ON is
+ * non-zero, or stop doing so if ON is zero.
+ * The setting is kept in the database.
+ * Return 0 on success and -1 on failure. */
+extern int rotz_set_autogc(rotz_t, int on);
+
+/**
+ * Renumber all vertices, PERM has N slots and slot V holds the new
+ * object handle of vertex V, or 0 if V is not in use.  New handles must
+ * be unique and should be dense, the next vertex added gets the handle
+ * after the number of vertices renumbered.
+ * Tombstoned vertices are purged first, see `rotz_compact()', the
+ * order of edges within adjacency lists is kept.
+ * Everything is rewritten in one transaction, meant for offline use.
+ * Return the number of vertices renumbered or -1 on failure. */
+extern int rotz_renumber(rotz_t, const rtz_vtx_t perm[], size_t n);
+
+/**
+ * Convert a database with object handles in native byte order in its
+ * keys to the current format, i.e. handles in big-endian order so that
+ * keys sort like handles.
+ * Databases of the old format can be used as they are but iterations
+ * by handle range have to visit all keys.
+ * The conversion is not recorded in the change log, replicas have to
+ * be converted by themselves.
+ * Return 1 if the database was converted, 0 if it was current already
+ * and -1 on failure. */
+extern int rotz_upgrade(rotz_t);
+
+/**
+ * Return the vertices with a name of the form PARENT:xxx.
+ * The list is maintained by the vertex and alias routines above and
+ * must be freed with `rotz_free_vtxlst()'. */
+extern rtz_vtxlst_t rotz_get_children(rotz_t, const char *parent);
+
+/**
+ * Return the union of (outgoing) edges of all children of PARENT,
+ * i.e. of all vertices with a name of the form PARENT:xxx.
+ * The result is sorted by vertex and free of duplicates. */
+extern rtz_vtxlst_t rotz_rollup(rotz_t, const char *parent);
+
+/**
+ * Rebuild the parent index from scratch. */
+extern int rotz_reindex(rotz_t);
+
+
+/**
+ * Write the contents of CTX to file descriptor FD in binary exchange
+ * format, i.e. all vertices with their names followed by all edges.
+ * Return 0 on success and -1 on failure. */
+extern int rotz_export_binary(rotz_t, int fd);
+
+/**
+ * Load the binary exchange stream in BUF of size BSZ into CTX.
+ * CTX must refer to an empty database, keys are put in order and in one
+ * go which most backends can do with little more than sequential writes.
+ * Return 0 on success and -1 on failure. */
+extern int rotz_import_binary(rotz_t, const void *buf, size_t bsz);
+
+
+/* transactions */
+/**
+ * Group all subsequent changes to CTX into one transaction that becomes
+ * durable and visible to others with `rotz_commit()' or is discarded
+ * with `rotz_abort()'.  Reads through CTX see the changes made so far.
+ * Transactions do not nest.
+ * Return 0 on success and -1 on failure. */
+extern int rotz_begin(rotz_t);
+
+/**
+ * Commit the transaction opened by `rotz_begin()'.
+ * Return 0 on success and -1 on failure. */
+extern int rotz_commit(rotz_t);
+
+/**
+ * Discard the transaction opened by `rotz_begin()'. */
+extern void rotz_abort(rotz_t);
+
+/**
+ * Have all subsequent reads through CTX see the same snapshot of the
+ * database until `rotz_end_read()'.  Handles obtained from `rotz_clone()'
+ * may read in different threads at the same time, and alongside a
+ * transaction of the original handle, with lmdb.  With tokyocabinet
+ * they take turns.  CTX must not be written to in between.
+ * Return 0 on success and -1 on failure. */
+extern int rotz_begin_read(rotz_t);
+
+/**
+ * Release the snapshot obtained by `rotz_begin_read()'. */
+extern void rotz_end_read(rotz_t);
+
+
+/* change log */
+typedef struct {
+	/* sequence number of the last record applied */
+	uint64_t seq;
+	/* offset into the change log just past that record */
+	uint64_t off;
+} rtz_logpos_t;
+
+/**
+ * Record all subsequent changes to CTX in the change log FILE, or stop
+ * recording them if FILE is NULL.  The setting is kept in the database
+ * so that every writer opening it appends to the same log, writers
+ * are serialised by a lock on the log file.
+ * Writes are refused once the log misses writes the database has
+ * committed, e.g. after a crash between the two; setting the change
+ * log anew starts a fresh sequence and lifts that.
+ * Return 0 on success and -1 on failure. */
+extern int rotz_set_changelog(rotz_t, const char *file);
+
+/**
+ * Return the change log position `rotz_apply_changelog()' has reached. */
+extern rtz_logpos_t rotz_get_logpos(rotz_t);
+
+/**
+ * Apply the change log contents in BUF of size BSZ, as read from offset
+ * POS->off of the log, to CTX in one transaction.  Only complete records
+ * are applied and they must continue the sequence at POS->seq.
+ * POS is advanced and stored in the database along with the changes.
+ * Return the number of records applied or -1 on failure. */
+extern int
+rotz_apply_changelog(
+	rotz_t, rtz_logpos_t *pos, const void *buf, size_t bsz);
+
 
 /**
  * Call CB for for every vertex in CTX, passing the vertex, its name and
@@ -171,6 +406,32 @@ rotz_vtx_iter(rotz_t, int(*cb)(rtz_vtx_t, const char*, void*), void *clo);
 extern void
 rotz_edg_iter(rotz_t, int(*cb)(rtz_vtx_t, rtz_const_vtxlst_t, void*), void *C);
 
+/**
+ * Like `rotz_edg_iter()' but only visit slice I of N slices of the
+ * edges.  The slices are disjoint, together they cover all edges and
+ * visiting slices 0 to N-1 one after another is the same as calling
+ * `rotz_edg_iter()'.  Slices cover about equal ranges of handles
+ * unless the database is of the old format, see `rotz_upgrade()'.
+ * Every call uses its own read transaction and different slices may be
+ * iterated by different threads at the same time, other accessors must
+ * not be used concurrently on the same handle, see `rotz_clone()'.
+ * The adjacency list passed to the callback must not be freed. */
+extern void
+rotz_edg_iter_slice(
+	rotz_t, unsigned int i, unsigned int n,
+	int(*cb)(rtz_vtx_t, rtz_const_vtxlst_t, void*), void *C);
+
+/**
+ * Like `rotz_edg_iter()' but only visit the edges of vertices LO up to
+ * but excluding HI, in ascending order, an HI of 0 means no bound.
+ * Databases of the old format are scanned in full and in key order,
+ * see `rotz_upgrade()'.
+ * The adjacency list passed to the callback must not be freed. */
+extern void
+rotz_edg_iter_range(
+	rotz_t, rtz_vtx_t lo, rtz_vtx_t hi,
+	int(*cb)(rtz_vtx_t, rtz_const_vtxlst_t, void*), void *C);
+
 /**
  * Generic iterator, too secret to be documented. */
 extern void
@@ -179,13 +440,41 @@ rotz_iter(
 	int(*cb)(rtz_const_buf_t key, rtz_const_buf_t val, void*), void *C);
 
 
+/* arenas */
+/**
+ * Return a new arena for query results.  Lists obtained through the
+ * `_a' routines live in the arena, they must not be freed individually
+ * but go in one go with `rotz_clear_arena()' or `rotz_free_arena()'. */
+extern rtz_arena_t rotz_make_arena(void);
+
+/**
+ * Free arena A along with everything allocated from it. */
+extern void rotz_free_arena(rtz_arena_t a);
+
+/**
+ * Release everything allocated from arena A, keeping its memory for
+ * reuse, e.g. at the end of a request. */
+extern void rotz_clear_arena(rtz_arena_t a);
+
+/**
+ * Allocate Z bytes from arena A. */
+extern void *rotz_arena_alloc(rtz_arena_t a, size_t z);
+
+
 /* set operations */
 /**
- * Return the union of edges X and the edges of V. */
+ * Return the union of edges X and the edges of V.
+ * X must be empty or the result of a previous union. */
 extern rtz_vtxlst_t rotz_union(rotz_t, rtz_vtxlst_t x, rtz_vtx_t v);
 
 /**
- * Return the intersection of edges X and the edges of V. */
+ * Like `rotz_union()' but X lives in arena A. */
+extern rtz_vtxlst_t
+rotz_union_a(rotz_t, rtz_arena_t a, rtz_vtxlst_t x, rtz_vtx_t v);
+
+/**
+ * Return the intersection of edges X and the edges of V.
+ * X is shrunk in place, so it can live in an arena too. */
 extern rtz_vtxlst_t rotz_intersection(rotz_t, rtz_vtxlst_t x, rtz_vtx_t v);
 
 /**
@@ -193,4 +482,9 @@ extern rtz_vtxlst_t rotz_intersection(rotz_t, rtz_vtxlst_t x, rtz_vtx_t v);
  * For every */
 extern rtz_wtxlst_t rotz_munion(rotz_t, rtz_wtxlst_t x, rtz_vtx_t v);
 
+/**
+ * Like `rotz_munion()' but X lives in arena A. */
+extern rtz_wtxlst_t
+rotz_munion_a(rotz_t, rtz_arena_t a, rtz_wtxlst_t x, rtz_vtx_t v);
+
 #endif	/* INCLUDED_rotz_h_ */
@@ -0,0 +1,121 @@
+/*** routput.c -- buffered output for rotz commands
+ *
+ * Copyright (C) 2013 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of rotz.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "routput.h"
+#include "nifty.h"
+
+
+static int
+write_all(routput_t out, const char *s, size_t z)
+{
+	while (z > 0U) {
+		ssize_t nwr = write(out->fd, s, z);
+
+		if (UNLIKELY(nwr < 0 && errno == EINTR)) {
+			continue;
+		} else if (UNLIKELY(nwr <= 0)) {
+			out->err = 1;
+			return -1;
+		}
+		s += nwr;
+		z -= nwr;
+	}
+	return 0;
+}
+
+
+routput_t
+make_routput(int fd)
+{
+	struct routput_s *res;
+
+	if (UNLIKELY((res = malloc(sizeof(*res))) == NULL)) {
+		return NULL;
+	}
+	res->fd = fd;
+	res->err = 0;
+	res->n = 0U;
+	return res;
+}
+
+int
+free_routput(routput_t out)
+{
+	int rc;
+
+	routput_flush(out);
+	rc = -out->err;
+	free(out);
+	return rc;
+}
+
+int
+routput_flush(routput_t out)
+{
+	int rc = 0;
+
+	if (out->n > 0U && !out->err) {
+		rc = write_all(out, out->buf, out->n);
+	}
+	out->n = 0U;
+	return rc;
+}
+
+void
+routput_spill(routput_t out, const char *s, size_t z)
+{
+	routput_flush(out);
+	if (z > sizeof(out->buf)) {
+		/* bypass the buffer */
+		if (!out->err) {
+			write_all(out, s, z);
+		}
+		return;
+	}
+	memcpy(out->buf, s, z);
+	out->n = z;
+	return;
+}
+
+/* routput.c ends here */
@@ -0,0 +1,133 @@
+/*** routput.h -- buffered output for rotz commands
+ *
+ * Copyright (C) 2013 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of rotz.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if !defined INCLUDED_routput_h_
+#define INCLUDED_routput_h_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "nifty.h"
+
+/* size of the output buffer */
+#define ROUTPUT_Z	(1U << 18U)
+
+typedef struct routput_s *routput_t;
+
+struct routput_s {
+	int fd;
+	int err;
+	size_t n;
+	char buf[ROUTPUT_Z];
+};
+
+/**
+ * Open a buffered writer on file descriptor FD.
+ * Return NULL if memory runs out. */
+extern routput_t make_routput(int fd);
+
+/**
+ * Flush and release resources associated with the writer.
+ * Return 0 if all output could be written, -1 otherwise. */
+extern int free_routput(routput_t);
+
+/**
+ * Write out the buffered contents of OUT. */
+extern int routput_flush(routput_t out);
+
+/**
+ * Flush the buffer of OUT to make room for Z bytes and put S there
+ * or write S straight away if it doesn't fit at all. */
+extern void routput_spill(routput_t out, const char *s, size_t z);
+
+
+static inline void
+routput_buf(routput_t out, const char *s, size_t z)
+{
+	if (UNLIKELY(out->n + z > sizeof(out->buf))) {
+		routput_spill(out, s, z);
+		return;
+	}
+	memcpy(out->buf + out->n, s, z);
+	out->n += z;
+	return;
+}
+
+static inline void
+routput_str(routput_t out, const char *s)
+{
+	routput_buf(out, s, strlen(s));
+	return;
+}
+
+static inline void
+routput_chr(routput_t out, char c)
+{
+	if (UNLIKELY(out->n >= sizeof(out->buf))) {
+		routput_flush(out);
+	}
+	out->buf[out->n++] = c;
+	return;
+}
+
+static inline void
+routput_u(routput_t out, uint_fast64_t x)
+{
+/* print X in decimal, two digits at a time */
+	static const char d2[] =
+		"00010203040506070809" "10111213141516171819"
+		"20212223242526272829" "30313233343536373839"
+		"40414243444546474849" "50515253545556575859"
+		"60616263646566676869" "70717273747576777879"
+		"80818283848586878889" "90919293949596979899";
+	char tmp[20U];
+	char *tp = tmp + sizeof(tmp);
+
+	for (; x >= 100U; x /= 100U) {
+		tp -= 2U;
+		memcpy(tp, d2 + 2U * (x % 100U), 2U);
+	}
+	if (x >= 10U) {
+		tp -= 2U;
+		memcpy(tp, d2 + 2U * x, 2U);
+	} else {
+		*--tp = (char)('0' + x);
+	}
+	routput_buf(out, tp, tmp + sizeof(tmp) - tp);
+	return;
+}
+
+#endif	/* INCLUDED_routput_h_ */
@@ -0,0 +1,183 @@
+/*** rshow.c -- show queries for rotz commands
+ *
+ * Copyright (C) 2013 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of rotz.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <stdlib.h>
+#include <string.h>
+
+#include "rshow.h"
+#include "rotz-cmd-api.h"
+#include "nifty.h"
+
+
+static int
+vtx_cmp(const void *x, const void *y)
+{
+	const rtz_vtx_t *vx = x;
+	const rtz_vtx_t *vy = y;
+
+	return (*vx > *vy) - (*vx < *vy);
+}
+
+static void
+show_one(struct rshow_s *sh, const char *input, rtz_vtx_t tsid)
+{
+	rotz_t ctx = sh->ctx;
+	rtz_vtxlst_t vl;
+
+	if (!tsid) {
+		/* nothing to worry about */
+		return;
+	}
+	switch (sh->mode) {
+	case RSHOW_UNION:
+		sh->r.vl = rotz_union_a(ctx, sh->ar, sh->r.vl, tsid);
+		break;
+	case RSHOW_MUNION:
+		sh->r.wl = rotz_munion_a(ctx, sh->ar, sh->r.wl, tsid);
+		break;
+	case RSHOW_ISECT:
+		if (sh->nisect++ > 0U) {
+			sh->r.vl = rotz_intersection(ctx, sh->r.vl, tsid);
+		} else {
+			sh->r.vl = rotz_get_edges_a(ctx, sh->ar, tsid);
+		}
+		break;
+	default:
+		vl = rotz_get_edges(ctx, tsid);
+		sh->prnt(sh->clo, (rtz_const_vtxlst_t){vl.z, vl.d},
+			 sh->mode == RSHOW_PAIRS ? input : NULL, strlen(input));
+		rotz_free_vtxlst(vl);
+		break;
+	}
+	return;
+}
+
+static void
+show_batch(struct rshow_s *sh)
+{
+	const char *const *ip;
+
+	/* resolve the whole batch first */
+	rotz_get_tagsyms(sh->ctx, sh->tsids, sh->in);
+	ip = rotz_batch_seal(sh->in);
+	for (size_t i = 0U; i < sh->in->n; i++) {
+		show_one(sh, ip[i], sh->tsids[i]);
+	}
+	rotz_batch_clear(sh->in);
+	return;
+}
+
+static void
+show_wild(struct rshow_s *sh, const char *input, size_t z)
+{
+/* INPUT is of the form PARENT:* */
+	char *parent;
+	rtz_vtxlst_t vl;
+
+	if (UNLIKELY((parent = strndup(input, z - 2U)) == NULL)) {
+		sh->err = -1;
+		return;
+	}
+	if (sh->mode == RSHOW_UNION || sh->mode == RSHOW_MUNION) {
+		/* just treat them as individual children */
+		vl = rotz_get_children(sh->ctx, parent);
+		for (size_t i = 0U; i < vl.z; i++) {
+			show_one(sh, input, vl.d[i]);
+		}
+		rotz_free_vtxlst(vl);
+		free(parent);
+		return;
+	}
+	/* otherwise merge the children's edges */
+	vl = rotz_rollup(sh->ctx, parent);
+	free(parent);
+	if (sh->mode == RSHOW_ISECT && sh->nisect++ > 0U) {
+		size_t j = 0U;
+
+		/* the rollup is sorted, use that */
+		for (size_t i = 0U; i < sh->r.vl.z; i++) {
+			if (bsearch(sh->r.vl.d + i, vl.d, vl.z,
+				    sizeof(*vl.d), vtx_cmp) != NULL) {
+				sh->r.vl.d[j++] = sh->r.vl.d[i];
+			}
+		}
+		sh->r.vl.z = j;
+	} else if (sh->mode == RSHOW_ISECT && vl.z > 0U) {
+		/* results live in the arena */
+		sh->r.vl.d = rotz_arena_alloc(sh->ar, vl.z * sizeof(*vl.d));
+		if (UNLIKELY(sh->r.vl.d == NULL)) {
+			sh->r.vl.z = 0U;
+			sh->err = -1;
+		} else {
+			memcpy(sh->r.vl.d, vl.d, vl.z * sizeof(*vl.d));
+			sh->r.vl.z = vl.z;
+		}
+	} else if (sh->mode != RSHOW_ISECT) {
+		sh->prnt(sh->clo, (rtz_const_vtxlst_t){vl.z, vl.d},
+			 sh->mode == RSHOW_PAIRS ? input : NULL, z);
+	}
+	rotz_free_vtxlst(vl);
+	return;
+}
+
+
+void
+rshow_push(struct rshow_s *sh, const char *s, size_t z)
+{
+	if (UNLIKELY(z > 2U && s[z - 2U] == ':' && s[z - 1U] == '*')) {
+		/* parameterised tag wildcard, keep things in order */
+		show_batch(sh);
+		show_wild(sh, s, z);
+		return;
+	}
+	rotz_batch_push(sh->in, s, z);
+	if (UNLIKELY(sh->in->n >= RTZ_BATCH_Z)) {
+		show_batch(sh);
+	}
+	return;
+}
+
+int
+rshow_flush(struct rshow_s *sh)
+{
+	show_batch(sh);
+	return sh->err;
+}
+
+/* rshow.c ends here */
@@ -0,0 +1,88 @@
+/*** rshow.h -- show queries for rotz commands
+ *
+ * Copyright (C) 2013 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of rotz.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if !defined INCLUDED_rshow_h_
+#define INCLUDED_rshow_h_
+
+#include <stddef.h>
+#include "rotz.h"
+
+/* from rotz-cmd-api.h */
+struct rtz_batch_s;
+
+/* State of a show query, set up by the caller and fed through
+ * `rshow_push()' one input at a time.  Plain queries are printed as
+ * they go, union, munion and intersection queries collect their result
+ * in R which is printed by the caller after `rshow_flush()'. */
+struct rshow_s {
+	rotz_t ctx;
+	/* for the results in R */
+	rtz_arena_t ar;
+	enum {
+		RSHOW_EDGES,
+		RSHOW_PAIRS,
+		RSHOW_UNION,
+		RSHOW_MUNION,
+		RSHOW_ISECT,
+	} mode;
+	/* print edge list EL, prefixed by PAIR of length PZ in pairs mode */
+	void(*prnt)(void *clo, rtz_const_vtxlst_t el, const char *pair, size_t pz);
+	void *clo;
+	/* caller's scratch space for batching the inputs */
+	struct rtz_batch_s *in;
+	rtz_vtx_t *tsids;
+
+	/* number of intersection operands seen so far */
+	size_t nisect;
+	union {
+		rtz_vtxlst_t vl;
+		rtz_wtxlst_t wl;
+	} r;
+	/* set when results couldn't be had for want of memory */
+	int err;
+};
+
+/**
+ * Add tag or sym S of length Z to the query SH, inputs of the form
+ * PARENT:* stand for all children of PARENT. */
+extern void rshow_push(struct rshow_s *sh, const char *s, size_t z);
+
+/**
+ * Process the inputs of SH still pending.
+ * Return 0 on success and -1 if results were lost for want of memory. */
+extern int rshow_flush(struct rshow_s *sh);
+
+#endif	/* INCLUDED_rshow_h_ */
@@ -0,0 +1,32 @@
+## -*- shell-script -*-
+
+$ rm -f -- rotz.tcb
+$ rotz add foo bar
+$ rotz add <<EOF
+foo	baz
+foo	bar
+foo	qux
+foo	baz
+xxx	bar
+foo	quux
+EOF
+$ rotz show foo
+bar
+baz
+qux
+quux
+$ rotz show bar
+foo
+xxx
+$ rotz del foo <<EOF
+baz
+quux
+none
+EOF
+$ rotz show foo
+bar
+qux
+$ rotz show baz
+$ rm -f -- rotz.tcb
+
+## add_04.tst ends here
@@ -0,0 +1,15 @@
+## -*- shell-script -*-
+
+$ rm -f -- rotz.tcb
+$ printf 'rotz\001\000\000\000\367\377\377\177\000\000\000\000\000\000\000\000' | rotz import
+$ rotz add foo a b
+$ rotz show --ids foo
+2147483641
+2147483642
+$ rotz add bar b
+$ rotz show --ids bar
+2147483642
+$ rm -f -- rotz.tcb
+$
+
+## add_05.tst ends here
@@ -0,0 +1,42 @@
+## -*- shell-script -*-
+
+$ rm -f -- rotz.tcb
+$ rotz batch --batch=2 <<EOF
+add foo bar baz
+rotz add sec:x "two words" qux
+alias foo important
+add tmp Y
+del tmp Y
+combine --into=sec:x foo
+add old Z
+rename old new
+EOF
+1	ok
+2	ok
+3	ok
+4	ok
+5	ok
+6	ok
+7	ok
+8	ok
+$ rotz show qux
+sec:x
+$ rotz show sec:x
+two words
+qux
+bar
+baz
+$ rotz show Y
+$ rotz show Z
+new
+$ rotz show foo
+$ ! rotz batch --quiet <<EOF
+alias new
+add more Z
+rename new
+EOF
+1	error: need an ALIAS
+3	error: need OLDNAME and NEWNAME
+$ rm -f -- rotz.tcb
+
+## batch_01.tst ends here
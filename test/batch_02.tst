@@ -0,0 +1,20 @@
+## -*- shell-script -*-
+
+$ rm -f -- rotz.tcb
+$ rotz add b Y
+$ printf 'add a X\nadd c Z\nalias a a1 b\nadd d W\n' | rotz batch | cut -f2
+ok
+ok
+error: cannot alias `b'
+ok
+$ rotz show a1
+$ rotz show a
+X
+$ rotz show Z
+c
+$ rotz show W
+d
+$ rm -f -- rotz.tcb
+$
+
+## batch_02.tst ends here
@@ -0,0 +1,31 @@
+## -*- shell-script -*-
+
+$ rm -f -- rotz.tcb
+$ rotz add foo a b c
+$ rotz add bar c d
+$ rotz add baz d e
+$ rotz alias bar bar2
+$ rotz combine foo bar
+$ rotz show bar2
+a
+b
+c
+d
+$ rotz show c
+foo
+$ rotz show d
+foo
+baz
+$ rotz combine --into=foo baz
+$ rotz show foo
+a
+b
+c
+d
+e
+$ rotz show d
+foo
+$ rotz show baz
+$ rm -f -- rotz.tcb
+
+## combine_01.tst ends here
@@ -0,0 +1,14 @@
+## -*- shell-script -*-
+
+$ rm -f -- rotz.tcb
+$ rotz add t1 A B
+$ rotz add t2 B C
+$ rotz add t3 D
+$ rotz components --threads=2
+t1	5
+t3	2
+$ rotz components --top=1
+t1	5
+$ rm -f -- rotz.tcb
+
+## components_01.tst ends here
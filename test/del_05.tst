@@ -0,0 +1,22 @@
+## -*- shell-script -*-
+
+$ rm -f -- rotz.tcb
+$ rotz add foo a b c
+$ rotz add bar b c
+$ rotz del <<EOF
+foo
+EOF
+$ rotz show b
+bar
+$ rotz export
+bar	b
+bar	c
+$ rotz compact -v
+3 edge lists purged
+$ rotz show c
+bar
+$ rotz compact -v
+0 edge lists purged
+$ rm -f -- rotz.tcb
+
+## del_05.tst ends here
@@ -0,0 +1,15 @@
+## -*- shell-script -*-
+
+$ rm -f -- rotz.tcb
+$ rotz add t1 A B C
+$ rotz add t2 B C
+$ rotz add t3 C D
+$ rotz export --project=tags
+t1	t2	2
+t1	t3	1
+t2	t3	1
+$ rotz export --project=tags --min-weight=2 --threads=2
+t1	t2	2
+$ rm -f -- rotz.tcb
+
+## export_01.tst ends here
@@ -0,0 +1,23 @@
+## -*- shell-script -*-
+
+$ rm -f -- rotz.tcb shard.0.csv shard.1.csv
+$ rotz add t1 A B
+$ rotz add t2 B C
+$ rotz add sec:x A
+$ rotz export --threads=3
+t1	A
+t1	B
+t2	B
+t2	C
+sec:x	A
+$ rotz export --split=2 --prefix=shard --threads=2
+$ cat shard.0.csv shard.1.csv
+t1	A
+t1	B
+t2	B
+t2	C
+sec:x	A
+$ ! rotz export --split=2 --gml
+$ rm -f -- rotz.tcb shard.0.csv shard.1.csv
+
+## export_02.tst ends here
@@ -0,0 +1,31 @@
+## -*- shell-script -*-
+
+$ rm -rf -- rotz.tcb csr
+$ rotz add t1 A B
+$ rotz add t2 B
+$ rotz export --csr=csr
+$ cat csr/header.json
+{
+  "format": "rotz-csr",
+  "version": 1,
+  "nvertices": 5,
+  "nedges": 6,
+  "types": {"0": "none", "1": "tag", "2": "sym"},
+  "arrays": {
+    "offsets": {"file": "offsets.bin", "dtype": "<u8", "length": 6},
+    "targets": {"file": "targets.bin", "dtype": "<u4", "length": 6},
+    "types": {"file": "types.bin", "dtype": "|u1", "length": 5},
+    "name_offsets": {"file": "name_offsets.bin", "dtype": "<u8", "length": 6},
+    "names": {"file": "names.bin", "dtype": "|u1", "length": 6}
+  }
+}
+$ od -An -tu1 csr/types.bin
+   0   1   2   2   1
+$ cat csr/names.bin; echo
+t1ABt2
+$ od -An -tu1 csr/targets.bin
+   2   0   0   0   3   0   0   0   1   0   0   0   1   0   0   0
+   4   0   0   0   3   0   0   0
+$ rm -rf -- rotz.tcb csr
+
+## export_03.tst ends here
@@ -0,0 +1,24 @@
+## -*- shell-script -*-
+
+$ rm -f -- primary.tcb replica.tcb changes.log
+$ rotz add --database primary.tcb t0 X
+$ cp primary.tcb replica.tcb
+$ rotz add --database primary.tcb --changelog=changes.log t1 A B
+$ rotz alias --database primary.tcb t1 t9
+$ rotz follow --database replica.tcb --once changes.log
+$ rotz show --database replica.tcb t9
+A
+B
+$ rotz show --database replica.tcb X
+t0
+$ rotz del --database primary.tcb t9 A
+$ rotz add --database primary.tcb sec:x B
+$ rotz follow --database replica.tcb --once changes.log
+$ rotz show --database replica.tcb B
+t1
+sec:x
+$ rotz show --database replica.tcb sec:*
+B
+$ rm -f -- primary.tcb replica.tcb changes.log
+
+## follow_01.tst ends here
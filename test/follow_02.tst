@@ -0,0 +1,14 @@
+## -*- shell-script -*-
+
+$ rm -f -- primary.tcb changes.log
+$ rotz add --database primary.tcb --changelog=changes.log t1 A
+$ : > changes.log
+$ rotz add --database primary.tcb t2 B
+$ rotz show --database primary.tcb B
+$ rotz add --database primary.tcb --changelog=changes.log t2 B
+$ rotz show --database primary.tcb B
+t2
+$ rm -f -- primary.tcb changes.log
+$
+
+## follow_02.tst ends here
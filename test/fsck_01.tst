@@ -0,0 +1,40 @@
+## -*- shell-script -*-
+
+$ rm -f -- rotz.tcb
+$ rotz add <<EOF
+foo	a
+bar	b
+foo	c
+sec:x	a
+bar	d
+foo	e
+sec:x	c
+old	f
+EOF
+$ rotz alias foo fu
+$ rotz del <<EOF
+old
+EOF
+$ rotz fsck --reorder
+average gap 3.67 -> 1.00
+$ rotz export --ids
+1	6
+1	7
+1	5
+2	6
+2	7
+3	8
+3	9
+$ rotz show fu
+a
+c
+e
+$ rotz show c
+foo
+sec:x
+$ rotz add baz g
+$ rotz export --ids | tail -n 1
+10	11
+$ rm -f -- rotz.tcb
+
+## fsck_01.tst ends here
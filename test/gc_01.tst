@@ -0,0 +1,26 @@
+## -*- shell-script -*-
+
+$ rm -f -- rotz.tcb
+$ rotz add foo a b
+$ rotz add bar b c
+$ rotz del foo a b
+$ rotz grep a b c foo bar
+a
+b
+c
+foo
+bar
+$ rotz gc -v
+2 tags and symbols collected
+$ rotz grep a b c foo bar
+b
+c
+bar
+$ rotz gc --auto
+$ rotz del bar c
+$ rotz grep b c bar
+b
+bar
+$ rm -f -- rotz.tcb
+
+## gc_01.tst ends here
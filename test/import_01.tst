@@ -0,0 +1,17 @@
+## -*- shell-script -*-
+
+$ rm -f -- rotz.tcb xchg.tcb
+$ rotz add t1 A B
+$ rotz add sec:x A C
+$ rotz alias t1 t9
+$ rotz export --binary | rotz import --database xchg.tcb
+$ rotz show --database xchg.tcb t9
+A
+B
+$ rotz show --database xchg.tcb sec:*
+A
+C
+$ ! rotz export --binary | rotz import --database xchg.tcb
+$ rm -f -- rotz.tcb xchg.tcb
+
+## import_01.tst ends here
@@ -0,0 +1,17 @@
+## -*- shell-script -*-
+
+$ rm -f -- rotz.tcb xchg.tcb
+$ rotz add foo a b
+$ rotz add bar b
+$ rotz del <<EOF
+foo
+EOF
+$ rotz export --binary | rotz import --database xchg.tcb
+$ rotz show --database xchg.tcb --ids a
+$ rotz show --database xchg.tcb --ids b
+4
+$ rotz show --database xchg.tcb bar
+b
+$ rm -f -- rotz.tcb xchg.tcb
+
+## import_02.tst ends here
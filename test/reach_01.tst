@@ -0,0 +1,17 @@
+## -*- shell-script -*-
+
+$ rm -f -- rotz.tcb
+$ rotz add t1 A B
+$ rotz add t2 B C
+$ rotz add t3 D
+$ rotz reach A
+t1
+B
+$ rotz reach --hops=4 --threads=2 A
+t1
+B
+t2
+C
+$ rm -f -- rotz.tcb
+
+## reach_01.tst ends here
@@ -0,0 +1,25 @@
+## -*- shell-script -*-
+
+$ rm -f -- rotz.tcb serve.pid
+$ rotz add foo bar baz
+$ rotz serve --port=18473 --threads=2 > /dev/null 2>&1 & echo $! > serve.pid
+$ for i in 1 2 3 4 5 6 7 8 9 10; do curl -fs "http://127.0.0.1:18473/show?q=foo" && break; sleep 0.2; done
+bar
+baz
+$ printf 'foo\tqux\n' | curl -fs --data-binary @- "http://127.0.0.1:18473/add"
+1
+$ curl -fs "http://127.0.0.1:18473/show?q=qux"
+foo
+$ curl -fs "http://127.0.0.1:18473/show?q=bar&q=qux&op=intersection"
+foo
+$ curl -s -o /dev/null -w '%{http_code}\n' "http://127.0.0.1:18473/nope"
+404
+$ kill -INT `cat serve.pid`; while kill -0 `cat serve.pid` 2>/dev/null; do sleep 0.1; done
+$ rotz show foo
+bar
+baz
+qux
+$ rm -f -- rotz.tcb serve.pid
+$
+
+## serve_01.tst ends here
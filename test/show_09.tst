@@ -0,0 +1,16 @@
+## -*- shell-script -*-
+
+$ rm -f -- rotz.tcb
+$ rotz add xxx pic_01.jpeg pic_02.jpeg
+$ rotz add sun pic_02.jpeg pic_03.jpeg
+$ rotz show --ids xxx sun
+2
+3
+3
+5
+$ rotz show --ids --pairs sun
+sun	3
+sun	5
+$ rm -f -- rotz.tcb
+
+## show_09.tst ends here
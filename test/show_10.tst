@@ -0,0 +1,26 @@
+## -*- shell-script -*-
+
+$ rm -f -- rotz.tcb
+$ rotz add sector:energy XOM CVX
+$ rotz add sector:tech AAPL MSFT XOM
+$ rotz add sector:fin JPM
+$ rotz add foo AAPL
+$ rotz show 'sector:*'
+XOM
+CVX
+AAPL
+MSFT
+JPM
+$ rotz show --intersection 'sector:*' foo
+AAPL
+$ rotz del <<EOF
+sector:fin
+EOF
+$ rotz show 'sector:*'
+XOM
+CVX
+AAPL
+MSFT
+$ rm -f -- rotz.tcb
+
+## show_10.tst ends here
@@ -0,0 +1,24 @@
+## -*- shell-script -*-
+
+$ rm -f -- rotz.tcb xchg.bin
+$ printf 'rotz\002\000\000\000\005\000\000\000\001\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000' | rotz import
+$ rotz add foo a b
+$ rotz show --ids foo
+4294967303
+4294967304
+$ rotz add bar b
+$ rotz show --ids bar
+4294967304
+$ rotz export --binary > xchg.bin
+$ rm -f -- rotz.tcb
+$ rotz import xchg.bin
+$ rotz show b
+foo
+bar
+$ rotz show --ids foo
+4294967303
+4294967304
+$ rm -f -- rotz.tcb xchg.bin
+$
+
+## wide_01.tst ends here